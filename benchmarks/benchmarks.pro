@@ -0,0 +1,11 @@
+build_qtopia {
+    message(Build benchmarks for Qtopia)
+    qtopia_project(subdirs)
+} else {
+    message(Build benchmarks for Qt or Qt/Embedded)
+    TEMPLATE = subdirs
+}
+
+SUBDIRS  = keyboard
+SUBDIRS += predictor
+SUBDIRS += replay
@@ -0,0 +1,538 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QApplication>
+#include <QGridLayout>
+#include <QKeyEvent>
+#include <QTouchEvent>
+#include <QPixmap>
+
+#include "qvirtualkeyboard.h"
+#include "qvirtualkey.h"
+#include "qvirtualkeyboardlayout_p.h"
+
+// One finger touching down on or lifting off a key of a touch trace
+struct TouchStep
+{
+    int id; ///< Touch point id
+    int key; ///< Index in BenchKeyboard::letterKeys, -1 for the shift key
+    bool pressed;
+};
+
+// Exposes the protected event generation, so that it can be measured without
+// the event delivery around it.
+class BenchVirtualKeyboard : public QVirtualKeyboard
+{
+public:
+    QKeyEvent generate(const QVirtualKey &vk, QKeyEvent::Type type) { return generateKeyEvent(vk, type); }
+};
+
+class BenchKeyboard : public QObject
+{
+    Q_OBJECT
+
+public:
+    BenchKeyboard();
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void keyPressLatency_data();
+    void keyPressLatency();
+    void generateKeyEvent_data();
+    void generateKeyEvent();
+    void keyBurst_data();
+    void keyBurst();
+    void setLayout_data();
+    void setLayout();
+    void paintEvent_data();
+    void paintEvent();
+    void hitTest_data();
+    void hitTest();
+    void touchRollover_data();
+    void touchRollover();
+
+    void countKeyEvent(QKeyEvent *event);
+
+private:
+    void addStateRows();
+    void enterState(const QString &state);
+    void leaveState(const QString &state);
+    QVirtualKey *addKey(const QString &name, Qt::Key key, const QString &text);
+    QStringList shippedLayouts() const;
+    QList<TouchStep> touchTrace(const QString &text, bool holdShift) const;
+    void replayTouches(const QList<TouchStep> &trace);
+
+    BenchVirtualKeyboard keyboard;
+    QWidget *container;
+    QWidget *layoutContainer;
+    QList<QVirtualKey *> letterKeys;
+    QVirtualKey *shiftKey;
+    QVirtualKey *altKey;
+    QVirtualKey *capsLockKey;
+    QVirtualKey *deadKey;
+    int keyEvents;
+};
+
+BenchKeyboard::BenchKeyboard()
+    : container(0)
+    , layoutContainer(0)
+    , shiftKey(0)
+    , altKey(0)
+    , capsLockKey(0)
+    , deadKey(0)
+    , keyEvents(0)
+{
+}
+
+QVirtualKey *BenchKeyboard::addKey(const QString &name, Qt::Key key, const QString &text)
+{
+    QVirtualKey *vk = new QVirtualKey(container, key, text);
+    vk->setObjectName(name);
+    vk->setAutoRepeat(false);
+    const int index = container->layout()->count();
+    static_cast<QGridLayout *>(container->layout())->addWidget(vk, index / 10, index % 10);
+    return vk;
+}
+
+void BenchKeyboard::initTestCase()
+{
+    // A small keyboard with letters, the modifiers and a dead key. The names do
+    // not clash with the keys of the shipped layouts.
+    container = new QWidget;
+    new QGridLayout(container);
+    for (int i = 0; i < 26; ++i) {
+        const QChar letter(QLatin1Char('a' + i));
+        QVirtualKey *vk = addKey(QLatin1String("bench_") + letter, Qt::Key(Qt::Key_A + i), letter);
+        vk->setAltKey(Qt::Key(Qt::Key_Agrave + i % 8));
+        letterKeys.append(vk);
+    }
+    shiftKey = addKey("bench_shift", Qt::Key_Shift, "Shift");
+    shiftKey->setCheckable(true);
+    altKey = addKey("bench_altgr", Qt::Key_AltGr, "AltGr");
+    altKey->setCheckable(true);
+    capsLockKey = addKey("bench_capslock", Qt::Key_CapsLock, "Caps");
+    capsLockKey->setCheckable(true);
+    deadKey = addKey("bench_acute", Qt::Key_Dead_Acute, QString(QChar(0x00b4)));
+    container->show();
+
+    // Every key named in one of the shipped layouts, for measuring setLayout()
+    layoutContainer = new QWidget;
+    QGridLayout *grid = new QGridLayout(layoutContainer);
+    QSet<QString> names;
+    foreach (const QString &fileName, shippedLayouts()) {
+        QVirtualKeyboardLayout layout;
+        QString errorString;
+        QVERIFY2(layout.load(fileName, &errorString), qPrintable(errorString));
+        foreach (const QVirtualKeyboardLayout::Entry &entry, layout.entries) {
+            if (names.contains(entry.name))
+                continue;
+            names.insert(entry.name);
+            QVirtualKey *vk = new QVirtualKey(layoutContainer);
+            vk->setObjectName(entry.name);
+            grid->addWidget(vk, grid->count() / 15, grid->count() % 15);
+        }
+    }
+    layoutContainer->show();
+
+    QVERIFY(keyboard.addKeyContainer(container));
+    QVERIFY(keyboard.addKeyContainer(layoutContainer));
+    connect(&keyboard, SIGNAL(keyEvent(QKeyEvent *)), this, SLOT(countKeyEvent(QKeyEvent *)));
+    QTest::qWaitForWindowShown(container);
+}
+
+void BenchKeyboard::cleanupTestCase()
+{
+    delete container;
+    delete layoutContainer;
+}
+
+void BenchKeyboard::countKeyEvent(QKeyEvent *)
+{
+    ++keyEvents;
+}
+
+QStringList BenchKeyboard::shippedLayouts() const
+{
+    return QStringList()
+        << QString(SRCDIR "../../examples/keypad/numbers.qvkm")
+        << QString(SRCDIR "../../examples/keypad/characters.qvkm")
+        << QString(SRCDIR "../../examples/en_US_Intl.qvkm");
+}
+
+void BenchKeyboard::addStateRows()
+{
+    QTest::addColumn<QString>("state");
+
+    QTest::newRow("plain") << QString("plain");
+    QTest::newRow("shift") << QString("shift");
+    QTest::newRow("altgr") << QString("altgr");
+    QTest::newRow("shift+altgr") << QString("shift+altgr");
+    QTest::newRow("capslock") << QString("capslock");
+    QTest::newRow("deadkey") << QString("deadkey");
+}
+
+// Latches the modifiers of a state by clicking the checkable modifier keys
+void BenchKeyboard::enterState(const QString &state)
+{
+    keyboard.setCapsLock(state == "capslock");
+    keyboard.setDeadKeys(state == "deadkey");
+    if (state.contains("shift"))
+        QTest::mouseClick(shiftKey, Qt::LeftButton);
+    if (state.contains("altgr"))
+        QTest::mouseClick(altKey, Qt::LeftButton);
+    if (state == "capslock")
+        QTest::mouseClick(capsLockKey, Qt::LeftButton);
+}
+
+void BenchKeyboard::leaveState(const QString &state)
+{
+    if (state.contains("shift"))
+        QTest::mouseClick(shiftKey, Qt::LeftButton);
+    if (state.contains("altgr"))
+        QTest::mouseClick(altKey, Qt::LeftButton);
+    if (state == "capslock")
+        QTest::mouseClick(capsLockKey, Qt::LeftButton);
+    keyboard.setCapsLock(true);
+    keyboard.setDeadKeys(true);
+}
+
+void BenchKeyboard::keyPressLatency_data()
+{
+    QTest::addColumn<int>("mode");
+
+    QTest::newRow("event filter") << int(QVirtualKeyboard::EventFilterDispatch);
+    QTest::newRow("direct") << int(QVirtualKeyboard::DirectDispatch);
+}
+
+// One mouse press and release of a key until both key events are emitted
+void BenchKeyboard::keyPressLatency()
+{
+    QFETCH(int, mode);
+
+    keyboard.setDispatchMode(QVirtualKeyboard::DispatchMode(mode));
+    QVirtualKey *vk = letterKeys.first();
+    keyEvents = 0;
+
+    QBENCHMARK {
+        QTest::mousePress(vk, Qt::LeftButton);
+        QTest::mouseRelease(vk, Qt::LeftButton);
+    }
+
+    QVERIFY(keyEvents > 0);
+    QCOMPARE(keyEvents % 2, 0);
+    keyboard.setDispatchMode(QVirtualKeyboard::EventFilterDispatch);
+}
+
+void BenchKeyboard::generateKeyEvent_data()
+{
+    addStateRows();
+}
+
+// The event generation alone, for the modifier, caps lock and dead key paths
+void BenchKeyboard::generateKeyEvent()
+{
+    QFETCH(QString, state);
+
+    enterState(state);
+    QBENCHMARK {
+        foreach (QVirtualKey *vk, letterKeys) {
+            if (state == "deadkey") {
+                keyboard.generate(*deadKey, QKeyEvent::KeyPress);
+                keyboard.generate(*deadKey, QKeyEvent::KeyRelease);
+            }
+            keyboard.generate(*vk, QKeyEvent::KeyPress);
+            keyboard.generate(*vk, QKeyEvent::KeyRelease);
+        }
+    }
+    leaveState(state);
+}
+
+void BenchKeyboard::keyBurst_data()
+{
+    addStateRows();
+}
+
+// A burst of presses over all letters through the whole pipeline
+void BenchKeyboard::keyBurst()
+{
+    QFETCH(QString, state);
+
+    enterState(state);
+    keyEvents = 0;
+    QBENCHMARK {
+        foreach (QVirtualKey *vk, letterKeys) {
+            if (state == "deadkey")
+                QTest::mouseClick(deadKey, Qt::LeftButton);
+            QTest::mouseClick(vk, Qt::LeftButton);
+        }
+    }
+    QVERIFY(keyEvents >= 2 * letterKeys.count());
+    leaveState(state);
+}
+
+void BenchKeyboard::setLayout_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<QString>("otherFileName");
+    QTest::addColumn<bool>("cold");
+
+    // Switching between two layouts, as applying the current layout again is
+    // almost free. Cold rows drop the parsed layout before every switch.
+    const QStringList layouts = shippedLayouts();
+    for (int i = 0; i < layouts.count(); ++i) {
+        const QString other = layouts.at((i + 1) % layouts.count());
+        const QByteArray name = QFileInfo(layouts.at(i)).fileName().toLatin1();
+        QTest::newRow((name + " cold").constData()) << layouts.at(i) << other << true;
+        QTest::newRow((name + " preloaded").constData()) << layouts.at(i) << other << false;
+    }
+}
+
+void BenchKeyboard::setLayout()
+{
+    QFETCH(QString, fileName);
+    QFETCH(QString, otherFileName);
+    QFETCH(bool, cold);
+
+    QVERIFY(keyboard.preloadLayout(otherFileName));
+    QVERIFY(keyboard.preloadLayout(fileName));
+
+    QBENCHMARK {
+        if (cold)
+            keyboard.unloadLayout(fileName);
+        keyboard.setLayout(fileName);
+        keyboard.setLayout(otherFileName);
+    }
+}
+
+void BenchKeyboard::paintEvent_data()
+{
+    QTest::addColumn<bool>("registered");
+    QTest::addColumn<bool>("relabel");
+
+    QTest::newRow("cached face") << true << false;
+    QTest::newRow("new label") << true << true;
+    QTest::newRow("no glyph cache") << false << true;
+}
+
+// Rendering one key, which calls its paintEvent()
+void BenchKeyboard::paintEvent()
+{
+    QFETCH(bool, registered);
+    QFETCH(bool, relabel);
+
+    QVirtualKey *vk = letterKeys.at(1);
+    QWidget *parent = vk->parentWidget();
+    if (!registered)
+        vk->setParent(0);
+
+    QPixmap pixmap(vk->size());
+    int label = 0;
+    QBENCHMARK {
+        if (relabel)
+            vk->setText(QString::number(++label % 100));
+        vk->render(&pixmap);
+    }
+
+    vk->setText("b");
+    if (!registered) {
+        vk->setParent(parent);
+        static_cast<QGridLayout *>(parent->layout())->addWidget(vk, 0, 1);
+        vk->show();
+    }
+}
+
+void BenchKeyboard::hitTest_data()
+{
+    QTest::addColumn<int>("method");
+
+    QTest::newRow("widget tree") << 0;
+    QTest::newRow("hit index") << 1;
+    QTest::newRow("linear nearest") << 2;
+}
+
+// Resolving 1024 points spread over the keys of all shipped layouts to a key,
+// with the widget tree (misses presses between keys), the keyboard's hit index
+// and a scan over all keys for the nearest one
+void BenchKeyboard::hitTest()
+{
+    QFETCH(int, method);
+
+    QList<QVirtualKey *> keys = layoutContainer->findChildren<QVirtualKey *>();
+    QVector<QRect> rects;
+    foreach (QVirtualKey *vk, keys)
+        rects.append(vk->geometry());
+
+    QVector<QPoint> points;
+    const QRect area = layoutContainer->rect();
+    for (int y = 0; y < 32; ++y) {
+        for (int x = 0; x < 32; ++x)
+            points.append(QPoint(area.left() + (2 * x + 1) * area.width() / 64, area.top() + (2 * y + 1) * area.height() / 64));
+    }
+
+    int hits = 0;
+    QBENCHMARK {
+        hits = 0;
+        foreach (const QPoint &point, points) {
+            QVirtualKey *vk = 0;
+            if (method == 0) {
+                vk = qobject_cast<QVirtualKey *>(layoutContainer->childAt(point));
+            } else if (method == 1) {
+                vk = keyboard.keyAt(layoutContainer, point);
+            } else {
+                int nearest = keyboard.hitRadius() * keyboard.hitRadius() + 1;
+                for (int i = 0; i < rects.count(); ++i) {
+                    const QRect &rect = rects.at(i);
+                    const int dx = qMax(0, qMax(rect.left() - point.x(), point.x() - rect.right()));
+                    const int dy = qMax(0, qMax(rect.top() - point.y(), point.y() - rect.bottom()));
+                    if (dx * dx + dy * dy < nearest) {
+                        nearest = dx * dx + dy * dy;
+                        vk = keys.at(i);
+                    }
+                }
+            }
+            if (vk)
+                ++hits;
+        }
+    }
+    QVERIFY(hits > 0);
+}
+
+// Two thumbs typing 'text' in turns, each pressing its next letter before the
+// other one lifts (rollover), optionally while a third finger holds shift
+QList<TouchStep> BenchKeyboard::touchTrace(const QString &text, bool holdShift) const
+{
+    QList<TouchStep> trace;
+    if (holdShift) {
+        const TouchStep press = { 3, -1, true };
+        trace.append(press);
+    }
+    int thumb = 1;
+    int down = -1;
+    foreach (const QChar &c, text) {
+        if (c < QLatin1Char('a') || c > QLatin1Char('z'))
+            continue;
+        const TouchStep press = { thumb, c.unicode() - 'a', true };
+        trace.append(press);
+        if (down >= 0) {
+            const TouchStep release = { 3 - thumb, down, false };
+            trace.append(release);
+        }
+        down = press.key;
+        thumb = 3 - thumb;
+    }
+    if (down >= 0) {
+        const TouchStep release = { 3 - thumb, down, false };
+        trace.append(release);
+    }
+    if (holdShift) {
+        // Lifting the finger latches the checkable shift key, a tap unlatches it
+        const TouchStep release = { 3, -1, false };
+        const TouchStep press = { 4, -1, true };
+        const TouchStep unlatch = { 4, -1, false };
+        trace << release << press << unlatch;
+    }
+    return trace;
+}
+
+// Sends the touch events of 'trace' to the letter container, every event lists
+// all touching fingers with only the finger of the step changing its state
+void BenchKeyboard::replayTouches(const QList<TouchStep> &trace)
+{
+    QMap<int, QPointF> touching;
+    foreach (const TouchStep &step, trace) {
+        QVirtualKey *vk = step.key < 0 ? shiftKey : letterKeys.at(step.key);
+        if (step.pressed)
+            touching.insert(step.id, vk->geometry().center());
+
+        QList<QTouchEvent::TouchPoint> points;
+        Qt::TouchPointStates states = 0;
+        for (QMap<int, QPointF>::const_iterator it = touching.constBegin(); it != touching.constEnd(); ++it) {
+            QTouchEvent::TouchPoint point(it.key());
+            Qt::TouchPointState state = Qt::TouchPointStationary;
+            if (it.key() == step.id)
+                state = step.pressed ? Qt::TouchPointPressed : Qt::TouchPointReleased;
+            point.setState(state);
+            point.setPos(it.value());
+            point.setScreenPos(container->mapToGlobal(it.value().toPoint()));
+            points.append(point);
+            states |= state;
+        }
+
+        QEvent::Type type = QEvent::TouchUpdate;
+        if (step.pressed && touching.count() == 1)
+            type = QEvent::TouchBegin;
+        else if (!step.pressed && touching.count() == 1)
+            type = QEvent::TouchEnd;
+        if (!step.pressed)
+            touching.remove(step.id);
+
+#if QT_VERSION >= 0x050000
+        QTouchEvent event(type, 0, Qt::NoModifier, states, points);
+#else
+        QTouchEvent event(type, QTouchEvent::TouchScreen, Qt::NoModifier, states, points);
+#endif
+        QApplication::sendEvent(container, &event);
+    }
+}
+
+void BenchKeyboard::touchRollover_data()
+{
+    QTest::addColumn<bool>("holdShift");
+
+    QTest::newRow("two thumbs") << false;
+    QTest::newRow("held shift") << true;
+}
+
+// Replaying a multi-finger typing trace, every letter has to be pressed and
+// released exactly once and no modifier may stay active
+void BenchKeyboard::touchRollover()
+{
+    QFETCH(bool, holdShift);
+
+    const QString text = QLatin1String("the quick brown fox jumps over the lazy dog ")
+                       + QLatin1String("pack my box with five dozen liquor jugs");
+    const QList<TouchStep> trace = touchTrace(text, holdShift);
+    int letters = 0;
+    foreach (const TouchStep &step, trace) {
+        if (step.pressed)
+            ++letters;
+    }
+
+    QBENCHMARK {
+        keyEvents = 0;
+        replayTouches(trace);
+    }
+
+    QCOMPARE(keyEvents, 2 * (letters - (holdShift ? 1 : 0)));
+    QCOMPARE(keyboard.keyboardModifiers(), Qt::KeyboardModifiers(Qt::NoModifier));
+    QVERIFY(!shiftKey->isChecked());
+    foreach (QVirtualKey *vk, letterKeys)
+        QVERIFY(!vk->isDown());
+}
+
+int main(int argc, char *argv[])
+{
+#if QT_VERSION >= 0x050000
+    // Run without a display unless a platform is requested explicitly
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+#endif
+    QApplication app(argc, argv);
+    BenchKeyboard bench;
+    return QTest::qExec(&bench, argc, argv);
+}
+
+#include "bench_keyboard.moc"
@@ -0,0 +1,22 @@
+build_qtopia {
+    qtopia_project(stub)
+} else {
+    message(Build keyboard benchmark for Qt or Qt/Embedded)
+    TEMPLATE     = app
+    TARGET       = bench_keyboard
+    CONFIG      += console release
+    CONFIG      -= app_bundle
+    QT          += testlib
+    greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+    # The benchmark uses the private layout model to create the keys of the shipped layouts
+    INCLUDEPATH += ../../src/library
+    LIBS        += -L../../src/library -lqtvirtualkeyboard
+    DEFINES     += SRCDIR=\\\"$$PWD/\\\"
+
+    SOURCES     += bench_keyboard.cpp
+
+    # "make benchmark" writes the results as QTestLib XML for comparing releases
+    benchmark.commands = ./$$TARGET -xml -o $${TARGET}.xml
+    QMAKE_EXTRA_TARGETS += benchmark
+}
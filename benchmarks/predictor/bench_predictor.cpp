@@ -0,0 +1,195 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QTextStream>
+
+#include "qvirtualkeypredictor.h"
+
+static const int dictionaryWords = 200000;
+static const int latencyBudget = 1000; ///< Microseconds a lookup may take per keystroke
+static const int memoryBudget = 64; ///< Bytes the dictionary may map per word
+
+class BenchPredictor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void compileDictionary();
+    void loadDictionary();
+    void dictionaryMemory();
+    void complete_data();
+    void complete();
+    void keyStroke_data();
+    void keyStroke();
+    void worstCaseLatency();
+
+private:
+    QString wordListFile;
+    QString dictionaryFile;
+    QStringList words; ///< Generated words, most frequent first
+    QVirtualKeyPredictor predictor;
+};
+
+/*
+    Generates a word list of pronounceable words with frequencies following
+    Zipf's law, which branches similar to a natural language dictionary.
+*/
+void BenchPredictor::initTestCase()
+{
+    static const char * const consonants[] = { "b", "c", "d", "f", "g", "h", "k", "l", "m", "n", "p", "r", "s", "st", "t", "th", "v", "w" };
+    static const char * const vowels[] = { "a", "e", "i", "o", "u", "ea", "ou" };
+    const int consonantCount = sizeof(consonants) / sizeof(consonants[0]);
+    const int vowelCount = sizeof(vowels) / sizeof(vowels[0]);
+
+    qsrand(42);
+    QSet<QString> seen;
+    while (words.count() < dictionaryWords) {
+        QString word;
+        const int syllables = 1 + qrand() % 4;
+        for (int i = 0; i < syllables; ++i)
+            word += QLatin1String(consonants[qrand() % consonantCount]) + QLatin1String(vowels[qrand() % vowelCount]);
+        if (qrand() % 2)
+            word += QLatin1String(consonants[qrand() % consonantCount]);
+        if (!seen.contains(word)) {
+            seen.insert(word);
+            words.append(word);
+        }
+    }
+
+    wordListFile = QDir::temp().filePath("bench_predictor_words.txt");
+    dictionaryFile = QDir::temp().filePath("bench_predictor_words.qvkd");
+
+    QFile file(wordListFile);
+    QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text));
+    QTextStream stream(&file);
+    for (int i = 0; i < words.count(); ++i)
+        stream << words.at(i) << ' ' << 10000000 / (i + 1) << '\n';
+}
+
+void BenchPredictor::cleanupTestCase()
+{
+    predictor.unloadDictionary();
+    QFile::remove(wordListFile);
+    QFile::remove(dictionaryFile);
+}
+
+void BenchPredictor::compileDictionary()
+{
+    QBENCHMARK_ONCE {
+        QVERIFY(QVirtualKeyPredictor::compileDictionary(wordListFile, dictionaryFile));
+    }
+}
+
+void BenchPredictor::loadDictionary()
+{
+    QBENCHMARK {
+        QVERIFY(predictor.loadDictionary(dictionaryFile));
+    }
+    QCOMPARE(predictor.dictionaryWords(), dictionaryWords);
+}
+
+// Memory mapped by the dictionary, pages are only read as lookups touch them
+void BenchPredictor::dictionaryMemory()
+{
+    QVERIFY(predictor.dictionarySize() > 0);
+    qDebug("%d words, %d bytes mapped (%.1f bytes per word), %lld bytes word list",
+           predictor.dictionaryWords(), predictor.dictionarySize(),
+           qreal(predictor.dictionarySize()) / predictor.dictionaryWords(), QFileInfo(wordListFile).size());
+    QVERIFY(predictor.dictionarySize() < memoryBudget * predictor.dictionaryWords());
+}
+
+void BenchPredictor::complete_data()
+{
+    QTest::addColumn<QString>("prefix");
+
+    // Prefixes of a long, rare word, so that the search has to go deep
+    const QString word = words.at(words.count() / 2);
+    for (int length = 1; length <= qMin(6, word.length()); ++length)
+        QTest::newRow((QByteArray::number(length) + " letters").constData()) << word.left(length);
+    QTest::newRow("capitalized") << word.left(1).toUpper() + word.mid(1, 2);
+}
+
+void BenchPredictor::complete()
+{
+    QFETCH(QString, prefix);
+
+    QStringList candidates;
+    QBENCHMARK {
+        candidates = predictor.complete(prefix, predictor.maximumCandidates());
+    }
+    QVERIFY(!candidates.isEmpty());
+}
+
+void BenchPredictor::keyStroke_data()
+{
+    QTest::addColumn<QString>("word");
+
+    QTest::newRow("frequent") << words.at(10);
+    QTest::newRow("average") << words.at(words.count() / 2);
+    QTest::newRow("rare") << words.last();
+}
+
+// Typing a whole word through the key stream, one lookup per letter
+void BenchPredictor::keyStroke()
+{
+    QFETCH(QString, word);
+
+    QBENCHMARK {
+        for (int i = 0; i < word.length(); ++i)
+            predictor.processKey(Qt::Key_A, Qt::NoModifier, word.mid(i, 1));
+        predictor.processKey(Qt::Key_Space, Qt::NoModifier, QLatin1String(" "));
+    }
+}
+
+// Slowest lookup of all one and two letter prefixes, these have the most completions,
+// has to stay within the budget of a keystroke
+void BenchPredictor::worstCaseLatency()
+{
+#if QT_VERSION >= 0x040800
+    QStringList prefixes;
+    for (char a = 'a'; a <= 'z'; ++a) {
+        prefixes.append(QString(QLatin1Char(a)));
+        for (char b = 'a'; b <= 'z'; ++b)
+            prefixes.append(QString(QLatin1Char(a)) + QLatin1Char(b));
+    }
+
+    qint64 worst = 0;
+    QString worstPrefix;
+    QElapsedTimer timer;
+    foreach (const QString &prefix, prefixes) {
+        timer.start();
+        predictor.complete(prefix, predictor.maximumCandidates());
+        const qint64 elapsed = timer.nsecsElapsed() / 1000;
+        if (elapsed > worst) {
+            worst = elapsed;
+            worstPrefix = prefix;
+        }
+    }
+    qDebug("Slowest lookup: %lld us for '%s', time budget %d us",
+           worst, qPrintable(worstPrefix), predictor.timeBudget());
+    QTest::setBenchmarkResult(qreal(worst) / 1000, QTest::WalltimeMilliseconds);
+    QVERIFY2(worst < latencyBudget, qPrintable(QString("Slowest lookup took %1 us").arg(worst)));
+#endif
+}
+
+QTEST_APPLESS_MAIN(BenchPredictor)
+
+#include "bench_predictor.moc"
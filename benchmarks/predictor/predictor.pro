@@ -0,0 +1,19 @@
+build_qtopia {
+    qtopia_project(stub)
+} else {
+    message(Build predictor benchmark for Qt or Qt/Embedded)
+    TEMPLATE     = app
+    TARGET       = bench_predictor
+    CONFIG      += console release
+    CONFIG      -= app_bundle
+    QT          += testlib
+
+    INCLUDEPATH += ../../src/library
+    LIBS        += -L../../src/library -lqtvirtualkeyboard
+
+    SOURCES     += bench_predictor.cpp
+
+    # "make benchmark" writes the results as QTestLib XML for comparing releases
+    benchmark.commands = ./$$TARGET -xml -o $${TARGET}.xml
+    QMAKE_EXTRA_TARGETS += benchmark
+}
@@ -0,0 +1,188 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QGridLayout>
+#include <QKeyEvent>
+
+#include "qvirtualkeyboard.h"
+#include "qvirtualkey.h"
+#include "qvirtualkeyrecorder.h"
+#include "qvirtualkeyboardlayout_p.h"
+
+static const int sessionKeys = 5000;
+static const int recordBudget = 10; ///< Bytes the log may take per press or release
+
+class BenchReplay : public QObject
+{
+    Q_OBJECT
+
+public:
+    BenchReplay();
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void logSize();
+    void replay();
+    void replayLog_data();
+    void replayLog();
+    void compareGolden();
+
+    void countKeyEvent(QKeyEvent *event);
+
+private:
+    QVirtualKeyboard keyboard;
+    QVirtualKeyRecorder recorder;
+    QWidget *container;
+    QString layoutFile;
+    QString logFile;
+    QString goldenFile;
+    int keyEvents;
+    int recordedEvents; ///< Key events generated while the session was recorded
+};
+
+BenchReplay::BenchReplay()
+    : container(0)
+    , layoutFile(SRCDIR "../../examples/en_US_Intl.qvkm")
+    , keyEvents(0)
+    , recordedEvents(0)
+{
+}
+
+void BenchReplay::countKeyEvent(QKeyEvent *)
+{
+    ++keyEvents;
+}
+
+/*
+    Creates the keys of the shipped international layout and records a typing
+    session of clicks on random keys, which include the checkable modifiers.
+*/
+void BenchReplay::initTestCase()
+{
+    QVirtualKeyboardLayout layout;
+    QString errorString;
+    QVERIFY2(layout.load(layoutFile, &errorString), qPrintable(errorString));
+
+    container = new QWidget;
+    QGridLayout *grid = new QGridLayout(container);
+    QList<QVirtualKey *> keys;
+    foreach (const QVirtualKeyboardLayout::Entry &entry, layout.entries) {
+        QVirtualKey *vk = new QVirtualKey(container);
+        vk->setObjectName(entry.name);
+        vk->setAutoRepeat(false);
+        if (entry.bindings[0].key == Qt::Key_Shift || entry.bindings[0].key == Qt::Key_AltGr)
+            vk->setCheckable(true);
+        grid->addWidget(vk, grid->count() / 15, grid->count() % 15);
+        keys.append(vk);
+    }
+    container->show();
+
+    QVERIFY(keyboard.addKeyContainer(container));
+    QVERIFY(keyboard.setLayout(layoutFile));
+    recorder.setKeyboard(&keyboard);
+    connect(&keyboard, SIGNAL(keyEvent(QKeyEvent *)), this, SLOT(countKeyEvent(QKeyEvent *)));
+    QTest::qWaitForWindowShown(container);
+
+    logFile = QDir::temp().filePath("bench_replay.qvkr");
+    goldenFile = QDir::temp().filePath("bench_replay.golden");
+
+    qsrand(42);
+    keyEvents = 0;
+    QVERIFY(recorder.startRecording(logFile));
+    for (int i = 0; i < sessionKeys; ++i)
+        QTest::mouseClick(keys.at(qrand() % keys.count()), Qt::LeftButton);
+    recorder.stopRecording();
+    recordedEvents = keyEvents;
+    QVERIFY(recorder.recordedKeys() >= sessionKeys);
+}
+
+void BenchReplay::cleanupTestCase()
+{
+    recorder.setKeyboard(0);
+    delete container;
+    QFile::remove(logFile);
+    QFile::remove(goldenFile);
+}
+
+// Bytes of the log per recorded press or release, the log has to stay compact
+void BenchReplay::logSize()
+{
+    const qint64 size = QFileInfo(logFile).size();
+    QVERIFY(size > 0);
+    qDebug("%d presses and releases, %lld bytes log (%.1f bytes per press or release)",
+           recorder.recordedKeys(), size, qreal(size) / recorder.recordedKeys());
+    QVERIFY(size < qint64(recordBudget) * recorder.recordedKeys());
+}
+
+// A replay has to generate the same key events as the recorded session
+void BenchReplay::replay()
+{
+    QString errorString;
+    keyEvents = 0;
+    QVERIFY2(recorder.replay(logFile, QVirtualKeyRecorder::MaximumSpeedReplay, &errorString), qPrintable(errorString));
+    QCOMPARE(recorder.replayedKeys(), recorder.recordedKeys());
+    QCOMPARE(keyEvents, recordedEvents);
+    QCOMPARE(recorder.replayedEvents().count(), recordedEvents);
+}
+
+void BenchReplay::replayLog_data()
+{
+    QTest::addColumn<int>("batchInterval");
+
+    QTest::newRow("immediate delivery") << 0;
+    QTest::newRow("batched delivery") << 16;
+}
+
+// Throughput of the keyboard: replaying the whole session at maximum speed
+void BenchReplay::replayLog()
+{
+    QFETCH(int, batchInterval);
+
+    keyboard.setBatchInterval(batchInterval);
+    QBENCHMARK {
+        QVERIFY(recorder.replay(logFile));
+    }
+    keyboard.setBatchInterval(0);
+    QCOMPARE(recorder.replayedKeys(), recorder.recordedKeys());
+}
+
+// Replays are deterministic, so their events can be kept as golden file
+void BenchReplay::compareGolden()
+{
+    QVERIFY(recorder.replay(logFile));
+    QVERIFY(recorder.saveReplayedEvents(goldenFile));
+
+    QVERIFY(recorder.replay(logFile));
+    QString difference;
+    QVERIFY2(recorder.compareReplayedEvents(goldenFile, &difference), qPrintable(difference));
+}
+
+int main(int argc, char *argv[])
+{
+#if QT_VERSION >= 0x050000
+    // Run without a display unless a platform is requested explicitly
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+#endif
+    QApplication app(argc, argv);
+    BenchReplay bench;
+    return QTest::qExec(&bench, argc, argv);
+}
+
+#include "bench_replay.moc"
@@ -0,0 +1,22 @@
+build_qtopia {
+    qtopia_project(stub)
+} else {
+    message(Build replay benchmark for Qt or Qt/Embedded)
+    TEMPLATE     = app
+    TARGET       = bench_replay
+    CONFIG      += console release
+    CONFIG      -= app_bundle
+    QT          += testlib
+    greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+    # The benchmark uses the private layout model to create the keys of the shipped layout
+    INCLUDEPATH += ../../src/library
+    LIBS        += -L../../src/library -lqtvirtualkeyboard
+    DEFINES     += SRCDIR=\\\"$$PWD/\\\"
+
+    SOURCES     += bench_replay.cpp
+
+    # "make benchmark" writes the results as QTestLib XML for comparing releases
+    benchmark.commands = ./$$TARGET -xml -o $${TARGET}.xml
+    QMAKE_EXTRA_TARGETS += benchmark
+}
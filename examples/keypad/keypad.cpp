@@ -31,6 +31,11 @@ KeyPad::KeyPad(QWidget *parent)
     keyboard.setAutoShifting(false);
     connect(&keyboard, SIGNAL(keyEvent(QKeyEvent *)), this, SLOT(handleKeyEvent(QKeyEvent *)));
 
+    // Keep both layouts in memory, so that switching between them does not
+    // need to read and parse the layout files again.
+    keyboard.preloadLayout(":numbers.qvkm");
+    keyboard.preloadLayout(":characters.qvkm");
+
     // Set default keyboard layout map
     changeKeyboardLayout();
 }
@@ -10,4 +10,8 @@ build_qtopia {
     RESOURCES    += keypad.qrc
     HEADERS      += keypad.h
     SOURCES      += main.cpp keypad.cpp
+
+    # Validates the layouts against the virtual keys of the form: 'make check_layouts'
+    check_layouts.commands = $$OUT_PWD/../../src/qvkmc/qvkmc -c -u $$PWD/keypad.ui $$PWD/numbers.qvkm $$PWD/characters.qvkm
+    QMAKE_EXTRA_TARGETS += check_layouts
 }
@@ -9,13 +9,29 @@ build_qtopia {
 TARGET        = qtvirtualkeyboard
 CONFIG       += shared release
 DEFINES      += BUILD_QVK QT_NO_DEBUG_OUTPUT
+greaterThan(QT_MAJOR_VERSION, 4): QT += concurrent
 
 HEADERS       = qvirtualkeyboardglobal.h \
                 qvirtualkeyboard.h \
-                qvirtualkey.h
+                qvirtualkey.h \
+                qvirtualkeypredictor.h \
+                qvirtualkeyrecorder.h
 SOURCES       = qvirtualkeyboard.cpp \
                 qvirtualkey.cpp \
-                qvirtualkeyboardlayoutreader.cpp
+                qvirtualkeycomposer.cpp \
+                qvirtualkeymodifierstate.cpp \
+                qvirtualkeyglyphcache.cpp \
+                qvirtualkeyhitindex.cpp \
+                qvirtualkeyboardlayout.cpp \
+                qvirtualkeyboardlayoutreader.cpp \
+                qvirtualkeyboardinstrumentation.cpp \
+                qvirtualkeypredictor.cpp \
+                qvirtualkeyrecorder.cpp
+
+# NOTE: The latency instrumentation needs QElapsedTimer::nsecsElapsed() (Qt 4.8),
+#       add 'CONFIG += qvk_no_instrumentation' to compile it out completely.
+equals(QT_MAJOR_VERSION, 4):lessThan(QT_MINOR_VERSION, 8): CONFIG += qvk_no_instrumentation
+qvk_no_instrumentation: DEFINES += QVK_NO_INSTRUMENTATION
 
 build_qtopia {
     resolve_include()
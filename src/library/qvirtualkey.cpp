@@ -12,12 +12,16 @@
   ****************************************************************************/
 
 #include "qvirtualkey.h"
+#include "qvirtualkeyboard.h"
 
 #include <QPainter>
 #include <QStyleOptionButton>
 #include <QFontMetrics>
+#include <QAbstractEventDispatcher>
+#include <QSet>
 
 #include "qvirtualkey_p.h"
+#include "qvirtualkeyglyphcache_p.h"
 
 /*!
     \class QVirtualKey qvirtualkey.h
@@ -177,6 +181,8 @@ QVirtualKey::QVirtualKey(QWidget *parent, Qt::Key key, const QString &text, cons
 */
 QVirtualKey::~QVirtualKey()
 {
+    if (d->hitIndex)
+        d->hitIndex->invalidate();
     delete d;
 }
 
@@ -186,6 +192,7 @@ QVirtualKey::~QVirtualKey()
 void QVirtualKey::setKey(Qt::Key key)
 {
     d->key = key;
+    ++d->bindingRevision;
 }
 
 /*!
@@ -206,8 +213,7 @@ Qt::Key QVirtualKey::key() const
 void QVirtualKey::setShiftText(const QString &text)
 {
     d->shiftText = text;
-    update();
-    updateGeometry();
+    labelChanged(true);
 }
 
 /*
@@ -226,8 +232,9 @@ QString QVirtualKey::shiftText() const
 void QVirtualKey::setShiftIcon(const QIcon &icon)
 {
     d->shiftIcon = icon;
-    update();
-    updateGeometry();
+    d->shiftIconSource.clear();
+    d->iconFromFile &= ~2;
+    labelChanged(true);
 }
 
 /*!
@@ -235,6 +242,7 @@ void QVirtualKey::setShiftIcon(const QIcon &icon)
 */
 QIcon QVirtualKey::shiftIcon() const
 {
+    d->resolveIcon(&d->shiftIcon, &d->shiftIconSource);
     return d->shiftIcon;
 }
 
@@ -244,6 +252,7 @@ QIcon QVirtualKey::shiftIcon() const
 void QVirtualKey::setShiftKey(Qt::Key key)
 {
     d->shiftKey = key;
+    ++d->bindingRevision;
 }
 
 /*!
@@ -262,8 +271,7 @@ Qt::Key QVirtualKey::shiftKey() const
 void QVirtualKey::setAltText(const QString &text)
 {
     d->altText = text;
-    update();
-    updateGeometry();
+    labelChanged(true);
 }
 
 /*!
@@ -282,8 +290,9 @@ QString QVirtualKey::altText() const
 void QVirtualKey::setAltIcon(const QIcon &icon)
 {
     d->altIcon = icon;
-    update();
-    updateGeometry();
+    d->altIconSource.clear();
+    d->iconFromFile &= ~4;
+    labelChanged(true);
 }
 
 /*!
@@ -291,6 +300,7 @@ void QVirtualKey::setAltIcon(const QIcon &icon)
 */
 QIcon QVirtualKey::altIcon() const
 {
+    d->resolveIcon(&d->altIcon, &d->altIconSource);
     return d->altIcon;
 }
 
@@ -300,6 +310,7 @@ QIcon QVirtualKey::altIcon() const
 void QVirtualKey::setAltKey(Qt::Key key)
 {
     d->altKey = key;
+    ++d->bindingRevision;
 }
 
 /*!
@@ -318,8 +329,7 @@ Qt::Key QVirtualKey::altKey() const
 void QVirtualKey::setAltShiftText(const QString &text)
 {
     d->altShiftText = text;
-    update();
-    updateGeometry();
+    labelChanged(true);
 }
 
 /*!
@@ -338,8 +348,9 @@ QString QVirtualKey::altShiftText() const
 void QVirtualKey::setAltShiftIcon(const QIcon &icon)
 {
     d->altShiftIcon = icon;
-    update();
-    updateGeometry();
+    d->altShiftIconSource.clear();
+    d->iconFromFile &= ~8;
+    labelChanged(true);
 }
 
 /*!
@@ -347,6 +358,7 @@ void QVirtualKey::setAltShiftIcon(const QIcon &icon)
 */
 QIcon QVirtualKey::altShiftIcon() const
 {
+    d->resolveIcon(&d->altShiftIcon, &d->altShiftIconSource);
     return d->altShiftIcon;
 }
 
@@ -356,6 +368,7 @@ QIcon QVirtualKey::altShiftIcon() const
 void QVirtualKey::setAltShiftKey(Qt::Key key)
 {
     d->altShiftKey = key;
+    ++d->bindingRevision;
 }
 
 /*!
@@ -372,7 +385,7 @@ Qt::Key QVirtualKey::altShiftKey() const
 void QVirtualKey::setBackgroundBrush(const QBrush &brush)
 {
     d->backgroundBrush = brush;
-    update();
+    labelChanged(false);
 }
 
 /*!
@@ -389,7 +402,7 @@ QBrush QVirtualKey::backgroundBrush() const
 void QVirtualKey::setLayoutHint(LayoutHint layoutHint)
 {
     d->layoutHint = layoutHint;
-    update();
+    labelChanged(true);
 }
 
 /*!
@@ -406,7 +419,7 @@ QVirtualKey::LayoutHint QVirtualKey::layoutHint() const
 void QVirtualKey::setAlignmentHint(Qt::Alignment alignmentHint)
 {
     d->alignmentHint = alignmentHint;
-    update();
+    labelChanged(false);
 }
 
 /*!
@@ -417,9 +430,158 @@ Qt::Alignment QVirtualKey::alignmentHint() const
     return d->alignmentHint;
 }
 
-/*! \reimp */
+/*!
+    \brief Drops the cached faces and schedules a repaint, and a relayout if the
+           \a geometry may have changed.
+
+    While the owning virtual keyboard applies a layout, the repaint and relayout
+    requests are collected and handled once the whole layout is applied.
+*/
+void QVirtualKey::labelChanged(bool geometry)
+{
+    d->invalidateFaces();
+    if (geometry)
+        d->cachedSizeHint = QSize();
+
+    if (d->updatesDeferred) {
+        d->pendingUpdate = true;
+        d->pendingGeometryUpdate |= geometry;
+        return;
+    }
+    update();
+    if (geometry)
+        updateGeometry();
+}
+
+/*!
+    \brief Sets the icon of \a layer (0 to 3 for default, shift, alt and alt+shift)
+           to the image \a fileName, without loading the image yet.
+
+    The icons of the shift, alt and alt+shift layers are only created when they are
+    painted or queried, the icon of the default layer is created right away because
+    QAbstractButton owns it. All icons are shared by file name with other keys and
+    layouts, and images are decoded on first paint only.
+
+    Returns false without changing anything if the layer already shows \a fileName.
+*/
+bool QVirtualKey::setIconSource(int layer, const QString &fileName)
+{
+    if (layer < 0 || layer > 3)
+        return false;
+    if ((d->iconFromFile & (1 << layer)) && d->iconFiles[layer] == fileName
+            && (layer != 0 || icon().cacheKey() == d->iconKey))
+        return false;
+
+    switch (layer) {
+        case 0:
+            setIcon(fileName.isEmpty() ? QIcon() : QVirtualKeyGlyphCache::sharedIcon(fileName));
+            d->iconKey = icon().cacheKey();
+            break;
+        case 1:
+            d->shiftIcon = QIcon();
+            d->shiftIconSource = fileName;
+            break;
+        case 2:
+            d->altIcon = QIcon();
+            d->altIconSource = fileName;
+            break;
+        case 3:
+            d->altShiftIcon = QIcon();
+            d->altShiftIconSource = fileName;
+            break;
+    }
+    d->iconFiles[layer] = fileName;
+    d->iconFromFile |= 1 << layer;
+    if (layer != 0)
+        labelChanged(true);
+    return true;
+}
+
+/*!
+    \brief Binds \a layer (0 to 3 for default, shift, alt and alt+shift) to \a key
+           with the label \a text and the icon \a iconFile.
+
+    Only the properties which differ from the current ones are set, so unchanged
+    layers neither repaint nor relayout the key. Returns true if anything changed.
+*/
+bool QVirtualKey::setBinding(int layer, Qt::Key key, const QString &text, const QString &iconFile)
+{
+    bool changed = false;
+    switch (layer) {
+        case 0:
+            if (d->key != key) {
+                setKey(key);
+                changed = true;
+            }
+            if (this->text() != text) {
+                setText(text);
+                changed = true;
+            }
+            break;
+        case 1:
+            if (d->shiftKey != key) {
+                setShiftKey(key);
+                changed = true;
+            }
+            if (d->shiftText != text) {
+                setShiftText(text);
+                changed = true;
+            }
+            break;
+        case 2:
+            if (d->altKey != key) {
+                setAltKey(key);
+                changed = true;
+            }
+            if (d->altText != text) {
+                setAltText(text);
+                changed = true;
+            }
+            break;
+        case 3:
+            if (d->altShiftKey != key) {
+                setAltShiftKey(key);
+                changed = true;
+            }
+            if (d->altShiftText != text) {
+                setAltShiftText(text);
+                changed = true;
+            }
+            break;
+        default:
+            return false;
+    }
+    if (setIconSource(layer, iconFile))
+        changed = true;
+    return changed;
+}
+
+/*!
+    \brief Checks wether the text, icon or icon size of QAbstractButton changed since
+           the cached faces and size hint were computed and drops them if so.
+*/
+void QVirtualKey::checkButtonLabel() const
+{
+    if (d->labelText != text() || d->labelIconKey != icon().cacheKey() || d->labelIconSize != iconSize()) {
+        d->invalidateFaces();
+        d->cachedSizeHint = QSize();
+        d->labelText = text();
+        d->labelIconKey = icon().cacheKey();
+        d->labelIconSize = iconSize();
+    }
+}
+
+/*!
+    \reimp
+
+    The size hint is cached until a label, icon, the layout hint, font or style changes.
+*/
 QSize QVirtualKey::sizeHint() const
 {
+    checkButtonLabel();
+    if (d->cachedSizeHint.isValid())
+        return d->cachedSizeHint;
+
     ensurePolished();
     QFontMetrics fm = fontMetrics();
     QSize size(d->spacingHorizontal, d->spacingVertical);
@@ -436,17 +598,17 @@ QSize QVirtualKey::sizeHint() const
     else if (!text().isEmpty())
         defaultSize = fm.size(tf, text() + " ");
 
-    if (!d->shiftIcon.isNull())
+    if (d->hasShiftIcon())
         shiftSize = QSize(iconSize().width(), iconSize().height() + 2);
     else if (!d->shiftText.isEmpty())
         shiftSize = fm.size(tf, d->shiftText + " ");
 
-    if (!d->altIcon.isNull())
+    if (d->hasAltIcon())
         shiftSize = QSize(iconSize().width(), iconSize().height() + 2);
     else if (!d->altText.isEmpty())
         altSize = fm.size(tf, d->altText + " ");
 
-    if (!d->altShiftIcon.isNull())
+    if (d->hasAltShiftIcon())
         altShiftSize = QSize(iconSize().width(), iconSize().height() + 2);
     else if (!d->altShiftText.isEmpty())
         altShiftSize = fm.size(tf, d->altShiftText + " ");
@@ -496,6 +658,7 @@ QSize QVirtualKey::sizeHint() const
         size.setHeight(size.height() + d->spacingVertical);
     size.setHeight(size.height() + qMax(shiftSize.height(), altShiftSize.height()));
 
+    d->cachedSizeHint = size;
     return size;
 }
 
@@ -505,13 +668,118 @@ QSize QVirtualKey::minimumSizeHint() const
     return sizeHint();
 }
 
-/*! \reimp */
+/*
+    Returns the ids of the timers running for object.
+*/
+static QSet<int> registeredTimerIds(QObject *object)
+{
+    QSet<int> ids;
+    if (QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance(object->thread())) {
+        foreach (const QAbstractEventDispatcher::TimerInfo &timer, dispatcher->registeredTimers(object))
+#if QT_VERSION >= 0x050000
+            ids.insert(timer.timerId);
+#else
+            ids.insert(timer.first);
+#endif
+    }
+    return ids;
+}
+
+/*!
+    \reimp
+
+    While a virtual keyboard repeats the key, the repeat timer QAbstractButton
+    starts for a press is swallowed, so QAbstractButton::autoRepeat keeps its
+    value and the key does not repeat twice.
+*/
 bool QVirtualKey::event(QEvent *event)
 {
+    switch (event->type()) {
+        case QEvent::MouseButtonPress:
+        case QEvent::MouseButtonDblClick:
+        case QEvent::KeyPress:
+            if (d->repeatOwned && autoRepeat()) {
+                const QSet<int> timers = registeredTimerIds(this);
+                const bool result = QAbstractButton::event(event);
+                const QSet<int> started = registeredTimerIds(this) - timers;
+                if (started.count() == 1)
+                    d->buttonRepeatTimer = *started.constBegin();
+                return result;
+            }
+            break;
+        case QEvent::MouseButtonRelease:
+        case QEvent::KeyRelease:
+            // QAbstractButton stops the repeat timer, its id may be used by another timer next
+            d->buttonRepeatTimer = 0;
+            break;
+        case QEvent::Timer:
+            if (d->buttonRepeatTimer != 0 && static_cast<QTimerEvent *>(event)->timerId() == d->buttonRepeatTimer) {
+                if (d->repeatOwned && isDown())
+                    return true;
+                d->buttonRepeatTimer = 0;
+            }
+            break;
+        case QEvent::FontChange:
+        case QEvent::StyleChange:
+            d->cachedSizeHint = QSize();
+            d->invalidateFaces();
+            break;
+        case QEvent::PaletteChange:
+        case QEvent::LayoutDirectionChange:
+            d->invalidateFaces();
+            break;
+        case QEvent::Move:
+        case QEvent::Resize:
+        case QEvent::Show:
+        case QEvent::Hide:
+        case QEvent::ParentChange:
+            if (d->hitIndex)
+                d->hitIndex->invalidate();
+            break;
+        default:
+            break;
+    }
     return QAbstractButton::event(event);
 }
 
-/*! \reimp */
+/*!
+    \reimp
+    \brief Reports the press to the virtual keyboard if it uses QVirtualKeyboard::DirectDispatch.
+*/
+void QVirtualKey::mousePressEvent(QMouseEvent *event)
+{
+    if (d->keyboard && d->keyboard->isTouching()) {
+        event->ignore();
+        return;
+    }
+    if (d->keyboard)
+        d->keyboard->virtualKeyPressed(this);
+    QAbstractButton::mousePressEvent(event);
+}
+
+/*!
+    \reimp
+    \brief Reports the release to the virtual keyboard if it uses QVirtualKeyboard::DirectDispatch.
+*/
+void QVirtualKey::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (d->keyboard && d->keyboard->isTouching()) {
+        event->ignore();
+        return;
+    }
+    if (d->keyboard)
+        d->keyboard->virtualKeyReleased(this);
+    QAbstractButton::mouseReleaseEvent(event);
+}
+
+/*!
+    \reimp
+    \brief Paints the key face, which is cached as pixmap per visual state.
+
+    The cached faces are dropped whenever something affecting the appearance
+    changes (texts, icons, brush, font, palette, style or size), so pressing
+    and releasing a key usually just draws a cached pixmap.
+*/
 void QVirtualKey::paintEvent(QPaintEvent * /*event*/)
 {
     QPainter painter(this);
@@ -526,6 +794,42 @@ void QVirtualKey::paintEvent(QPaintEvent * /*event*/)
     if (!isChecked() && !isDown())
         button.state |= QStyle::State_Raised;
 
+    // Focus frames are painted directly, virtual keys usually don't take focus
+    if (button.state & QStyle::State_HasFocus) {
+        paintFace(&painter, button);
+        return;
+    }
+
+    // Text and icon of QAbstractButton can be changed without us noticing
+    checkButtonLabel();
+
+    int state = 0;
+    if (button.state & QStyle::State_Sunken)
+        state |= QVirtualKeyPrivate::SunkenFace;
+    if (button.state & QStyle::State_On)
+        state |= QVirtualKeyPrivate::CheckedFace;
+    if (!(button.state & QStyle::State_Enabled))
+        state |= QVirtualKeyPrivate::DisabledFace;
+    if (button.state & QStyle::State_MouseOver)
+        state |= QVirtualKeyPrivate::HoverFace;
+
+    QPixmap &face = d->faces[state];
+    if (face.isNull() || face.size() != size()) {
+        face = QPixmap(size());
+        face.fill(Qt::transparent);
+        QPainter facePainter(&face);
+        facePainter.initFrom(this);
+        paintFace(&facePainter, button);
+    }
+    painter.drawPixmap(0, 0, face);
+}
+
+/*!
+    \brief This helper method paints the panel and all key bindings for the
+           state described by \a button.
+*/
+void QVirtualKey::paintFace(QPainter *painter, const QStyleOptionButton &button)
+{
     QRect rect = style()->subElementRect(QStyle::SE_PushButtonContents, &button, this);
     QStyle::State bflags = button.state;
 
@@ -536,14 +840,14 @@ void QVirtualKey::paintEvent(QPaintEvent * /*event*/)
         tool.palette = button.palette;
         tool.palette.setBrush(QPalette::Button, d->backgroundBrush);
         tool.palette.setBrush(QPalette::Window, d->backgroundBrush);
-        style()->drawPrimitive(QStyle::PE_PanelButtonTool, &tool, &painter, this);
+        style()->drawPrimitive(QStyle::PE_PanelButtonTool, &tool, painter, this);
     }
 
     if (button.state & QStyle::State_HasFocus) {
         QStyleOptionFocusRect fr;
         fr.QStyleOption::operator=(button);
         fr.rect.adjust(3, 3, -3, -3);
-        style()->drawPrimitive(QStyle::PE_FrameFocusRect, &fr, &painter, this);
+        style()->drawPrimitive(QStyle::PE_FrameFocusRect, &fr, painter, this);
     }
 
     if (button.state & (QStyle::State_On | QStyle::State_Sunken))
@@ -578,31 +882,31 @@ void QVirtualKey::paintEvent(QPaintEvent * /*event*/)
         altShiftRect.setLeft(rect.left() + rect.width() / 2 + d->spacingHorizontal / 2);
 
     } else if (d->layoutHint == EconomicLayoutHint) {
-        if (!d->altShiftText.isNull() || !d->altShiftIcon.isNull()) {
+        if (!d->altShiftText.isNull() || d->hasAltShiftIcon()) {
             defaultRect.setRight(rect.left() + rect.width() / 2 - d->spacingHorizontal / 2);
             defaultRect.setTop(rect.top() + rect.height() / 2 + d->spacingVertical / 2);
         } else {
-            if (!d->altText.isNull() || !d->altIcon.isNull())
+            if (!d->altText.isNull() || d->hasAltIcon())
                 defaultRect.setRight(rect.left() + rect.width() / 2 - d->spacingHorizontal / 2);
-            if (!d->shiftText.isNull() || !d->shiftIcon.isNull())
+            if (!d->shiftText.isNull() || d->hasShiftIcon())
                 defaultRect.setTop(rect.top() + rect.height() / 2 + d->spacingVertical / 2);
         }
 
-        if (!d->altText.isNull() || !d->altIcon.isNull()) {
+        if (!d->altText.isNull() || d->hasAltIcon()) {
             shiftRect.setBottom(rect.top() + rect.height() / 2 - d->spacingVertical / 2);
             shiftRect.setRight(rect.left() + rect.width() / 2 - d->spacingHorizontal / 2);
         } else {
-            if (!d->altShiftText.isNull() || !d->altShiftIcon.isNull())
+            if (!d->altShiftText.isNull() || d->hasAltShiftIcon())
                 shiftRect.setRight(rect.left() + rect.width() / 2 - d->spacingHorizontal / 2);
             if (!text().isNull() || !icon().isNull())
                 shiftRect.setBottom(rect.top() + rect.height() / 2 - d->spacingVertical / 2);
         }
 
-        if (!d->shiftText.isNull() || !d->shiftIcon.isNull()) {
+        if (!d->shiftText.isNull() || d->hasShiftIcon()) {
             altRect.setTop(rect.top() + rect.height() / 2 + d->spacingVertical / 2);
             altRect.setLeft(rect.left() + rect.width() / 2 + d->spacingHorizontal / 2);
         } else {
-            if (!d->altShiftText.isNull() || !d->altShiftIcon.isNull())
+            if (!d->altShiftText.isNull() || d->hasAltShiftIcon())
                 altRect.setTop(rect.top() + rect.height() / 2 + d->spacingVertical / 2);
             if (!text().isNull() || !icon().isNull())
                 altRect.setLeft(rect.left() + rect.width() / 2 + d->spacingHorizontal / 2);
@@ -612,18 +916,18 @@ void QVirtualKey::paintEvent(QPaintEvent * /*event*/)
             altShiftRect.setBottom(rect.top() + rect.height() / 2 - d->spacingVertical / 2);
             altShiftRect.setLeft(rect.left() + rect.width() / 2 + d->spacingHorizontal / 2);
         } else {
-            if (!d->shiftText.isNull() || !d->shiftIcon.isNull())
+            if (!d->shiftText.isNull() || d->hasShiftIcon())
                 altShiftRect.setLeft(rect.left() + rect.width() / 2 + d->spacingHorizontal / 2);
-            if (!d->altText.isNull() || !d->altIcon.isNull())
+            if (!d->altText.isNull() || d->hasAltIcon())
                 altShiftRect.setBottom(rect.top() + rect.height() / 2 - d->spacingVertical / 2);
         }
     }
 
     // Draw all key binding
-    paintSubElement(&painter, shiftText(), shiftIcon(), shiftRect, tf, button.state);
-    paintSubElement(&painter, altText(), altIcon(), altRect, tf, button.state);
-    paintSubElement(&painter, text(), icon(), defaultRect, tf, button.state);
-    paintSubElement(&painter, altShiftText(), altShiftIcon(), altShiftRect, tf, button.state);
+    paintSubElement(painter, shiftText(), shiftIcon(), shiftRect, tf, button.state);
+    paintSubElement(painter, altText(), altIcon(), altRect, tf, button.state);
+    paintSubElement(painter, text(), icon(), defaultRect, tf, button.state);
+    paintSubElement(painter, altShiftText(), altShiftIcon(), altShiftRect, tf, button.state);
 }
 
 /*!
@@ -632,7 +936,12 @@ void QVirtualKey::paintEvent(QPaintEvent * /*event*/)
 void QVirtualKey::paintSubElement(QPainter *painter, const QString &text, const QIcon &icon, const QRect &rect, uint tf, QStyle::State state)
 {
     if (icon.isNull()) {        // Draw text if no icon present
-        style()->drawItemText(painter, rect, tf, palette(), (state & QStyle::State_Enabled), text, QPalette::ButtonText);
+        if (!d->glyphCache) {
+            style()->drawItemText(painter, rect, tf, palette(), (state & QStyle::State_Enabled), text, QPalette::ButtonText);
+        } else if (!text.isEmpty()) {
+            QPixmap pixmap = d->glyphCache->text(text, painter->font(), palette(), (state & QStyle::State_Enabled), style(), tf);
+            style()->drawItemPixmap(painter, rect, tf, pixmap);
+        }
     } else {                    // Draw icon, always preceedes text
         QIcon::Mode mode = state & QStyle::State_Enabled ? QIcon::Normal : QIcon::Disabled;
         if (mode == QIcon::Normal && state & QStyle::State_HasFocus)
@@ -641,7 +950,8 @@ void QVirtualKey::paintSubElement(QPainter *painter, const QString &text, const
         if (state & QStyle::State_On)
             st = QIcon::On;
 
-        QPixmap pixmap = icon.pixmap(iconSize(), mode, st);
+        QPixmap pixmap = d->glyphCache ? d->glyphCache->icon(icon, iconSize(), mode, st)
+                                       : icon.pixmap(iconSize(), mode, st);
         style()->drawItemPixmap(painter, rect, tf, pixmap);
     }
 }
@@ -19,6 +19,7 @@
 #include <QAbstractButton>
 #include <QStyle>
 
+class QStyleOptionButton;
 class QVirtualKeyPrivate;
 
 class Q_QVK_EXPORT QVirtualKey : public QAbstractButton
@@ -85,11 +86,21 @@ public:
 protected:
     bool event(QEvent *event);
     void paintEvent(QPaintEvent *event);
+    void mousePressEvent(QMouseEvent *event);
+    void mouseReleaseEvent(QMouseEvent *event);
 
 private:
+    void labelChanged(bool geometry);
+    bool setIconSource(int layer, const QString &fileName);
+    bool setBinding(int layer, Qt::Key key, const QString &text, const QString &iconFile);
+    void checkButtonLabel() const;
+    void paintFace(QPainter *painter, const QStyleOptionButton &button);
     void paintSubElement(QPainter *painter, const QString &text, const QIcon &icon, const QRect &rect, uint tf, QStyle::State state);
 
     QVirtualKeyPrivate *d;
+
+    friend class QVirtualKeyboard;
+    friend class QVirtualKeyboardPrivate;
 };
 
 #endif
@@ -14,8 +14,14 @@
 #include <QString>
 #include <QIcon>
 #include <QBrush>
+#include <QPixmap>
+#include <QSize>
 
 #include "qvirtualkey.h"
+#include "qvirtualkeyglyphcache_p.h"
+#include "qvirtualkeyhitindex_p.h"
+
+class QVirtualKeyboard;
 
 class QVirtualKeyPrivate
 {
@@ -29,20 +35,57 @@ public:
         , alignmentHint(Qt::AlignCenter | Qt::AlignAbsolute)
         , spacingHorizontal(2)
         , spacingVertical(2)
+        , labelIconKey(0)
+        , glyphCache(0)
+        , hitIndex(0)
+        , keyboard(0)
+        , keyId(-1)
+        , bindingRevision(0)
+        , iconKey(0)
+        , updatesDeferred(false)
+        , pendingUpdate(false)
+        , pendingGeometryUpdate(false)
+        , repeatOwned(false)
+        , buttonRepeatTimer(0)
+        , iconFromFile(0)
     {}
 
+    enum FaceState { SunkenFace = 0x1, CheckedFace = 0x2, DisabledFace = 0x4, HoverFace = 0x8, FaceStateCount = 0x10 };
+
+    // Creates a lazily set icon from its file name
+    void resolveIcon(QIcon *icon, QString *source)
+    {
+        if (!source->isEmpty()) {
+            *icon = QVirtualKeyGlyphCache::sharedIcon(*source);
+            source->clear();
+        }
+    }
+
+    bool hasShiftIcon() const { return !shiftIcon.isNull() || !shiftIconSource.isEmpty(); }
+    bool hasAltIcon() const { return !altIcon.isNull() || !altIconSource.isEmpty(); }
+    bool hasAltShiftIcon() const { return !altShiftIcon.isNull() || !altShiftIconSource.isEmpty(); }
+
+    void invalidateFaces()
+    {
+        for (int i = 0; i < FaceStateCount; ++i)
+            faces[i] = QPixmap();
+    }
+
     Qt::Key key;
 
     QString shiftText;
     QIcon shiftIcon;
+    QString shiftIconSource; ///< Image file of shiftIcon if it is not created yet
     Qt::Key shiftKey;
 
     QString altText;
     QIcon altIcon;
+    QString altIconSource; ///< Image file of altIcon if it is not created yet
     Qt::Key altKey;
 
     QString altShiftText;
     QIcon altShiftIcon;
+    QString altShiftIconSource; ///< Image file of altShiftIcon if it is not created yet
     Qt::Key altShiftKey;
 
     QBrush backgroundBrush;
@@ -52,4 +95,25 @@ public:
 
     const int spacingHorizontal;
     const int spacingVertical;
+
+    QPixmap faces[FaceStateCount]; ///< Rendered key faces by FaceState combination
+    QSize cachedSizeHint; ///< Invalid if the size hint needs to be computed
+    QString labelText; ///< Text the cached faces and size hint were computed with
+    qint64 labelIconKey; ///< Icon the cached faces and size hint were computed with
+    QSize labelIconSize; ///< Icon size the cached faces and size hint were computed with
+
+    QVirtualKeyGlyphCache *glyphCache; ///< Label cache of the virtual keyboard, if any
+    QVirtualKeyHitIndex *hitIndex; ///< Hit index of the virtual keyboard to invalidate on geometry changes, if any
+    QVirtualKeyboard *keyboard; ///< Virtual keyboard to report presses to directly, if any
+    int keyId; ///< Index in the key table of the virtual keyboard, -1 if not registered
+    int bindingRevision; ///< Incremented when a key code changes
+    QString iconFiles[4]; ///< Image files set with setIconSource(), by layer
+    qint64 iconKey; ///< Cache key of the default icon set with setIconSource()
+
+    uint updatesDeferred : 1; ///< Set while the virtual keyboard applies a layout
+    uint pendingUpdate : 1; ///< Repaint requested while updates were deferred
+    uint pendingGeometryUpdate : 1; ///< Relayout requested while updates were deferred
+    uint repeatOwned : 1; ///< Set while a virtual keyboard repeats the key
+    uint iconFromFile : 4; ///< Bit per layer, set while its icon is the one of iconFiles
+    int buttonRepeatTimer; ///< Repeat timer QAbstractButton started for the current press, 0 if none
 };
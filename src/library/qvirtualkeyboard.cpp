@@ -13,14 +13,28 @@
 
 #include "qvirtualkeyboard.h"
 #include "qvirtualkey.h"
-#include "qvirtualkeyboardlayoutreader.h"
+#include "qvirtualkeyboardlayout_p.h"
+#include "qvirtualkeymodifierstate_p.h"
 
 #include <QEvent>
+#include <QTimerEvent>
 #include <QChildEvent>
-#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QIcon>
 #include <QMetaEnum>
+#include <QMouseEvent>
+#if QT_VERSION >= 0x040600
+#  include <QTouchEvent>
+#endif
+#include <QCoreApplication>
+#include <QDataStream>
 #include <QDebug>
+#ifndef QT_NO_CONCURRENT
+#  include <QtConcurrentRun>
+#endif
 
+#include "qvirtualkey_p.h"
 #include "qvirtualkeyboard_p.h"
 
 /*!
@@ -39,6 +53,10 @@
     All virtual key press and release events are handled by the virtual keyboard, direct
     interaction with the virtual keys is undesired and thus impossible.
 
+    The QKeyEvent passed with the keyEvent() signal is owned by the virtual keyboard and
+    only valid during the signal emission. Receivers which want to keep the event have
+    to copy it, connections to keyEvent() thus can not be queued.
+
     \sa QVirtualKey, QKeyEvent
 */
 
@@ -118,6 +136,106 @@
     This property is enabled by default.
 */
 
+/*!
+    \enum QVirtualKeyboard::DispatchMode
+
+    This enum describes how presses and releases of virtual keys reach the virtual keyboard.
+
+    \value EventFilterDispatch The virtual keyboard installs itself as event filter on
+           every registered virtual key. This sees all events of the keys.
+    \value DirectDispatch Registered virtual keys report presses and releases directly
+           to the virtual keyboard, no event filter is installed on them.
+*/
+
+/*!
+    \enum QVirtualKeyboard::LatencyStage
+
+    This enum describes the measured parts of the dispatch of a virtual key press or release.
+
+    \value GenerateLatency From the press or release arriving until the key event is generated.
+    \value KeyEventLatency Time spent in the receivers of the keyEvent() signal.
+    \value KeySignalLatency Time spent in the receivers of keyPressed() or keyReleased().
+    \value TotalLatency From the press or release arriving until all signals returned.
+    \value LatencyStageCount Number of stages.
+
+    \sa setInstrumentationEnabled()
+*/
+
+/*!
+    \fn void QVirtualKeyboard::keyEventBatch(const QList<QKeyEvent> &events)
+
+    This signal is emitted with all key \a events of a batch when batched delivery
+    is enabled. While this signal is connected, the events of a batch are not
+    emitted one by one with keyEvent(), keyPressed() and keyReleased() as well,
+    so a receiver handles every key once and pays the signal overhead once per
+    batch. Without a connection to this signal, batched events are emitted one
+    by one.
+
+    \sa setBatchInterval()
+*/
+
+/*!
+    \property QVirtualKeyboard::autoRepeatDelay
+    \brief Time in milliseconds a virtual key has to be held until it repeats.
+
+    This property is 300 by default.
+*/
+
+/*!
+    \property QVirtualKeyboard::autoRepeatInterval
+    \brief Time in milliseconds between the first repetitions of a held virtual key.
+
+    This property is 100 by default.
+*/
+
+/*!
+    \property QVirtualKeyboard::batchInterval
+    \brief Time in milliseconds generated key events are queued before they are sent.
+
+    This property is 0 by default, which disables batched delivery.
+*/
+
+/*!
+    \property QVirtualKeyboard::batchSize
+    \brief Maximum number of key events queued in batched delivery.
+
+    This property is 32 by default.
+*/
+
+/*!
+    \enum QVirtualKeyboard::ModifierMode
+
+    This enum describes when a modifier is active.
+
+    \value MomentaryModifier The modifier is active while one of its virtual keys is pressed.
+    \value LatchingModifier Like MomentaryModifier, but pressing and releasing the modifier
+           without other keys in between keeps it active for the next key press. Doing so
+           again locks the modifier until it is pressed a third time.
+    \value LockingModifier Each press toggles the modifier, like caps lock on physical keyboards.
+
+    \sa addModifier()
+*/
+
+/*!
+    \fn void QVirtualKeyboard::modifiersChanged()
+
+    This signal is emitted when a modifier becomes active or inactive.
+
+    \sa isModifierActive()
+*/
+
+/*!
+    \property QVirtualKeyboard::dispatchMode
+    \brief Controls how the registered virtual keys report presses and releases.
+
+    With DirectDispatch, only the mouse presses and releases of the virtual keys reach
+    the virtual keyboard, each with a single function call. Other events of the virtual
+    keys are no longer passed through the event filter of the virtual keyboard. Key
+    containers are watched by an event filter in both modes.
+
+    This property is set to EventFilterDispatch by default.
+*/
+
 /*!
     \brief Construct a virtual keyboard with no registered keys and a \a parent.
 */
@@ -135,6 +253,9 @@ QVirtualKeyboard::~QVirtualKeyboard()
     foreach (QObject *object, d->virtualKeyHash.keys())
         removeKeyContainer(object);
 
+#ifndef QVK_NO_INSTRUMENTATION
+    delete d->instrumentation;
+#endif
     delete d;
 }
 
@@ -157,8 +278,9 @@ bool QVirtualKeyboard::addKeyContainer(QObject *object)
         //FIXME: Check if newKey already has 'this' as eventFilter, which could happen
         //       when the user registers first a container and then it's parent container
         if (!keys.contains(newKey)) {
-            newKey->installEventFilter(this);
+            registerKey(newKey);
             keys.append(newKey);
+            d->indexVirtualKey(newKey);
         }
     }
     d->virtualKeyHash.insert(object, keys);
@@ -166,6 +288,11 @@ bool QVirtualKeyboard::addKeyContainer(QObject *object)
     // Watch the object for added/removed child objects which could be virtual keys.
     // This also applies for the case the the container is actually a virtual key.
     object->installEventFilter(this);
+#if QT_VERSION >= 0x040600
+    // Touch points on the keys propagate to the container, which tracks them all
+    if (object->isWidgetType() && !qobject_cast<QVirtualKey *>(object))
+        static_cast<QWidget *>(object)->setAttribute(Qt::WA_AcceptTouchEvents);
+#endif
     return true;
 }
 
@@ -181,512 +308,2226 @@ void QVirtualKeyboard::removeKeyContainer(QObject *object)
 
     // Remove event filter from all watched virtual keys and unregister the container
     if (d->virtualKeyHash.contains(object)) {
+        releaseTouchPoints(object);
         object->removeEventFilter(this);
-        foreach (QVirtualKey *key,  d->virtualKeyHash.value(object))
-            key->removeEventFilter(this);
+        foreach (QVirtualKey *key,  d->virtualKeyHash.value(object)) {
+            unregisterKey(key);
+            d->unindexVirtualKey(key);
+        }
         d->virtualKeyHash.remove(object);
+        d->hitIndex.remove(object);
+        if (d->redirectContainer == object) {
+            d->redirectedKey = 0;
+            d->redirectContainer = 0;
+        }
     }
 }
 
 /*!
-    \brief Configure which key (modifier) is used to trigger the shifted virtual key code.
-
-    You can basically use every key except the key which is already set as alternative
-    modifier.
+    \internal
+    \brief Starts handling the events of the virtual \a key and lets it use the
+           glyph cache of this keyboard.
+*/
+void QVirtualKeyboard::registerKey(QVirtualKey *key)
+{
+    // The virtual keyboard repeats held keys itself, with a single timer
+    d->assignKeyId(key);
+    key->d->repeatOwned = true;
+
+    if (d->dispatchMode == DirectDispatch)
+        key->d->keyboard = this;
+    else
+        key->installEventFilter(this);
+    if (key->d->glyphCache != &d->glyphCache) {
+        key->d->glyphCache = &d->glyphCache;
+        key->d->invalidateFaces();
+    }
+    key->d->hitIndex = &d->hitIndex;
+    d->hitIndex.invalidate();
+
+    // Keys nested below a container are deleted without a ChildRemoved event on it
+    disconnect(key, SIGNAL(destroyed(QObject *)), this, SLOT(virtualKeyDestroyed(QObject *)));
+    connect(key, SIGNAL(destroyed(QObject *)), this, SLOT(virtualKeyDestroyed(QObject *)));
+#if QT_VERSION >= 0x050000
+    disconnect(key, SIGNAL(objectNameChanged(QString)), this, SLOT(virtualKeyRenamed()));
+    connect(key, SIGNAL(objectNameChanged(QString)), this, SLOT(virtualKeyRenamed()));
+#endif
+}
 
-    \sa QVirtualKey
+/*!
+    \internal
+    \brief Stops handling the events of the virtual \a key.
 */
-void QVirtualKeyboard::setShiftModifier(Qt::Key modifierKey)
+void QVirtualKeyboard::unregisterKey(QVirtualKey *key)
 {
-    d->shiftModifier = modifierKey;
+    stopAutoRepeat(key);
+    d->releaseKeyId(key);
+    key->d->repeatOwned = false;
+
+    key->removeEventFilter(this);
+    disconnect(key, SIGNAL(destroyed(QObject *)), this, SLOT(virtualKeyDestroyed(QObject *)));
+#if QT_VERSION >= 0x050000
+    disconnect(key, SIGNAL(objectNameChanged(QString)), this, SLOT(virtualKeyRenamed()));
+#endif
+    if (key->d->keyboard == this)
+        key->d->keyboard = 0;
+    if (key->d->glyphCache == &d->glyphCache) {
+        key->d->glyphCache = 0;
+        key->d->invalidateFaces();
+    }
+    if (key->d->hitIndex == &d->hitIndex)
+        key->d->hitIndex = 0;
+    d->hitIndex.invalidate();
 }
 
 /*!
-    \brief Returns the 'shift' modifier value.
+    \internal
+    \brief Forgets the registered virtual key \a object, which is being deleted.
+
+    Only the address of \a object is used, its QVirtualKey part is already destroyed.
 */
-Qt::Key QVirtualKeyboard::shiftModifier() const
+void QVirtualKeyboard::virtualKeyDestroyed(QObject *object)
 {
-    return d->shiftModifier;
+    QHash<QObject *, QList<QVirtualKey *> >::iterator it;
+    for (it = d->virtualKeyHash.begin(); it != d->virtualKeyHash.end(); ++it) {
+        QList<QVirtualKey *> &keys = it.value();
+        for (int i = keys.count() - 1; i >= 0; --i) {
+            if (static_cast<QObject *>(keys.at(i)) == object) {
+                keys.removeAt(i);
+                d->unindexVirtualKey(object);
+            }
+        }
+    }
+
+    for (int i = d->repeatingKeys.count() - 1; i >= 0; --i) {
+        if (static_cast<QObject *>(d->repeatingKeys.at(i).key) == object)
+            d->repeatingKeys.removeAt(i);
+    }
+    scheduleAutoRepeat();
+
+    for (int id = 0; id < d->keyTable.count(); ++id) {
+        if (static_cast<const QObject *>(d->keyTable.at(id).key) == object) {
+            d->keyTable[id] = QVirtualKeyboardPrivate::KeyTableEntry();
+            d->freeKeyIds.append(id);
+        }
+    }
+    d->hitIndex.invalidate();
 }
 
 /*!
-    \brief Configure which key (modifier) is used to trigger the alternative virtual key code.
+    \internal
+    \brief Indexes the registered virtual key which sent the signal under its new object name.
+*/
+void QVirtualKeyboard::virtualKeyRenamed()
+{
+    if (QVirtualKey *key = qobject_cast<QVirtualKey *>(sender()))
+        d->reindexVirtualKey(key);
+}
 
-    You can basically use every key except the key which is already set as shift
-    modifier.
+/*!
+    \brief Changes how presses and releases of the registered virtual keys reach the
+           virtual keyboard to \a mode.
 
-    \sa altModifier, altModifier()
+    \sa dispatchMode
 */
-void QVirtualKeyboard::setAltModifier(Qt::Key modifierKey)
+void QVirtualKeyboard::setDispatchMode(DispatchMode mode)
 {
-    d->altModifier = modifierKey;
+    if (d->dispatchMode == mode)
+        return;
+    d->dispatchMode = mode;
+
+    foreach (const QList<QVirtualKey *> &keys, d->virtualKeyHash) {
+        foreach (QVirtualKey *key, keys) {
+            if (mode == DirectDispatch) {
+                key->removeEventFilter(this);
+                key->d->keyboard = this;
+            } else {
+                if (key->d->keyboard == this)
+                    key->d->keyboard = 0;
+                key->installEventFilter(this);
+            }
+        }
+    }
 }
 
 /*!
-    \brief Returns the current \i altModifier.
+    \brief Returns how the registered virtual keys report presses and releases.
 
-    \sa altModifier, setAltModifier()
+    \sa dispatchMode
 */
-Qt::Key QVirtualKeyboard::altModifier() const
+QVirtualKeyboard::DispatchMode QVirtualKeyboard::dispatchMode() const
 {
-    return d->altModifier;
+    return d->dispatchMode;
 }
 
 /*!
-    \brief Converts a normal Qt::Key to the corresponding Qt::KeyboardModier.
+    \brief Enables or disables the latency instrumentation if \a enabled.
 
-    \sa Qt::KeyboardModifier, Qt::Key
+    If enabled, the virtual keyboard measures for every press and release of a
+    virtual key how long it takes to generate the key event, how long the
+    receivers of keyEvent() and of keyPressed() or keyReleased() take and the
+    total time from the press arriving until the last signal returned. The
+    latencies are kept in histograms per layout and per key name, see
+    latencyPercentile() and dumpInstrumentation(). Disabling the instrumentation
+    drops all samples.
+
+    The instrumentation is disabled by default. If the library is built with
+    \c QVK_NO_INSTRUMENTATION defined, it is compiled out and cannot be enabled.
+
+    \sa LatencyStage
 */
-Qt::KeyboardModifier QVirtualKeyboard::keyToKeyboardModifier(Qt::Key key)
+void QVirtualKeyboard::setInstrumentationEnabled(bool enabled)
 {
-    switch (key) {
-        case Qt::Key_Shift: return Qt::ShiftModifier;
-        case Qt::Key_Control: return Qt::ControlModifier;
-        case Qt::Key_Alt: return Qt::AltModifier;
-        case Qt::Key_Meta: return Qt::MetaModifier;
-        default: return Qt::NoModifier;
+#ifndef QVK_NO_INSTRUMENTATION
+    if (enabled && !d->instrumentation) {
+        d->instrumentation = new QVirtualKeyboardInstrumentation;
+    } else if (!enabled) {
+        delete d->instrumentation;
+        d->instrumentation = 0;
     }
+#else
+    if (enabled)
+        qWarning() << "QVirtualKeyboard::setInstrumentationEnabled(" << enabled << ") Instrumentation is compiled out";
+#endif
 }
 
 /*!
-    \brief Set wether character keys are shifted automatically.
+    \brief Returns true if the latency instrumentation is enabled.
 
-    \sa autoShifting, autoShifting()
+    \sa setInstrumentationEnabled()
 */
-void QVirtualKeyboard::setAutoShifting(bool enabled)
+bool QVirtualKeyboard::instrumentationEnabled() const
 {
-    d->autoShifting= enabled;
+#ifndef QVK_NO_INSTRUMENTATION
+    return d->instrumentation != 0;
+#else
+    return false;
+#endif
 }
 
 /*!
-    \brief Returns the auto-shifting behavior setting.
+    \brief Returns the \a percent percentile of the latencies of \a stage in microseconds.
 
-    \sa autoShifting, setAutoShifting()
+    Only presses and releases of the virtual key named \a key while the layout named
+    \a layout was set are considered, an empty string considers all keys or layouts.
+    The returned value is the upper bound of the histogram bucket, which is at most
+    25% above the measured latency. Returns -1 if there are no samples.
+
+    \sa latencySamples(), setInstrumentationEnabled()
 */
-bool QVirtualKeyboard::autoShifting() const
+qint64 QVirtualKeyboard::latencyPercentile(LatencyStage stage, int percent, const QString &key, const QString &layout) const
 {
-    return d->autoShifting;
+#ifndef QVK_NO_INSTRUMENTATION
+    if (!d->instrumentation || stage < 0 || stage >= LatencyStageCount)
+        return -1;
+    int buckets[QVirtualKeyLatencyHistogram::BucketCount] = { 0 };
+    d->instrumentation->collect(stage, key, layout, buckets);
+    return QVirtualKeyLatencyHistogram::percentile(buckets, percent);
+#else
+    Q_UNUSED(stage);
+    Q_UNUSED(percent);
+    Q_UNUSED(key);
+    Q_UNUSED(layout);
+    return -1;
+#endif
 }
 
 /*!
-    \brief Set dead key behavior.
+    \brief Returns the number of measured presses and releases of the virtual key
+           named \a key while the layout named \a layout was set.
 
-    \sa deadKeys, deadKeys()
+    An empty string counts all keys or layouts.
+
+    \sa latencyPercentile()
 */
-void QVirtualKeyboard::setDeadKeys(bool enabled)
+int QVirtualKeyboard::latencySamples(const QString &key, const QString &layout) const
 {
-    d->deadKeys= enabled;
+#ifndef QVK_NO_INSTRUMENTATION
+    if (!d->instrumentation)
+        return 0;
+    int buckets[QVirtualKeyLatencyHistogram::BucketCount] = { 0 };
+    d->instrumentation->collect(TotalLatency, key, layout, buckets);
+    int samples = 0;
+    for (int i = 0; i < QVirtualKeyLatencyHistogram::BucketCount; ++i)
+        samples += buckets[i];
+    return samples;
+#else
+    Q_UNUSED(key);
+    Q_UNUSED(layout);
+    return 0;
+#endif
 }
 
 /*!
-    \brief Returns the dead-keys behavior setting.
+    \brief Writes the measured latencies to \a fileName.
 
-    \sa deadKeys, setDeadKeys()
+    The file is a tab separated table with a header line and one line per layout
+    and virtual key, holding the number of presses and releases and p50, p95 and
+    p99 in microseconds of every LatencyStage. Returns false if the instrumentation
+    is disabled or the file cannot be written.
 */
-bool QVirtualKeyboard::deadKeys() const
+bool QVirtualKeyboard::dumpInstrumentation(const QString &fileName) const
 {
-    return d->deadKeys;
+#ifndef QVK_NO_INSTRUMENTATION
+    if (!d->instrumentation)
+        return false;
+    if (!d->instrumentation->dump(fileName)) {
+        qWarning() << "QVirtualKeyboard::dumpInstrumentation(" << fileName << ") Cannot write file";
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(fileName);
+    return false;
+#endif
 }
 
 /*!
-    \brief Checks wether the given \a key is a dead key.
+    \brief Drops all measured latencies, the instrumentation stays enabled.
 */
-bool QVirtualKeyboard::isDeadKey(Qt::Key key)
+void QVirtualKeyboard::resetInstrumentation()
 {
-    switch (key) {
-        case Qt::Key_Dead_Grave:
-        case Qt::Key_Dead_Acute:
-        case Qt::Key_Dead_Circumflex:
-        case Qt::Key_Dead_Tilde:
-        case Qt::Key_Dead_Macron:
-        case Qt::Key_Dead_Breve:
-        case Qt::Key_Dead_Abovedot:
-        case Qt::Key_Dead_Diaeresis:
-        case Qt::Key_Dead_Abovering:
-        case Qt::Key_Dead_Doubleacute:
-        case Qt::Key_Dead_Caron:
-        case Qt::Key_Dead_Cedilla:
-        case Qt::Key_Dead_Ogonek:
-        case Qt::Key_Dead_Iota:
-        case Qt::Key_Dead_Voiced_Sound:
-        case Qt::Key_Dead_Semivoiced_Sound:
-        case Qt::Key_Dead_Belowdot:
-        case Qt::Key_Dead_Hook:
-        case Qt::Key_Dead_Horn: return true;
-        default: return false;
-    }
+#ifndef QVK_NO_INSTRUMENTATION
+    if (d->instrumentation)
+        d->instrumentation->reset();
+#endif
 }
 
 /*!
-    \brief Converts a dead key into the undead equivalent if possible.
+    \brief Sets the time a virtual key has to be held until it repeats to \a msecs.
 
-    Not all dead keys have an "undead" representation (for example the
-    \a cedil makes only sense together with \a C to be the \a &Ccedil;
+    The virtual keyboard repeats all held virtual keys with the
+    QAbstractButton::autoRepeat property enabled, using a single timer. The
+    repeated key presses are sent as release and press with the autorepeat flag
+    set and carry the modifiers which were active when the key was pressed. The
+    default delay is 300 milliseconds.
 
-    \sa deadKeys, Qt::Key
+    QAbstractButton::autoRepeat of a registered virtual key can be changed at any
+    time and applies from the next press, QAbstractButton's own repetition of the
+    key is suppressed meanwhile.
+
+    \sa setAutoRepeatInterval(), setAutoRepeatAcceleration()
 */
-Qt::Key QVirtualKeyboard::deadKeyToUndeadKey(Qt::Key key)
+void QVirtualKeyboard::setAutoRepeatDelay(int msecs)
 {
-    Qt::Key ret = Qt::Key_unknown;
-    switch (key) {
-        case Qt::Key_Dead_Grave: break;
-        case Qt::Key_Dead_Acute: ret = Qt::Key_acute; break;
-        case Qt::Key_Dead_Circumflex: ret = Qt::Key_AsciiCircum; break;
-        case Qt::Key_Dead_Tilde: ret = Qt::Key_AsciiTilde; break;
-        case Qt::Key_Dead_Macron: ret = Qt::Key_macron; break;
-        case Qt::Key_Dead_Breve: break;
-        case Qt::Key_Dead_Abovedot: break;
-        case Qt::Key_Dead_Diaeresis: ret = Qt::Key_diaeresis; break;
-        case Qt::Key_Dead_Abovering: break;
-        case Qt::Key_Dead_Doubleacute: break;
-        case Qt::Key_Dead_Caron: break;
-        case Qt::Key_Dead_Cedilla: ret = Qt::Key_cedilla; break;
-        case Qt::Key_Dead_Ogonek: break;
-        case Qt::Key_Dead_Iota: break;
-        case Qt::Key_Dead_Voiced_Sound: break;
-        case Qt::Key_Dead_Semivoiced_Sound: break;
-        case Qt::Key_Dead_Belowdot: break;
-        case Qt::Key_Dead_Hook: break;
-        case Qt::Key_Dead_Horn: break;
-        default: break; // To avoid compile-time errors
-    }
-    return ret;
-}
-
-/*!
-    \brief Combines two distinct keys into one if possible.
-
-    This is useful if the user pressed a dead key and afterwards a key
-    which he wants to be combined with the former.
-
-    \sa deadKeys, Qt::Key
-*/
-Qt::Key QVirtualKeyboard::combineKeys(Qt::Key key1, Qt::Key key2)
-{
-    // Sanity check, we can not combine two dead keys or two normal keys
-    // Note: The latter might change in the future if useful cases are found.
-    if (isDeadKey(key1) && isDeadKey(key2) || !isDeadKey(key1) && !isDeadKey(key2))
-        return Qt::Key_unknown;
-
-    Qt::Key deadKey = isDeadKey(key1) ? key1 : key2;
-    Qt::Key normKey = isDeadKey(key1) ? key2 : key1;
-    Qt::Key ret = Qt::Key_unknown;
+    d->autoRepeatDelay = qMax(0, msecs);
+}
 
-    switch (deadKey) {
-        case Qt::Key_Dead_Grave:
-            switch (normKey) {
-                case Qt::Key_A: ret = Qt::Key_Agrave; break;
-                case Qt::Key_E: ret = Qt::Key_Egrave; break;
-                case Qt::Key_I: ret = Qt::Key_Igrave; break;
-                case Qt::Key_O: ret = Qt::Key_Ograve; break;
-                case Qt::Key_U: ret = Qt::Key_Ugrave; break;
-                default: break; // To avoid compile-time errors
-            }
-            break;
-        case Qt::Key_Dead_Acute:
-            switch (normKey) {
-                case Qt::Key_A: ret = Qt::Key_Aacute; break;
-                case Qt::Key_E: ret = Qt::Key_Eacute; break;
-                case Qt::Key_I: ret = Qt::Key_Iacute; break;
-                case Qt::Key_O: ret = Qt::Key_Oacute; break;
-                case Qt::Key_U: ret = Qt::Key_Uacute; break;
-                case Qt::Key_Y: ret = Qt::Key_Yacute; break;
-                default: break; // To avoid compile-time errors
-            }
-            break;
-        case Qt::Key_Dead_Circumflex:
-            switch (normKey) {
-                case Qt::Key_A: ret = Qt::Key_Acircumflex; break;
-                case Qt::Key_E: ret = Qt::Key_Ecircumflex; break;
-                case Qt::Key_I: ret = Qt::Key_Icircumflex; break;
-                case Qt::Key_O: ret = Qt::Key_Ocircumflex; break;
-                case Qt::Key_U: ret = Qt::Key_Ucircumflex; break;
-                default: break; // To avoid compile-time errors
-            }
-            break;
-        case Qt::Key_Dead_Tilde:
-            switch (normKey) {
-                case Qt::Key_A: ret = Qt::Key_Atilde; break;
-                case Qt::Key_N: ret = Qt::Key_Ntilde; break;
-                case Qt::Key_O: ret = Qt::Key_Otilde; break;
-                default: break; // To avoid compile-time errors
-            }
-            break;
-        case Qt::Key_Dead_Macron:
-            break;
-        case Qt::Key_Dead_Breve:
-            break;
-        case Qt::Key_Dead_Abovedot:
-            break;
-        case Qt::Key_Dead_Diaeresis:
-            switch (normKey) {
-                case Qt::Key_A: ret = Qt::Key_Adiaeresis; break;
-                case Qt::Key_E: ret = Qt::Key_Ediaeresis; break;
-                case Qt::Key_I: ret = Qt::Key_Idiaeresis; break;
-                case Qt::Key_O: ret = Qt::Key_Odiaeresis; break;
-                case Qt::Key_U: ret = Qt::Key_Udiaeresis; break;
-                case Qt::Key_Y: ret = Qt::Key_ydiaeresis; break;
-                default: break; // To avoid compile-time errors
-            }
-            break;
-        case Qt::Key_Dead_Abovering:
-            if (normKey == Qt::Key_A)
-                ret = Qt::Key_Aring;
-            break;
-        case Qt::Key_Dead_Doubleacute:
-            break;
-        case Qt::Key_Dead_Caron:
-            break;
-        case Qt::Key_Dead_Cedilla:
-            if (normKey == Qt::Key_C)
-                ret = Qt::Key_Ccedilla;
-            break;
-        case Qt::Key_Dead_Ogonek:
-            break;
-        case Qt::Key_Dead_Iota:
-            break;
-        case Qt::Key_Dead_Voiced_Sound:
-            break;
-        case Qt::Key_Dead_Semivoiced_Sound:
-            break;
-        case Qt::Key_Dead_Belowdot:
-            break;
-        case Qt::Key_Dead_Hook:
-            break;
-        case Qt::Key_Dead_Horn:
-            break;
-        default: break; // To avoid compile-time errors
-    }
-    return ret;
+/*!
+    \brief Returns the time in milliseconds until a held virtual key repeats.
+*/
+int QVirtualKeyboard::autoRepeatDelay() const
+{
+    return d->autoRepeatDelay;
 }
 
 /*!
-    \brief Set capslock behavior.
+    \brief Sets the time between the first repetitions of a held virtual key to \a msecs.
 
-    \sa capsLock, capsLock()
+    The default interval is 100 milliseconds.
+
+    \sa setAutoRepeatAcceleration()
 */
-void QVirtualKeyboard::setCapsLock(bool enabled)
+void QVirtualKeyboard::setAutoRepeatInterval(int msecs)
 {
-    d->capsLock = enabled;
+    d->autoRepeatInterval = qMax(1, msecs);
 }
 
 /*!
-    \brief Returns the state of capslock behavior.
-
-    \sa capsLock, setCapsLock()
+    \brief Returns the time in milliseconds between the first repetitions of a held key.
 */
-bool QVirtualKeyboard::capsLock() const
+int QVirtualKeyboard::autoRepeatInterval() const
 {
-    return d->capsLock;
+    return d->autoRepeatInterval;
 }
 
 /*!
-    \brief Loads a new keyboard layout and changes it.
+    \brief Multiplies the repeat interval with \a factor after every repetition
+           until it reaches \a minimumInterval milliseconds.
 
-    A virtual keyboard layout XML file is parsed and the virtual
-    keyboard tries to match and update all registered virtual keys that
-    are found in the layout file. If a virtual key is not described in
-    the layout XML file with \a fileName it won't be changed at all.
-    Non-critical errors in the XML file (wrong structure, unknown
-    elements, ...) are gently ignored with a warning printed on stdout;
+    A \a factor below 1.0 makes held keys repeat faster and faster, the default
+    factor 1.0 keeps the interval constant.
 
-    \sa QVirtualKeyboardLayoutReader
+    \sa setAutoRepeatInterval()
 */
-bool QVirtualKeyboard::setLayout(const QString &fileName)
+void QVirtualKeyboard::setAutoRepeatAcceleration(qreal factor, int minimumInterval)
 {
-    if (fileName.isEmpty())
-        return false;
-
-    QFile file(fileName);
+    d->autoRepeatAcceleration = qMax(qreal(0.0), factor);
+    d->autoRepeatMinimumInterval = qMax(1, minimumInterval);
+}
 
-    if (file.open(QFile::ReadOnly | QFile::Text)) {
-        QVirtualKeyboardLayoutReader reader(this);
-        if (!reader.read(&file)) {
-            qWarning() << "QVirtualKeyboard::setLayout(" << fileName << ")" << reader.errorString();
-            return false;
-        } else
-            return true;
-    } else {
-        qWarning() << "QVirtualKeyboard::setLayout(" << fileName << ") Unable to find keyboard layout!";
-        return false;
-    }
+/*!
+    \brief Returns the factor the repeat interval is multiplied with after every repetition.
+*/
+qreal QVirtualKeyboard::autoRepeatAcceleration() const
+{
+    return d->autoRepeatAcceleration;
 }
 
 /*!
-    \brief Set the current keyboard layout \a version.
+    \brief Returns the shortest repeat interval in milliseconds reached by acceleration.
+*/
+int QVirtualKeyboard::autoRepeatMinimumInterval() const
+{
+    return d->autoRepeatMinimumInterval;
+}
 
-    This is just informational and can be used by GUI's.
+/*!
+    \brief Queues generated key events for up to \a msecs milliseconds before
+           sending them, 0 sends every key event immediately.
+
+    If the receiver of the key events is slow (for example a large text edit or
+    a QWS server connection), the overhead per event dominates during fast typing.
+    With batched delivery the virtual keyboard collects the generated key events
+    and sends them together, either when the interval elapsed since the first
+    queued event, when batchSize events are queued or when flushKeyEvents() is
+    called. Changing the interval sends all queued events. The events are sent
+    with keyEventBatch() if it is connected, otherwise one by one.
+
+    \sa flushKeyEvents(), keyEventBatch()
 */
-void QVirtualKeyboard::setLayoutVersion(int version)
+void QVirtualKeyboard::setBatchInterval(int msecs)
 {
-    d->keyboardLayoutVersion = version;
+    flushKeyEvents();
+    d->batchInterval = qMax(0, msecs);
 }
 
 /*!
-    \brief Retrieve the current keyboard layout version number.
+    \brief Returns the interval of batched delivery in milliseconds, 0 if disabled.
 
-    This is just informational and can be used by GUI's.
+    \sa setBatchInterval()
 */
-int QVirtualKeyboard::layoutVersion() const
+int QVirtualKeyboard::batchInterval() const
 {
-    return d->keyboardLayoutVersion;
+    return d->batchInterval;
 }
 
 /*!
-    \brief Set the current keyboard layout \a name.
+    \brief Sends the queued key events as soon as \a events are queued.
 
-    This is just informational and can be used by GUI's.
+    The default is 32 key events.
+
+    \sa setBatchInterval()
 */
-void QVirtualKeyboard::setLayoutName(const QString &name)
+void QVirtualKeyboard::setBatchSize(int events)
 {
-    d->keyboardLayoutName = name;
+    d->batchSize = qMax(1, events);
+    if (d->pendingKeyEvents.count() >= d->batchSize)
+        flushKeyEvents();
 }
 
 /*!
-    \brief Retrieve the current keyboard layout name.
+    \brief Returns the number of key events which are queued at most.
 
-    This is just informational and can be used by GUI's.
+    \sa setBatchSize()
 */
-const QString QVirtualKeyboard::layoutName() const
+int QVirtualKeyboard::batchSize() const
 {
-    return d->keyboardLayoutName;
+    return d->batchSize;
 }
 
 /*!
-    \brief Find a virtual key child object with \a name within all key
-           containers registered with this virtual keyboard.
+    \brief Sets the memory limit of the glyph cache to \a kilobytes.
 
-    \sa QObject::findChild
+    All virtual keys registered with this keyboard render their labels (texts
+    and icons) through a shared glyph cache, so each distinct label is only
+    rasterized once per font, palette, state and size. If the limit is exceeded,
+    the least recently used labels are dropped. The default limit is 512 kilobytes.
+
+    \sa glyphCacheSize(), glyphCacheHits(), glyphCacheMisses()
 */
-QVirtualKey *QVirtualKeyboard::findVirtualKey(const QString &name) const
+void QVirtualKeyboard::setGlyphCacheLimit(int kilobytes)
 {
-    foreach (QObject *object, d->virtualKeyHash.keys()) {
-        QVirtualKey *key = object->findChild<QVirtualKey *>(name);
-        if (key)
-            return key;
-    }
-    qWarning() << "QVirtualKeyboard::findVirtualKey(" << name << ") Unable to find virtual key!";
-    return 0;
+    d->glyphCache.setMaxCost(kilobytes * 1024);
 }
 
 /*!
-    \brief Tries to convert \a string describing a key to a Qt::Key.
+    \brief Returns the memory limit of the glyph cache in kilobytes.
+
+    \sa setGlyphCacheLimit()
 */
-Qt::Key QVirtualKeyboard::stringToKey(const QString &string)
+int QVirtualKeyboard::glyphCacheLimit() const
 {
-    // Qt's magic in undocumented features rocks. Find the QMetaEnum of Qt::Key to
-    // easily get the enum value of a string representation that value.
-    int index =  QObject::staticQtMetaObject.indexOfEnumerator("Key");
-    QMetaEnum me = QObject::staticQtMetaObject.enumerator(index);
-    int key = me.keyToValue(string.toLatin1());
-
-    if (key >= 0) {
-        return (Qt::Key)key;
-    } else {
-        qWarning() << "QVirtualKeyboard::stringToKey() Unable to convert" << string << "to key, using Qt::Key_unknown";
-        return Qt::Key_unknown;
-    }
+    return d->glyphCache.maxCost() / 1024;
 }
 
 /*!
-    \reimp
-    \brief This event filter is transparent, some events are modified but none are filtered
+    \brief Returns the memory currently used by the glyph cache in kilobytes.
+
+    \sa setGlyphCacheLimit()
 */
-bool QVirtualKeyboard::eventFilter(QObject *object, QEvent *event)
+int QVirtualKeyboard::glyphCacheSize() const
 {
-    if (event->type() == QEvent::ChildAdded) {
-        QChildEvent *ce = static_cast<QChildEvent *>(event);
-        // Install event filter for added virtual key children
-        if(qobject_cast<QVirtualKey *>(ce->child()))
-            ce->child()->installEventFilter(this);
+    return d->glyphCache.totalCost() / 1024;
+}
 
-    } else if (event->type() == QEvent::ChildRemoved) {
+/*!
+    \brief Returns how often a label was found in the glyph cache.
+
+    \sa glyphCacheMisses(), clearGlyphCache()
+*/
+int QVirtualKeyboard::glyphCacheHits() const
+{
+    return d->glyphCache.hits;
+}
+
+/*!
+    \brief Returns how often a label had to be rasterized.
+
+    \sa glyphCacheHits(), clearGlyphCache()
+*/
+int QVirtualKeyboard::glyphCacheMisses() const
+{
+    return d->glyphCache.misses;
+}
+
+/*!
+    \brief Drops all cached labels and resets the glyph cache statistics.
+
+    \sa setGlyphCacheLimit()
+*/
+void QVirtualKeyboard::clearGlyphCache()
+{
+    d->glyphCache.clear();
+}
+
+/*!
+    \brief Configure which key (modifier) is used to trigger the shifted virtual key code.
+
+    You can basically use every key except the key which is already set as alternative
+    modifier.
+
+    \sa QVirtualKey
+*/
+void QVirtualKeyboard::setShiftModifier(Qt::Key modifierKey)
+{
+    d->modifierState.setKey(QVirtualKeyModifierState::ShiftIndex, modifierKey);
+    d->invalidateKeyTable();
+    if (d->recorder)
+        d->recorder->recordState();
+}
+
+/*!
+    \brief Returns the 'shift' modifier value.
+*/
+Qt::Key QVirtualKeyboard::shiftModifier() const
+{
+    return d->modifierState.key(QVirtualKeyModifierState::ShiftIndex);
+}
+
+/*!
+    \brief Configure which key (modifier) is used to trigger the alternative virtual key code.
+
+    You can basically use every key except the key which is already set as shift
+    modifier.
+
+    \sa altModifier, altModifier()
+*/
+void QVirtualKeyboard::setAltModifier(Qt::Key modifierKey)
+{
+    d->modifierState.setKey(QVirtualKeyModifierState::AltIndex, modifierKey);
+    d->invalidateKeyTable();
+    if (d->recorder)
+        d->recorder->recordState();
+}
+
+/*!
+    \brief Returns the current \i altModifier.
+
+    \sa altModifier, setAltModifier()
+*/
+Qt::Key QVirtualKeyboard::altModifier() const
+{
+    return d->modifierState.key(QVirtualKeyModifierState::AltIndex);
+}
+
+/*!
+    \brief Adds \a key as modifier with \a mode, or changes the mode of an existing modifier.
+
+    Besides the 'shift' and 'alt' modifiers, which select the layer of the virtual
+    keys, up to six more modifiers like Qt::Key_Control or a 'Fn' or 'Symbol' key
+    can be added. Virtual keys of a modifier generate no key code. While a modifier
+    is active, its Qt::KeyboardModifier (if it is one of Shift, Control, Alt or Meta)
+    is sent with the generated key events, all modifiers can be queried with
+    isModifierActive(), for example to switch layouts on a 'Symbol' modifier.
+
+    The mode also applies to the 'shift' and 'alt' modifiers. Latching and locking
+    modifiers are meant for non-checkable virtual keys, checkable keys already lock
+    a momentary modifier while they are checked.
+
+    Returns false if all eight modifiers are used.
+
+    \sa ModifierMode, removeModifier(), modifiersChanged()
+*/
+bool QVirtualKeyboard::addModifier(Qt::Key key, ModifierMode mode)
+{
+    const uint previousModifiers = d->modifierState.activeMask();
+    int index = d->modifierState.indexOf(key);
+    if (index >= 0) {
+        d->modifierState.setMode(index, mode);
+    } else if ((index = d->modifierState.add(key, mode)) < 0) {
+        qWarning() << "QVirtualKeyboard::addModifier(" << keyToString(key) << ") Too many modifiers";
+        return false;
+    }
+    d->invalidateKeyTable();
+
+    // The recorder records the state on modifiersChanged() by itself
+    if (d->modifierState.activeMask() != previousModifiers)
+        emit modifiersChanged();
+    else if (d->recorder)
+        d->recorder->recordState();
+    return true;
+}
+
+/*!
+    \brief Removes the modifier \a key added with addModifier().
+
+    The 'shift' and 'alt' modifiers cannot be removed, use setShiftModifier() and
+    setAltModifier() to change them.
+*/
+void QVirtualKeyboard::removeModifier(Qt::Key key)
+{
+    const int index = d->modifierState.indexOf(key);
+    if (index <= QVirtualKeyModifierState::AltIndex) {
+        if (index >= 0)
+            qWarning() << "QVirtualKeyboard::removeModifier(" << keyToString(key) << ") Cannot remove the shift or alt modifier";
+        return;
+    }
+
+    const bool active = d->modifierState.isActive(index);
+    d->modifierState.remove(index);
+    d->invalidateKeyTable();
+    if (active)
+        emit modifiersChanged();
+    else if (d->recorder)
+        d->recorder->recordState();
+}
+
+/*!
+    \brief Returns the keys of all modifiers, the 'shift' and 'alt' modifiers first.
+*/
+QList<Qt::Key> QVirtualKeyboard::modifierKeys() const
+{
+    QList<Qt::Key> keys;
+    for (int i = 0; i < d->modifierState.count(); ++i)
+        keys.append(d->modifierState.key(i));
+    return keys;
+}
+
+/*!
+    \brief Returns the mode of the modifier \a key, MomentaryModifier if \a key is no modifier.
+*/
+QVirtualKeyboard::ModifierMode QVirtualKeyboard::modifierMode(Qt::Key key) const
+{
+    const int index = d->modifierState.indexOf(key);
+    return index >= 0 ? d->modifierState.mode(index) : MomentaryModifier;
+}
+
+/*!
+    \brief Returns true if the modifier \a key is pressed, latched, locked or held by caps lock.
+
+    \sa isModifierLocked(), modifiersChanged()
+*/
+bool QVirtualKeyboard::isModifierActive(Qt::Key key) const
+{
+    const int index = d->modifierState.indexOf(key);
+    return index >= 0 && d->modifierState.isActive(index);
+}
+
+/*!
+    \brief Returns true if the modifier \a key stays active after its keys are
+           released, because it is latched or locked.
+*/
+bool QVirtualKeyboard::isModifierLocked(Qt::Key key) const
+{
+    const int index = d->modifierState.indexOf(key);
+    return index >= 0 && d->modifierState.isLocked(index);
+}
+
+/*!
+    \brief Returns the Qt::KeyboardModifiers sent with the next generated key event.
+*/
+Qt::KeyboardModifiers QVirtualKeyboard::keyboardModifiers() const
+{
+    d->updateModifierFlags();
+    return d->modifierFlags[d->modifierState.activeMask()] | d->rememberedStandardModifiers;
+}
+
+/*!
+    \brief Releases all modifiers, including latched and locked ones.
+
+    Checkable virtual keys of modifiers keep their checked state, so this is
+    meant for keyboards using latching or locking modifiers.
+*/
+void QVirtualKeyboard::resetModifiers()
+{
+    const uint previousModifiers = d->modifierState.activeMask();
+    d->modifierState.reset();
+    d->rememberedStandardModifiers = Qt::NoModifier;
+    if (previousModifiers)
+        emit modifiersChanged();
+}
+
+/*!
+    \brief Converts a normal Qt::Key to the corresponding Qt::KeyboardModier.
+
+    \sa Qt::KeyboardModifier, Qt::Key
+*/
+Qt::KeyboardModifier QVirtualKeyboard::keyToKeyboardModifier(Qt::Key key)
+{
+    return QVirtualKeyboardPrivate::keyToKeyboardModifier(key);
+}
+
+/*!
+    \brief Set wether character keys are shifted automatically.
+
+    \sa autoShifting, autoShifting()
+*/
+void QVirtualKeyboard::setAutoShifting(bool enabled)
+{
+    d->autoShifting= enabled;
+    d->invalidateKeyTable();
+    if (d->recorder)
+        d->recorder->recordState();
+}
+
+/*!
+    \brief Returns the auto-shifting behavior setting.
+
+    \sa autoShifting, setAutoShifting()
+*/
+bool QVirtualKeyboard::autoShifting() const
+{
+    return d->autoShifting;
+}
+
+/*!
+    \brief Set dead key behavior.
+
+    \sa deadKeys, deadKeys()
+*/
+void QVirtualKeyboard::setDeadKeys(bool enabled)
+{
+    d->deadKeys= enabled;
+    if (d->recorder)
+        d->recorder->recordState();
+}
+
+/*!
+    \brief Returns the dead-keys behavior setting.
+
+    \sa deadKeys, setDeadKeys()
+*/
+bool QVirtualKeyboard::deadKeys() const
+{
+    return d->deadKeys;
+}
+
+/*!
+    \brief Checks wether the given \a key is a dead key.
+*/
+bool QVirtualKeyboard::isDeadKey(Qt::Key key)
+{
+    switch (key) {
+        case Qt::Key_Dead_Grave:
+        case Qt::Key_Dead_Acute:
+        case Qt::Key_Dead_Circumflex:
+        case Qt::Key_Dead_Tilde:
+        case Qt::Key_Dead_Macron:
+        case Qt::Key_Dead_Breve:
+        case Qt::Key_Dead_Abovedot:
+        case Qt::Key_Dead_Diaeresis:
+        case Qt::Key_Dead_Abovering:
+        case Qt::Key_Dead_Doubleacute:
+        case Qt::Key_Dead_Caron:
+        case Qt::Key_Dead_Cedilla:
+        case Qt::Key_Dead_Ogonek:
+        case Qt::Key_Dead_Iota:
+        case Qt::Key_Dead_Voiced_Sound:
+        case Qt::Key_Dead_Semivoiced_Sound:
+        case Qt::Key_Dead_Belowdot:
+        case Qt::Key_Dead_Hook:
+        case Qt::Key_Dead_Horn: return true;
+        default: return false;
+    }
+}
+
+/*!
+    \brief Loads additional dead key compose sequences from \a fileName.
+
+    The file uses the X11 Compose format, for example:
+
+    \code
+    <dead_circumflex> <dead_acute> <a> : "ấ"
+    \endcode
+
+    Loaded sequences take precedence over the built-in composition table, which
+    covers the canonical Unicode compositions of all dead keys. A layout file can
+    reference a compose file with the \c compose attribute of its root element.
+
+    \sa deadKeys, clearComposeFiles()
+*/
+bool QVirtualKeyboard::addComposeFile(const QString &fileName)
+{
+    QString errorString;
+    if (!d->composer.load(fileName, &errorString)) {
+        qWarning() << "QVirtualKeyboard::addComposeFile(" << fileName << ")" << errorString;
+        return false;
+    }
+    d->composeFiles.append(fileName);
+    return true;
+}
+
+/*!
+    \brief Removes all compose sequences loaded with addComposeFile().
+
+    \sa addComposeFile()
+*/
+void QVirtualKeyboard::clearComposeFiles()
+{
+    d->composeFiles.clear();
+    d->composer.clear();
+    if (!d->layoutComposeFile.isEmpty())
+        d->composer.load(d->layoutComposeFile);
+}
+
+/*!
+    \brief Set capslock behavior.
+
+    \sa capsLock, capsLock()
+*/
+void QVirtualKeyboard::setCapsLock(bool enabled)
+{
+    d->capsLock = enabled;
+    if (d->recorder)
+        d->recorder->recordState();
+}
+
+/*!
+    \brief Returns the state of capslock behavior.
+
+    \sa capsLock, setCapsLock()
+*/
+bool QVirtualKeyboard::capsLock() const
+{
+    return d->capsLock;
+}
+
+/*!
+    \internal
+    \brief Reads the layout file \a fileName into \a layout, preferring an up to date
+           compiled layout next to it. Warnings are prefixed with \a caller.
+*/
+static bool readLayoutFile(const char *caller, const QString &fileName, QVirtualKeyboardLayout *layout)
+{
+    QString errorString;
+
+    // Prefer an up to date compiled layout, fall back to the XML file otherwise
+    const QString compiledFileName = QVirtualKeyboardLayout::compiledFileName(fileName);
+    if (compiledFileName != fileName && QFileInfo(compiledFileName).exists()) {
+        const QDateTime sourceModified = QFileInfo(fileName).lastModified();
+        const QDateTime compiledModified = QFileInfo(compiledFileName).lastModified();
+        if (!sourceModified.isValid() || compiledModified >= sourceModified) {
+            if (layout->load(compiledFileName, &errorString))
+                return true;
+            qWarning() << caller << "(" << compiledFileName << ")" << errorString;
+        }
+    }
+
+    if (!QFileInfo(fileName).exists()) {
+        qWarning() << caller << "(" << fileName << ") Unable to find keyboard layout!";
+        return false;
+    }
+    if (!layout->load(fileName, &errorString)) {
+        qWarning() << caller << "(" << fileName << ")" << errorString;
+        return false;
+    }
+    return true;
+}
+
+/*!
+    \brief Loads a new keyboard layout and changes it.
+
+    A virtual keyboard layout XML file is parsed and the virtual
+    keyboard tries to match and update all registered virtual keys that
+    are found in the layout file. If a virtual key is not described in
+    the layout XML file with \a fileName it won't be changed at all.
+    Non-critical errors in the XML file (wrong structure, unknown
+    elements, ...) are gently ignored with a warning printed on stdout;
+
+    \a fileName may also name a compiled layout created with the \c qvkmc
+    tool. If a compiled layout with the same base name and the \c .qvkc
+    suffix exists next to the layout XML file and is not older than it,
+    the compiled layout is used instead of parsing the XML file.
+
+    If the layout was loaded before with preloadLayout(), either by its file
+    name or by its layout name, no file is read at all and only the virtual keys
+    whose bindings differ from the current layout are changed.
+
+    \sa QVirtualKeyboardLayoutReader, preloadLayout()
+*/
+bool QVirtualKeyboard::setLayout(const QString &fileName)
+{
+    if (fileName.isEmpty())
+        return false;
+
+    // Layouts still read by setLayoutAsync() must not replace this one
+    ++d->layoutRequest;
+    d->loadingLayout.clear();
+
+    if (const QVirtualKeyboardLayout *preloaded = d->preloadedLayout(fileName)) {
+        d->layoutFile = fileName;
+        applyLayout(*preloaded);
+        return true;
+    }
+
+    QVirtualKeyboardLayout layout;
+    if (!readLayoutFile("QVirtualKeyboard::setLayout", fileName, &layout))
+        return false;
+    d->layoutFile = fileName;
+    applyLayout(layout);
+    return true;
+}
+
+/*!
+    \internal
+    \brief Reads the layout \a fileName for request number \a request, runs in a worker thread.
+*/
+static QVirtualKeyboardPrivate::LayoutRead readLayoutRequest(const QString &fileName, int request)
+{
+    QVirtualKeyboardPrivate::LayoutRead read;
+    read.fileName = fileName;
+    read.request = request;
+    read.ok = readLayoutFile("QVirtualKeyboard::setLayoutAsync", fileName, &read.layout);
+    return read;
+}
+
+/*!
+    \brief Loads the keyboard layout \a fileName in a worker thread and changes it
+           once it is loaded.
+
+    Unlike setLayout() the layout file is read and parsed without blocking the
+    event loop. When it is done, the layout is applied to all registered virtual
+    keys in one step and layoutLoaded() is emitted. A preloaded layout is applied
+    immediately and layoutLoaded() is emitted before this method returns.
+
+    Calling setLayoutAsync() or setLayout() again while a layout is being read
+    supersedes the running request: its result is discarded and no layoutLoaded()
+    signal is emitted for it.
+
+    Returns false if \a fileName is empty.
+
+    \note Without QtConcurrent (QT_NO_CONCURRENT) the layout is read synchronously.
+
+    \sa setLayout(), isLayoutLoading(), layoutLoaded()
+*/
+bool QVirtualKeyboard::setLayoutAsync(const QString &fileName)
+{
+    if (fileName.isEmpty())
+        return false;
+
+    const int request = ++d->layoutRequest;
+    d->loadingLayout.clear();
+
+    if (const QVirtualKeyboardLayout *preloaded = d->preloadedLayout(fileName)) {
+        d->layoutFile = fileName;
+        applyLayout(*preloaded);
+        emit layoutLoaded(fileName, true);
+        return true;
+    }
+
+#ifndef QT_NO_CONCURRENT
+    d->loadingLayout = fileName;
+    QFutureWatcher<QVirtualKeyboardPrivate::LayoutRead> *watcher = new QFutureWatcher<QVirtualKeyboardPrivate::LayoutRead>(this);
+    connect(watcher, SIGNAL(finished()), this, SLOT(layoutReadFinished()));
+    watcher->setFuture(QtConcurrent::run(readLayoutRequest, fileName, request));
+#else
+    const QVirtualKeyboardPrivate::LayoutRead read = readLayoutRequest(fileName, request);
+    if (read.ok) {
+        d->layoutFile = fileName;
+        applyLayout(read.layout);
+    }
+    emit layoutLoaded(fileName, read.ok);
+#endif
+    return true;
+}
+
+/*!
+    \brief Returns true while a layout requested with setLayoutAsync() is being read.
+*/
+bool QVirtualKeyboard::isLayoutLoading() const
+{
+    return !d->loadingLayout.isEmpty();
+}
+
+/*!
+    \internal
+    \brief Applies a layout read by setLayoutAsync() unless a newer layout was requested meanwhile.
+*/
+void QVirtualKeyboard::layoutReadFinished()
+{
+#ifndef QT_NO_CONCURRENT
+    QFutureWatcher<QVirtualKeyboardPrivate::LayoutRead> *watcher =
+        static_cast<QFutureWatcher<QVirtualKeyboardPrivate::LayoutRead> *>(sender());
+    const QVirtualKeyboardPrivate::LayoutRead read = watcher->result();
+    watcher->deleteLater();
+
+    if (read.request != d->layoutRequest)
+        return;
+
+    d->loadingLayout.clear();
+    if (read.ok) {
+        d->layoutFile = read.fileName;
+        applyLayout(read.layout);
+    }
+    emit layoutLoaded(read.fileName, read.ok);
+#endif
+}
+
+/*!
+    \brief Loads the keyboard layout \a fileName into memory without changing the
+           current layout.
+
+    Preloaded layouts can be switched to with setLayout() by either their file name
+    or their layout name. This is useful for keyboards which often toggle between
+    a few layouts (for example letters, numbers and symbols). Preloading a layout
+    again reloads it from \a fileName.
+
+    \sa setLayout(), unloadLayout(), preloadedLayouts()
+*/
+bool QVirtualKeyboard::preloadLayout(const QString &fileName)
+{
+    if (fileName.isEmpty())
+        return false;
+
+    QVirtualKeyboardLayout layout;
+    if (!readLayoutFile("QVirtualKeyboard::preloadLayout", fileName, &layout))
+        return false;
+    d->layoutCache.insert(fileName, layout);
+    return true;
+}
+
+/*!
+    \brief Removes the preloaded layout \a fileName from memory.
+
+    \sa preloadLayout()
+*/
+void QVirtualKeyboard::unloadLayout(const QString &fileName)
+{
+    d->layoutCache.remove(fileName);
+}
+
+/*!
+    \brief Returns the file names of all preloaded layouts.
+
+    \sa preloadLayout()
+*/
+QStringList QVirtualKeyboard::preloadedLayouts() const
+{
+    return d->layoutCache.keys();
+}
+
+/*!
+    \internal
+    \brief Defers repaint and relayout requests of all registered virtual keys
+           until endUpdate() is called.
+*/
+void QVirtualKeyboard::beginUpdate()
+{
+    if (d->updateDepth++ > 0)
+        return;
+    foreach (const QList<QVirtualKey *> &keys, d->virtualKeyHash) {
+        foreach (QVirtualKey *key, keys)
+            key->d->updatesDeferred = true;
+    }
+}
+
+/*!
+    \internal
+    \brief Handles the repaint and relayout requests collected since beginUpdate()
+           in one pass.
+*/
+void QVirtualKeyboard::endUpdate()
+{
+    if (--d->updateDepth > 0)
+        return;
+    foreach (const QList<QVirtualKey *> &keys, d->virtualKeyHash) {
+        foreach (QVirtualKey *key, keys) {
+            QVirtualKeyPrivate *kd = key->d;
+            if (!kd->updatesDeferred)
+                continue;
+            if (kd->pendingUpdate)
+                key->update();
+            if (kd->pendingGeometryUpdate)
+                key->updateGeometry();
+            kd->updatesDeferred = false;
+            kd->pendingUpdate = false;
+            kd->pendingGeometryUpdate = false;
+        }
+    }
+}
+
+/*!
+    \internal
+    \brief Applies the key bindings of \a layout to the registered virtual keys.
+
+    Every layer is compared with the current binding of its virtual key and only
+    the changed properties are set. Repaints and relayouts of the changed keys
+    are done once the whole layout is applied.
+*/
+void QVirtualKeyboard::applyLayout(const QVirtualKeyboardLayout &layout)
+{
+    setLayoutVersion(layout.version);
+    setLayoutName(layout.name);
+
+    // Compose sequences of the layout replace the ones of the previous layout
+    if (layout.composeFile != d->layoutComposeFile) {
+        d->layoutComposeFile = layout.composeFile;
+        d->composer.clear();
+        foreach (const QString &fileName, d->composeFiles)
+            d->composer.load(fileName);
+        QString errorString;
+        if (!d->layoutComposeFile.isEmpty() && !d->composer.load(d->layoutComposeFile, &errorString))
+            qWarning() << "QVirtualKeyboard::setLayout(" << d->layoutComposeFile << ")" << errorString;
+    }
+
+    beginUpdate();
+    d->layoutChangedKeys = 0;
+    foreach (const QVirtualKeyboardLayout::Entry &entry, layout.entries) {
+        QVirtualKey *vkey = findVirtualKey(entry.name);
+        if (!vkey)
+            continue;
+
+        // Only layers which differ from the key's current binding are touched
+        bool changed = false;
+        for (int layer = 0; layer < QVirtualKeyboardLayout::LayerCount; ++layer) {
+            const QVirtualKeyboardLayout::Binding &binding = entry.bindings[layer];
+            if (binding.defined && vkey->setBinding(layer, binding.key, binding.text, binding.icon))
+                changed = true;
+        }
+        if (changed)
+            ++d->layoutChangedKeys;
+    }
+    endUpdate();
+
+    if (d->recorder)
+        d->recorder->recordLayout();
+}
+
+/*!
+    \brief Validates the keyboard layout XML file \a fileName without changing the
+           current layout.
+
+    Unlike setLayout(), which skips what it does not understand, every error is
+    reported: malformed XML, unknown elements and attributes, unknown key names,
+    virtual keys without name or \c <default> element, duplicate virtual keys and
+    virtual keys which do not exist in the registered key containers (if any are
+    registered). The errors are appended to \a errors formatted as \c {line:column: message}.
+
+    Returns true if the layout has no errors.
+
+    \sa setLayout(), addKeyContainer()
+*/
+bool QVirtualKeyboard::validateLayout(const QString &fileName, QStringList *errors)
+{
+    d->indexNamedKeys();
+    QSet<QString> names;
+    for (QMultiHash<QString, QVirtualKey *>::const_iterator it = d->virtualKeyIndex.constBegin();
+            it != d->virtualKeyIndex.constEnd(); ++it) {
+        if (it.value()->objectName() == it.key())
+            names.insert(it.key());
+    }
+    return QVirtualKeyboardLayout::validate(fileName, errors, names);
+}
+
+/*!
+    \brief Returns the number of virtual keys changed by the last layout change.
+
+    Keys whose bindings were identical in the previous and the new layout, and
+    keys not present in the new layout, are not counted.
+
+    \sa setLayout(), setLayoutAsync()
+*/
+int QVirtualKeyboard::layoutChangedKeys() const
+{
+    return d->layoutChangedKeys;
+}
+
+/*!
+    \brief Set the current keyboard layout \a version.
+
+    This is just informational and can be used by GUI's.
+*/
+void QVirtualKeyboard::setLayoutVersion(int version)
+{
+    d->keyboardLayoutVersion = version;
+}
+
+/*!
+    \brief Retrieve the current keyboard layout version number.
+
+    This is just informational and can be used by GUI's.
+*/
+int QVirtualKeyboard::layoutVersion() const
+{
+    return d->keyboardLayoutVersion;
+}
+
+/*!
+    \brief Set the current keyboard layout \a name.
+
+    This is just informational and can be used by GUI's.
+*/
+void QVirtualKeyboard::setLayoutName(const QString &name)
+{
+    d->keyboardLayoutName = name;
+}
+
+/*!
+    \brief Returns the virtual key at \a pos in coordinates of the key \a container,
+           or the nearest key not further away than hitRadius().
+
+    Disabled keys are never returned. Near the border between keys the key
+    weights set with setKeyWeights() decide. The keys are looked up in a grid
+    which is rebuilt when keys are moved or resized, so the cost of a lookup
+    does not depend on the number of keys.
+
+    The virtual keyboard uses this to redirect presses which hit a key container
+    between its keys to the nearest key.
+
+    \sa addKeyContainer(), setHitRadius()
+*/
+QVirtualKey *QVirtualKeyboard::keyAt(QObject *container, const QPoint &pos) const
+{
+    QHash<QObject *, QList<QVirtualKey *> >::const_iterator it = d->virtualKeyHash.constFind(container);
+    if (it == d->virtualKeyHash.constEnd() || !container->isWidgetType())
+        return 0;
+    return d->hitIndex.keyAt(static_cast<QWidget *>(container), it.value(), pos, d->hitRadius, d->keyWeights);
+}
+
+/*!
+    \brief Sets the maximum distance in \a pixels of a press between keys to the key
+           it is redirected to, the default is 6.
+
+    Presses on a key container which miss all keys, for example in the spacing
+    between them, are handled as presses of the nearest key if it is not further
+    away than this. Set 0 to ignore such presses.
+
+    \sa keyAt()
+*/
+void QVirtualKeyboard::setHitRadius(int pixels)
+{
+    d->hitRadius = qMax(0, pixels);
+}
+
+/*!
+    \brief Returns the maximum distance of a press between keys to the key it is redirected to.
+*/
+int QVirtualKeyboard::hitRadius() const
+{
+    return d->hitRadius;
+}
+
+/*!
+    \brief Sets the \a weights of keys by their lower case text for resolving presses
+           between keys.
+
+    The distance of a press to a key is divided by the weight of the key, keys
+    without weight have the weight 1. Giving likely next letters a higher weight
+    makes presses between keys prefer them, QVirtualKeyPredictor can do this
+    automatically.
+
+    \sa keyAt(), QVirtualKeyPredictor::setKeyWeighting()
+*/
+void QVirtualKeyboard::setKeyWeights(const QHash<QString, qreal> &weights)
+{
+    d->keyWeights = weights;
+}
+
+/*!
+    \brief Returns the weights of keys by their lower case text.
+*/
+QHash<QString, qreal> QVirtualKeyboard::keyWeights() const
+{
+    return d->keyWeights;
+}
+
+/*!
+    \internal
+    \brief Redirects the mouse \a event which hit \a container between its keys to the
+           nearest key and returns true, or returns false if there is none.
+
+    The following moves and the release are redirected to the same key. Positions
+    in the gap next to the key are moved onto its border, so that the key accepts
+    the release as a click.
+*/
+bool QVirtualKeyboard::redirectMouseEvent(QWidget *container, QMouseEvent *event)
+{
+    if (event->type() == QEvent::MouseButtonPress || event->type() == QEvent::MouseButtonDblClick) {
+        if (d->redirectedKey)
+            return false;
+        d->redirectedKey = keyAt(container, event->pos());
+        d->redirectContainer = container;
+    } else if (d->redirectContainer != container) {
+        return false;
+    }
+
+    QVirtualKey *key = d->redirectedKey;
+    if (!key)
+        return false;
+
+    QPoint pos = key->mapFrom(container, event->pos());
+    const QRect rect = key->rect();
+    const QPoint border(qBound(rect.left(), pos.x(), rect.right()), qBound(rect.top(), pos.y(), rect.bottom()));
+    if ((pos - border).manhattanLength() <= 2 * d->hitRadius)
+        pos = border;
+
+    QMouseEvent redirected(event->type(), pos, key->mapToGlobal(pos), event->button(), event->buttons(), event->modifiers());
+    if (event->type() == QEvent::MouseButtonRelease && event->buttons() == Qt::NoButton) {
+        d->redirectedKey = 0;
+        d->redirectContainer = 0;
+    }
+    QCoreApplication::sendEvent(key, &redirected);
+    return true;
+}
+
+/*!
+    \brief Retrieve the current keyboard layout name.
+
+    This is just informational and can be used by GUI's.
+*/
+const QString QVirtualKeyboard::layoutName() const
+{
+    return d->keyboardLayoutName;
+}
+
+/*!
+    \brief Find a virtual key child object with \a name within all key
+           containers registered with this virtual keyboard.
+
+    The lookup uses an index of all registered virtual keys by object name,
+    which is updated whenever a key or key container is added or removed, so
+    the cost of a lookup does not depend on the number of keys. Keys which get
+    their name after they were added to a container are indexed once their
+    container polishes them, or on the next lookup which misses. Keys which are
+    renamed later on are indexed under their new name with Qt 5 only, with Qt 4
+    they have to be re-added to their container.
+
+    \sa QObject::findChild
+*/
+QVirtualKey *QVirtualKeyboard::findVirtualKey(const QString &name) const
+{
+    QVirtualKey *key = d->indexedVirtualKey(name);
+    if (!key && !d->unnamedKeys.isEmpty()) {
+        d->indexNamedKeys();
+        key = d->indexedVirtualKey(name);
+    }
+    if (key)
+        return key;
+    qWarning() << "QVirtualKeyboard::findVirtualKey(" << name << ") Unable to find virtual key!";
+    return 0;
+}
+
+/*!
+    \internal
+    \brief Process-wide tables between the names of the Qt::Key enumerators and their values.
+
+    Both the 'Key_1' and the 'Qt::Key_1' spelling are contained. The tables are built
+    once on first use, so converting key names does not scan the meta object.
+*/
+class QVirtualKeyNameTable
+{
+public:
+    QVirtualKeyNameTable()
+    {
+        // Qt's magic in undocumented features rocks. Find the QMetaEnum of Qt::Key to
+        // easily get the enum values and their string representations.
+        const int index = QObject::staticQtMetaObject.indexOfEnumerator("Key");
+        const QMetaEnum me = QObject::staticQtMetaObject.enumerator(index);
+        const QString scope = QLatin1String(me.scope()) + QLatin1String("::");
+
+        nameToKey.reserve(me.keyCount() * 2);
+        keyToName.reserve(me.keyCount());
+        for (int i = 0; i < me.keyCount(); ++i) {
+            const QString name = QLatin1String(me.key(i));
+            const Qt::Key key = Qt::Key(me.value(i));
+            nameToKey.insert(name, key);
+            nameToKey.insert(scope + name, key);
+            // Several names may share a value, the first one is the canonical name
+            if (!keyToName.contains(key))
+                keyToName.insert(key, name);
+        }
+    }
+
+    QHash<QString, Qt::Key> nameToKey;
+    QHash<int, QString> keyToName;
+};
+
+Q_GLOBAL_STATIC(QVirtualKeyNameTable, virtualKeyNameTable)
+
+/*!
+    \brief Tries to convert \a string describing a key to a Qt::Key.
+
+    Both the plain enumerator name (\c Key_1) and the scoped form (\c Qt::Key_1) are
+    accepted. If \a ok is not 0, it is set to wether the conversion succeeded and
+    no warning is printed on failure.
+
+    \sa keyToString()
+*/
+Qt::Key QVirtualKeyboard::stringToKey(const QString &string, bool *ok)
+{
+    const QHash<QString, Qt::Key> &nameToKey = virtualKeyNameTable()->nameToKey;
+    QHash<QString, Qt::Key>::const_iterator it = nameToKey.constFind(string);
+
+    if (ok)
+        *ok = it != nameToKey.constEnd();
+    if (it != nameToKey.constEnd()) {
+        return it.value();
+    } else {
+        if (!ok)
+            qWarning() << "QVirtualKeyboard::stringToKey() Unable to convert" << string << "to key, using Qt::Key_unknown";
+        return Qt::Key_unknown;
+    }
+}
+
+/*!
+    \brief Returns the enumerator name of \a key without the 'Qt::' scope, for
+           example \c Key_1.
+
+    An empty string is returned if \a key is not part of the Qt::Key enum.
+
+    \sa stringToKey()
+*/
+QString QVirtualKeyboard::keyToString(Qt::Key key)
+{
+    return virtualKeyNameTable()->keyToName.value(key);
+}
+
+/*!
+    \reimp
+    \brief Tracks the registered virtual keys and their containers, and filters the
+           events the keyboard handles itself.
+
+    The following events are consumed, all others are passed on:
+    \list
+    \o Mouse presses, double clicks, moves and releases on a key container which
+       are redirected to the nearest virtual key within hitRadius().
+    \o All mouse events on a key container while keys are held by touch points.
+    \o Touch begin, update, end and cancel events on a key container, the touch
+       points press and release the keys themselves.
+    \o Mouse presses, double clicks and releases on virtual keys while keys are held
+       by touch points, as they are emulated by the platform for the touch points.
+    \endlist
+*/
+bool QVirtualKeyboard::eventFilter(QObject *object, QEvent *event)
+{
+    // Key containers: presses between the keys and relayouts
+    if (object->isWidgetType() && !qobject_cast<QVirtualKey *>(object) && d->virtualKeyHash.contains(object)) {
+        switch (event->type()) {
+            case QEvent::MouseButtonPress:
+            case QEvent::MouseButtonDblClick:
+            case QEvent::MouseMove:
+            case QEvent::MouseButtonRelease:
+                if (isTouching() || redirectMouseEvent(static_cast<QWidget *>(object), static_cast<QMouseEvent *>(event)))
+                    return true;
+                break;
+#if QT_VERSION >= 0x040600
+            case QEvent::TouchBegin:
+            case QEvent::TouchUpdate:
+            case QEvent::TouchEnd:
+                touchEvent(static_cast<QWidget *>(object), static_cast<QTouchEvent *>(event));
+                return true;
+#endif
+#if QT_VERSION >= 0x050000
+            case QEvent::TouchCancel:
+                releaseTouchPoints(object);
+                return true;
+#endif
+            case QEvent::Resize:
+            case QEvent::LayoutRequest:
+                d->hitIndex.invalidate();
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (event->type() == QEvent::ChildAdded) {
+        QChildEvent *ce = static_cast<QChildEvent *>(event);
+        // Install event filter for added virtual key children
+        if (QVirtualKey *key = qobject_cast<QVirtualKey *>(ce->child())) {
+            registerKey(key);
+            QHash<QObject *, QList<QVirtualKey *> >::iterator it = d->virtualKeyHash.find(object);
+            if (it != d->virtualKeyHash.end() && !it.value().contains(key)) {
+                it.value().append(key);
+                d->indexVirtualKey(key);
+            }
+        }
+
+    } else if (event->type() == QEvent::ChildPolished) {
+        // The object name is usually set after the key was added to its parent
+        if (QVirtualKey *key = qobject_cast<QVirtualKey *>(static_cast<QChildEvent *>(event)->child()))
+            d->reindexVirtualKey(key);
+
+    } else if (event->type() == QEvent::ChildRemoved) {
         QChildEvent *ce = static_cast<QChildEvent *>(event);
         // Remove event filter from removed virtual key children
-        if(qobject_cast<QVirtualKey *>(ce->child()))
-            ce->child()->removeEventFilter(this);
+        if (QVirtualKey *key = qobject_cast<QVirtualKey *>(ce->child()))
+            unregisterKey(key);
+        // The child might be in destruction already, so it is only compared by address
+        QHash<QObject *, QList<QVirtualKey *> >::iterator it = d->virtualKeyHash.find(object);
+        if (it != d->virtualKeyHash.end()) {
+            QList<QVirtualKey *> &keys = it.value();
+            for (int i = keys.count() - 1; i >= 0; --i) {
+                if (static_cast<QObject *>(keys.at(i)) == ce->child()) {
+                    keys.removeAt(i);
+                    d->unindexVirtualKey(ce->child());
+                }
+            }
+        }
+
+    } else if (isTouching() && qobject_cast<QVirtualKey *>(object)
+            && (event->type() == QEvent::MouseButtonPress || event->type() == QEvent::MouseButtonDblClick
+                || event->type() == QEvent::MouseButtonRelease)) {
+        // Mouse events emulated by the platform for the touch points
+        return true;
+
+    } else if (event->type() == QEvent::MouseButtonPress || event->type() == QEvent::MouseButtonDblClick
+            || event->type() == QEvent::KeyPress) {
+        if (QVirtualKey *vk = qobject_cast<QVirtualKey *>(object))
+            virtualKeyPressed(vk);
+
+    } else if (event->type() == QEvent::MouseButtonRelease || event->type() == QEvent::KeyRelease) {
+        if (QVirtualKey *vk = qobject_cast<QVirtualKey *>(object))
+            virtualKeyReleased(vk);
+    }
+    return false;
+}
+
+#if QT_VERSION >= 0x040600
+/*!
+    \internal
+    \brief Presses and releases the virtual keys under the touch points of \a event,
+           which was sent to the key \a container.
+
+    Every touch point presses the key it starts on, found with keyAt() like a
+    press between keys, and releases it when the point ends, wherever it was
+    moved meanwhile. So any number of keys can be held at once, the modifier
+    state counts every held modifier key, and with rollover the keys are
+    released in the order the fingers are lifted.
+
+    A key emits QAbstractButton::pressed() when the first touch point presses it,
+    and released() and clicked() when the last touch point on it ends, like on a
+    mouse click. Checkable keys toggle right before.
+*/
+void QVirtualKeyboard::touchEvent(QWidget *container, QTouchEvent *event)
+{
+    event->accept();
+    foreach (const QTouchEvent::TouchPoint &point, event->touchPoints()) {
+        if (point.state() == Qt::TouchPointPressed) {
+            if (d->touchKeys.contains(point.id()))
+                continue;
+            QVirtualKey *key = keyAt(container, point.pos().toPoint());
+            if (!key)
+                continue;
+            const bool first = !d->touchKeys.values().contains(key);
+            d->touchKeys.insert(point.id(), key);
+            if (first)
+                key->setDown(true);
+            QPointer<QVirtualKey> guard(key);
+            virtualKeyPressed(key);
+            if (guard && first)
+                emit key->pressed();
+        } else if (point.state() == Qt::TouchPointReleased) {
+            QPointer<QVirtualKey> key = d->touchKeys.take(point.id());
+            if (!key)
+                continue;
+            virtualKeyReleased(key);
+            if (key && !d->touchKeys.values().contains(key)) {
+                key->setDown(false);
+                key->nextCheckState();
+                if (key)
+                    emit key->released();
+                if (key)
+                    emit key->clicked(key->isChecked());
+            }
+        }
+    }
+}
+#endif
+
+/*!
+    \internal
+    \brief Releases the virtual keys held by touch points on \a container, or by all
+           touch points if \a container is 0, without clicking them. The keys emit
+           QAbstractButton::released() only.
+
+    This is used if the platform cancels the touch sequence or the container is
+    unregistered, so that no key is left pressed.
+*/
+void QVirtualKeyboard::releaseTouchPoints(QObject *container)
+{
+    const QList<QVirtualKey *> keys = d->virtualKeyHash.value(container);
+    foreach (int id, d->touchKeys.keys()) {
+        QPointer<QVirtualKey> key = d->touchKeys.value(id);
+        if (container && key && !keys.contains(key))
+            continue;
+        d->touchKeys.remove(id);
+        if (!key)
+            continue;
+        virtualKeyReleased(key);
+        if (key && !d->touchKeys.values().contains(key)) {
+            key->setDown(false);
+            emit key->released();
+        }
+    }
+}
 
-    } else if (event->type() == QEvent::MouseButtonPress || event->type() == QEvent::MouseButtonDblClick
-            || event->type() == QEvent::KeyPress) {
-        QVirtualKey *vk = qobject_cast<QVirtualKey *>(object);
-        if (vk) {
-            // The user pressed a virtual key, generate key event and send to all receivers.
-            QKeyEvent::Type keyEventType;
-            if (vk->isCheckable())
-                vk->isChecked() ? keyEventType = QKeyEvent::KeyRelease : keyEventType = QKeyEvent::KeyPress;
-            else
-                keyEventType = QKeyEvent::KeyPress;
-            QKeyEvent *event = generateKeyEvent(*vk, keyEventType);
-            //qDebug() << "QVirtualKeyboard::eventFilter() Received press event, send " << event;
+/*!
+    \internal
+    \brief Returns true while a touch point holds a virtual key.
+
+    Mouse events which the platform emulates for touch points are ignored meanwhile.
+*/
+bool QVirtualKeyboard::isTouching() const
+{
+    return !d->touchKeys.isEmpty();
+}
+
+/*!
+    \internal
+    \brief Returns the state which determines the key events generated for the next
+           virtual key presses: the modifiers, pending dead keys and the auto-shifting,
+           dead key and caps lock options.
+
+    \sa restoreInputState(), QVirtualKeyRecorder
+*/
+QByteArray QVirtualKeyboard::saveInputState() const
+{
+    QByteArray state;
+    QDataStream out(&state, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_6);
+    out.setByteOrder(QDataStream::LittleEndian);
+    d->modifierState.save(out);
+    out << quint32(d->rememberedStandardModifiers)
+        << quint8(d->autoShifting) << quint8(d->deadKeys) << quint8(d->capsLock)
+        << quint8(d->pendingDeadKeys.count());
+    foreach (Qt::Key key, d->pendingDeadKeys)
+        out << quint32(key);
+    return state;
+}
+
+/*!
+    \internal
+    \brief Restores a \a state returned by saveInputState().
+
+    Returns false and leaves the keyboard unchanged if \a state is invalid.
+*/
+bool QVirtualKeyboard::restoreInputState(const QByteArray &state)
+{
+    QDataStream in(state);
+    in.setVersion(QDataStream::Qt_4_6);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    QVirtualKeyModifierState modifierState = d->modifierState;
+    quint32 standardModifiers = 0;
+    quint8 autoShifting = 0, deadKeys = 0, capsLock = 0, pendingCount = 0;
+    if (!modifierState.load(in))
+        return false;
+    in >> standardModifiers >> autoShifting >> deadKeys >> capsLock >> pendingCount;
+    QList<Qt::Key> pendingDeadKeys;
+    for (int i = 0; i < pendingCount && i < QVirtualKeyComposer::MaximumSequenceLength; ++i) {
+        quint32 key = 0;
+        in >> key;
+        pendingDeadKeys.append(Qt::Key(key));
+    }
+    if (in.status() != QDataStream::Ok || pendingCount > pendingDeadKeys.count())
+        return false;
+
+    const uint previousModifiers = d->modifierState.activeMask();
+    d->modifierState = modifierState;
+    d->rememberedStandardModifiers = Qt::KeyboardModifiers(standardModifiers);
+    d->autoShifting = autoShifting;
+    d->deadKeys = deadKeys;
+    d->capsLock = capsLock;
+    d->pendingDeadKeys = pendingDeadKeys;
+    d->invalidateKeyTable();
+    if (d->modifierState.activeMask() != previousModifiers)
+        emit modifiersChanged();
+    return true;
+}
+
+/*!
+    \internal
+    \brief Handles a press of the virtual key \a vk, either reported by the event filter
+           or directly by the key.
+*/
+void QVirtualKeyboard::virtualKeyPressed(QVirtualKey *vk)
+{
+    if (d->recorder)
+        d->recorder->recordKey(vk, true);
+    ++d->keyDepth;
+
+    // The user pressed a virtual key, generate key event and send to all receivers.
+    QKeyEvent::Type keyEventType;
+    if (vk->isCheckable())
+        vk->isChecked() ? keyEventType = QKeyEvent::KeyRelease : keyEventType = QKeyEvent::KeyPress;
+    else
+        keyEventType = QKeyEvent::KeyPress;
+    QVK_TRACE(begin(vk->objectName(), d->keyboardLayoutName));
+    QKeyEvent ke = generateKeyEvent(*vk, keyEventType);
+    QVK_TRACE(generated());
+    //qDebug() << "QVirtualKeyboard::virtualKeyPressed() Received press event, send " << &ke;
+
+    deliverKeyEvent(ke, true);
+    QVK_TRACE(end());
+    startAutoRepeat(vk, ke);
+    --d->keyDepth;
+}
 
-            emit keyEvent(event);
-            emit keyPressed(event->key(), event->modifiers(), event->text());
+/*!
+    \internal
+    \brief Handles a release of the virtual key \a vk, either reported by the event filter
+           or directly by the key.
+*/
+void QVirtualKeyboard::virtualKeyReleased(QVirtualKey *vk)
+{
+    if (d->recorder)
+        d->recorder->recordKey(vk, false);
+
+    // Checkable keys get their key release event when you klick (keypress) it to release it
+    if (vk->isCheckable())
+        return;
+    ++d->keyDepth;
+    stopAutoRepeat(vk);
+
+    // The user released a virtual key, generate key event and send to all receivers.
+    QVK_TRACE(begin(vk->objectName(), d->keyboardLayoutName));
+    QKeyEvent ke = generateKeyEvent(*vk, QKeyEvent::KeyRelease);
+    QVK_TRACE(generated());
+    //qDebug() << "QVirtualKeyboard::virtualKeyReleased() Received release event, send" << &ke;
+
+    deliverKeyEvent(ke, false);
+    QVK_TRACE(end());
+    --d->keyDepth;
+}
+
+/*!
+    \internal
+    \brief Sends the key event \a ke to the receivers or queues it in batched delivery.
+
+    If \a pressed is true, keyPressed() is emitted after keyEvent(), otherwise keyReleased().
+*/
+void QVirtualKeyboard::deliverKeyEvent(QKeyEvent &ke, bool pressed)
+{
+    if (d->batchInterval > 0) {
+        d->pendingKeyEvents.append(QVirtualKeyboardPrivate::PendingKeyEvent(ke, pressed));
+        QVK_TRACE(keyEventDelivered());
+        if (d->pendingKeyEvents.count() >= d->batchSize)
+            flushKeyEvents();
+        else if (!d->batchTimer.isActive())
+            d->batchTimer.start(d->batchInterval, this);
+        return;
+    }
+
+    emit keyEvent(&ke);
+    QVK_TRACE(keyEventDelivered());
+    if (pressed)
+        emit keyPressed(ke.key(), ke.modifiers(), ke.text());
+    else
+        emit keyReleased(ke.key(), ke.modifiers(), ke.text());
+}
+
+/*!
+    \brief Sends all key events queued by batched delivery to the receivers.
+
+    Runs of printable characters, each pressed and released before the next one
+    and with the same modifiers, are coalesced into a single key press and release
+    whose text holds all characters and whose count is the number of characters,
+    like the key compression of QWidget does. The key code is the one of the first
+    character. All other events are sent unchanged and in their original order.
+
+    If keyEventBatch() is connected, it is emitted with all events of the batch.
+    Otherwise keyEvent() and keyPressed() or keyReleased() are emitted for every
+    single event. A QVirtualKeyPredictor watching the keyboard gets the key presses
+    of the batch either way.
+
+    \sa batchInterval
+*/
+void QVirtualKeyboard::flushKeyEvents()
+{
+    d->batchTimer.stop();
+    if (d->pendingKeyEvents.isEmpty())
+        return;
+
+    const QList<QVirtualKeyboardPrivate::PendingKeyEvent> pending = d->pendingKeyEvents;
+    d->pendingKeyEvents.clear();
+
+    QList<QVirtualKeyboardPrivate::PendingKeyEvent> coalesced;
+    for (int i = 0; i < pending.count(); ++i) {
+        const QVirtualKeyboardPrivate::PendingKeyEvent &event = pending.at(i);
+        const bool pair = i + 1 < pending.count() && QVirtualKeyboardPrivate::isPrintablePair(event, pending.at(i + 1));
+
+        if (pair && coalesced.count() >= 2 && QVirtualKeyboardPrivate::isPrintablePair(coalesced.at(coalesced.count() - 2), coalesced.last())
+                && coalesced.last().event.modifiers() == event.event.modifiers()
+                && coalesced.last().event.isAutoRepeat() == event.event.isAutoRepeat()) {
+            // Append the character to the previous run
+            const QKeyEvent &run = coalesced.at(coalesced.count() - 2).event;
+            const QString text = run.text() + event.event.text();
+            const int count = run.count() + event.event.count();
+            coalesced[coalesced.count() - 2].event = QKeyEvent(QEvent::KeyPress, run.key(), run.modifiers(), text, run.isAutoRepeat(), count);
+            coalesced.last().event = QKeyEvent(QEvent::KeyRelease, run.key(), run.modifiers(), text, run.isAutoRepeat(), count);
+            ++i;
+        } else {
+            coalesced.append(event);
         }
+    }
 
-    } else if (event->type() == QEvent::MouseButtonRelease || event->type() == QEvent::KeyRelease) {
-        QVirtualKey *vk = qobject_cast<QVirtualKey *>(object);
-        if (vk && !vk->isCheckable()) {
-            // The user released a virtual key, generate key event and send to all receivers.
-            // Checkable keys get their key release event when you klick (keypress) it to release it
-            QKeyEvent *event = generateKeyEvent(*vk, QKeyEvent::KeyRelease);
-            //qDebug() << "QVirtualKeyboard::eventFilter() Received release event, send" << event;
-
-            emit keyEvent(event);
-            emit keyReleased(event->key(), event->modifiers(), event->text());
+    // Either the whole batch or the single events, so that no receiver gets a key twice
+    if (receivers(SIGNAL(keyEventBatch(QList<QKeyEvent>))) > 0) {
+        QList<QKeyEvent> events;
+        foreach (const QVirtualKeyboardPrivate::PendingKeyEvent &event, coalesced)
+            events.append(event.event);
+        emit keyEventBatch(events);
+
+        // Predictors watch keyPressed(), which is not emitted for a batch
+        foreach (const QVirtualKeyboardPrivate::PendingKeyEvent &event, coalesced) {
+            if (!event.pressed)
+                continue;
+            foreach (const QPointer<QVirtualKeyPredictor> &predictor, d->predictors) {
+                if (predictor)
+                    predictor->processKey(event.event.key(), event.event.modifiers(), event.event.text());
+            }
         }
+        return;
+    }
+
+    for (int i = 0; i < coalesced.count(); ++i) {
+        QKeyEvent &ke = coalesced[i].event;
+        emit keyEvent(&ke);
+        if (coalesced.at(i).pressed)
+            emit keyPressed(ke.key(), ke.modifiers(), ke.text());
+        else
+            emit keyReleased(ke.key(), ke.modifiers(), ke.text());
+    }
+}
+
+/*!
+    \internal
+    \brief Starts repeating the key press \a ke of the virtual key \a vk while it is held.
+
+    Only non-checkable keys with QAbstractButton::autoRepeat enabled repeat, keys
+    without key code (pending dead keys) and modifiers never do. The repeated
+    events are copies of \a ke, the modifier and dead key state is not touched.
+*/
+void QVirtualKeyboard::startAutoRepeat(QVirtualKey *vk, const QKeyEvent &ke)
+{
+    stopAutoRepeat(vk);
+
+    const Qt::Key key = Qt::Key(ke.key());
+    if (!vk->autoRepeat() || vk->isCheckable() || ke.type() != QEvent::KeyPress
+            || key == Qt::Key_unknown || d->modifierState.indexOf(key) >= 0
+            || key == Qt::Key_CapsLock || key == Qt::Key_NumLock || keyToKeyboardModifier(key) != Qt::NoModifier)
+        return;
+
+    if (d->repeatingKeys.isEmpty())
+        d->repeatClock.start();
+    const int due = d->repeatClock.elapsed() + d->autoRepeatDelay;
+    d->repeatingKeys.append(QVirtualKeyboardPrivate::RepeatingKey(vk, ke, due));
+    scheduleAutoRepeat();
+}
+
+/*!
+    \internal
+    \brief Stops repeating the virtual key \a vk.
+*/
+void QVirtualKeyboard::stopAutoRepeat(QVirtualKey *vk)
+{
+    for (int i = d->repeatingKeys.count() - 1; i >= 0; --i) {
+        if (d->repeatingKeys.at(i).key == vk)
+            d->repeatingKeys.removeAt(i);
+    }
+    scheduleAutoRepeat();
+}
+
+/*!
+    \internal
+    \brief Starts the repeat timer for the held key which repeats next.
+*/
+void QVirtualKeyboard::scheduleAutoRepeat()
+{
+    if (d->repeatingKeys.isEmpty()) {
+        d->repeatTimer.stop();
+        return;
+    }
+
+    int due = d->repeatingKeys.first().due;
+    foreach (const QVirtualKeyboardPrivate::RepeatingKey &repeating, d->repeatingKeys)
+        due = qMin(due, repeating.due);
+    d->repeatTimer.start(qMax(0, due - d->repeatClock.elapsed()), this);
+}
+
+/*!
+    \internal
+    \brief Sends a release and a press with the autorepeat flag set for every held
+           key which is due.
+*/
+void QVirtualKeyboard::autoRepeat()
+{
+    const int now = d->repeatClock.elapsed();
+    QList<QVirtualKey *> dueKeys;
+    foreach (const QVirtualKeyboardPrivate::RepeatingKey &repeating, d->repeatingKeys) {
+        if (repeating.due <= now)
+            dueKeys.append(repeating.key);
+    }
+
+    foreach (QVirtualKey *vk, dueKeys) {
+        // A receiver might have released keys meanwhile
+        int index = 0;
+        while (index < d->repeatingKeys.count() && d->repeatingKeys.at(index).key != vk)
+            ++index;
+        if (index == d->repeatingKeys.count())
+            continue;
+
+        QVirtualKeyboardPrivate::RepeatingKey &repeating = d->repeatingKeys[index];
+        repeating.due = now + d->autoRepeatIntervalAfter(repeating.repeats++);
+        QKeyEvent release = repeating.release;
+        QKeyEvent press = repeating.press;
+        deliverKeyEvent(release, false);
+        deliverKeyEvent(press, true);
+    }
+    scheduleAutoRepeat();
+}
+
+/*!
+    \reimp
+    \brief Flushes the queued key events when the batch interval elapsed and
+           repeats held keys.
+*/
+void QVirtualKeyboard::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == d->batchTimer.timerId()) {
+        flushKeyEvents();
+        return;
+    }
+    if (event->timerId() == d->repeatTimer.timerId()) {
+        autoRepeat();
+        return;
+    }
+    QObject::timerEvent(event);
+}
+
+/*!
+    \internal
+    \brief Maps the modifier \a key to the corresponding Qt::KeyboardModifier.
+*/
+Qt::KeyboardModifier QVirtualKeyboardPrivate::keyToKeyboardModifier(Qt::Key key)
+{
+    switch (key) {
+        case Qt::Key_Shift: return Qt::ShiftModifier;
+        case Qt::Key_Control: return Qt::ControlModifier;
+        case Qt::Key_Alt: return Qt::AltModifier;
+        case Qt::Key_Meta: return Qt::MetaModifier;
+        default: return Qt::NoModifier;
+    }
+}
+
+/*!
+    \internal
+    \brief Returns the text sent together with \a key.
+
+    With \a autoShifting enabled, the text is uppercase if the key is \a upper
+    (because auto-shift was applied) and lowercase otherwise.
+*/
+QString QVirtualKeyboardPrivate::keyText(Qt::Key key, bool autoShifting, bool upper)
+{
+    // Apply some further fine-tuning for some keys with unpleasant behavior.
+    QChar unicode;
+    switch (key) {
+        case Qt::Key_unknown:
+        case Qt::Key_Shift:
+        case Qt::Key_Control:
+        case Qt::Key_Alt:
+        case Qt::Key_Meta:
+        case Qt::Key_Super_L:
+        case Qt::Key_Super_R:
+        case Qt::Key_Menu:
+        case Qt::Key_CapsLock:
+        case Qt::Key_NumLock:
+        case Qt::Key_Escape: break;
+        //NOTE: Maybe there are some more keys out there which should not generate
+        //      any visible output
+        case Qt::Key_Tab: unicode = QLatin1Char('\t'); break;
+        default: unicode = QChar(key);
+    }
+
+    // Check if auto-shifting is enabled, we generate a lowercase unicode value,
+    // otherwise auto-shift was applied (because the user pressed the 'shift'
+    // modifier key), we send it uppercase. This mimics the behavior of full
+    // keyboard layouts.
+    if (autoShifting)
+        unicode = upper ? unicode.toUpper() : unicode.toLower();
+
+    if (unicode.isNull())
+        return QString();
+    return QString(unicode);
+}
+
+/*!
+    \internal
+    \brief Computes the key codes and texts of all four layers of \a vk into \a entry.
+*/
+void QVirtualKeyboardPrivate::buildKeyTableEntry(const QVirtualKey &vk, KeyTableEntry *entry) const
+{
+    const Qt::Key layerKeys[QVirtualKeyboardLayout::LayerCount] = { vk.key(), vk.shiftKey(), vk.altKey(), vk.altShiftKey() };
+    for (int layer = 0; layer < QVirtualKeyboardLayout::LayerCount; ++layer) {
+        KeyBinding &binding = entry->layers[layer];
+        binding.key = layerKeys[layer];
+        binding.autoShifted = false;
+
+        // Only shift is active, if auto-shifting is enabled, use the default key value
+        if (layer == QVirtualKeyboardLayout::ShiftLayer && autoShifting && binding.key == Qt::Key_unknown) {
+            binding.key = vk.key();
+            binding.autoShifted = true;
+        }
+        binding.text = keyText(binding.key, autoShifting, binding.autoShifted);
+    }
+
+    entry->modifierIndex = modifierState.indexOf(vk.key());
+    entry->keyRevision = vk.d->bindingRevision;
+    entry->tableRevision = keyTableRevision;
+}
+
+/*!
+    \internal
+    \brief Returns the up-to-date key table entry of \a vk.
+
+    Virtual keys which are not registered with this keyboard are computed into
+    \a scratch.
+*/
+const QVirtualKeyboardPrivate::KeyTableEntry &QVirtualKeyboardPrivate::keyTableEntry(const QVirtualKey &vk, KeyTableEntry *scratch)
+{
+    updateModifierFlags();
+
+    const int id = vk.d->keyId;
+    if (id >= 0 && id < keyTable.count() && keyTable.at(id).key == &vk) {
+        KeyTableEntry &entry = keyTable[id];
+        if (entry.keyRevision != vk.d->bindingRevision || entry.tableRevision != keyTableRevision)
+            buildKeyTableEntry(vk, &entry);
+        return entry;
+    }
+
+    buildKeyTableEntry(vk, scratch);
+    return *scratch;
+}
+
+/*!
+    \internal
+    \brief Gives the registered virtual key \a key a slot in the key table.
+*/
+void QVirtualKeyboardPrivate::assignKeyId(QVirtualKey *key)
+{
+    int id = key->d->keyId;
+    if (id >= 0 && id < keyTable.count() && keyTable.at(id).key == key)
+        return;
+
+    if (freeKeyIds.isEmpty()) {
+        id = keyTable.count();
+        keyTable.append(KeyTableEntry());
+    } else {
+        id = freeKeyIds.takeLast();
+        keyTable[id] = KeyTableEntry();
+    }
+    keyTable[id].key = key;
+    key->d->keyId = id;
+}
+
+/*!
+    \internal
+    \brief Frees the key table slot of the unregistered virtual key \a key.
+*/
+void QVirtualKeyboardPrivate::releaseKeyId(QVirtualKey *key)
+{
+    const int id = key->d->keyId;
+    if (id < 0 || id >= keyTable.count() || keyTable.at(id).key != key)
+        return;
+
+    keyTable[id] = KeyTableEntry();
+    freeKeyIds.append(id);
+    key->d->keyId = -1;
+}
+
+/*!
+    \internal
+    \brief Adds the virtual \a key, which was added to a key container, to the name index.
+*/
+void QVirtualKeyboardPrivate::indexVirtualKey(QVirtualKey *key)
+{
+    QHash<const QObject *, IndexedKey>::iterator it = indexedKeys.find(key);
+    if (it != indexedKeys.end()) {
+        ++it.value().references;
+        return;
+    }
+
+    IndexedKey indexed;
+    indexed.name = key->objectName();
+    indexed.references = 1;
+    indexedKeys.insert(key, indexed);
+    if (indexed.name.isEmpty())
+        unnamedKeys.append(key);
+    else
+        virtualKeyIndex.insert(indexed.name, key);
+}
+
+/*!
+    \internal
+    \brief Removes the virtual \a key, which was removed from a key container, from
+           the name index once it is in no key container anymore.
+
+    Only the address of \a key is used, the key might be in destruction already.
+*/
+void QVirtualKeyboardPrivate::unindexVirtualKey(const QObject *key)
+{
+    QHash<const QObject *, IndexedKey>::iterator it = indexedKeys.find(key);
+    if (it == indexedKeys.end() || --it.value().references > 0)
+        return;
+
+    const QString name = it.value().name;
+    indexedKeys.erase(it);
+    if (name.isEmpty()) {
+        for (int i = unnamedKeys.count() - 1; i >= 0; --i) {
+            if (static_cast<const QObject *>(unnamedKeys.at(i)) == key)
+                unnamedKeys.removeAt(i);
+        }
+    } else {
+        QMultiHash<QString, QVirtualKey *>::iterator entry = virtualKeyIndex.find(name);
+        while (entry != virtualKeyIndex.end() && entry.key() == name) {
+            if (static_cast<const QObject *>(entry.value()) == key)
+                entry = virtualKeyIndex.erase(entry);
+            else
+                ++entry;
+        }
+    }
+}
+
+/*!
+    \internal
+    \brief Moves the registered virtual \a key to its current object name in the name index.
+*/
+void QVirtualKeyboardPrivate::reindexVirtualKey(QVirtualKey *key)
+{
+    QHash<const QObject *, IndexedKey>::iterator it = indexedKeys.find(key);
+    if (it == indexedKeys.end() || it.value().name == key->objectName())
+        return;
+
+    // Keep the container count, only the name changes
+    const int references = it.value().references;
+    it.value().references = 1;
+    unindexVirtualKey(key);
+    indexVirtualKey(key);
+    indexedKeys[key].references = references;
+}
+
+/*!
+    \internal
+    \brief Indexes the registered virtual keys which were named since they were added.
+
+    Only keys which had no name are looked at, usually none.
+*/
+void QVirtualKeyboardPrivate::indexNamedKeys()
+{
+    for (int i = unnamedKeys.count() - 1; i >= 0; --i) {
+        if (!unnamedKeys.at(i)->objectName().isEmpty())
+            reindexVirtualKey(unnamedKeys.at(i));
     }
-    return false;
+}
+
+/*!
+    \internal
+    \brief Returns the first registered virtual key named \a name or 0.
+*/
+QVirtualKey *QVirtualKeyboardPrivate::indexedVirtualKey(const QString &name) const
+{
+    // Keys with the same name are stored most recently added first
+    QVirtualKey *found = 0;
+    QMultiHash<QString, QVirtualKey *>::const_iterator it = virtualKeyIndex.constFind(name);
+    while (it != virtualKeyIndex.constEnd() && it.key() == name) {
+        if (it.value()->objectName() == name)
+            found = it.value();
+        ++it;
+    }
+    return found;
+}
+
+/*!
+    \internal
+    \brief Recomputes the Qt::KeyboardModifiers of every combination of active
+           modifiers if the modifier configuration changed.
+*/
+void QVirtualKeyboardPrivate::updateModifierFlags()
+{
+    if (modifierFlagsRevision == keyTableRevision)
+        return;
+
+    for (int mask = 0; mask < ModifierCombinations; ++mask) {
+        Qt::KeyboardModifiers flags(Qt::NoModifier);
+        for (int i = 0; i < modifierState.count(); ++i) {
+            if (mask & (1 << i))
+                flags |= keyToKeyboardModifier(modifierState.key(i));
+        }
+        modifierFlags[mask] = flags;
+    }
+    modifierFlagsRevision = keyTableRevision;
 }
 
 /*!
     \brief Helper method to generate a QKeyEvent based on the provided virtual key \a vk
            and \a type of user input.
+
+    The event is returned by value, so generating key events does not allocate
+    event objects on the heap.
 */
-QKeyEvent *QVirtualKeyboard::generateKeyEvent(const QVirtualKey &vk, QKeyEvent::Type type)
+QKeyEvent QVirtualKeyboard::generateKeyEvent(const QVirtualKey &vk, QKeyEvent::Type type)
 {
     Q_ASSERT(type == QKeyEvent::KeyPress || type == QKeyEvent::KeyRelease);
 
+    // Everything which only depends on the virtual key and the configuration is
+    // precomputed in the key table, per layer of the virtual key.
+    QVirtualKeyboardPrivate::KeyTableEntry scratch;
+    const QVirtualKeyboardPrivate::KeyTableEntry &entry = d->keyTableEntry(vk, &scratch);
+
     Qt::Key key(Qt::Key_unknown);
     Qt::KeyboardModifiers modifiers(Qt::NoModifier);
+    bool autoShifted = false;
+    static const QString noText;
+    const QString *text = &noText;
+
+    // If the pressed key is one of our designated modifiers, the modifier state
+    // counts how often it is pressed (use case: two shift keys, one is pressed,
+    // one is released, ...) and applies its latching or locking mode.
+    QVirtualKeyModifierState &state = d->modifierState;
+    const uint previousModifiers = state.activeMask();
+    if (entry.modifierIndex >= 0) {
+        if (type == QKeyEvent::KeyPress)
+            state.press(entry.modifierIndex);
+        else
+            state.release(entry.modifierIndex);
+    } else {
+        // The 'shift' and 'alt' modifiers select one of the four layers of the
+        // virtual key, auto-shifting is already applied to the shift layer.
+        const QVirtualKeyboardPrivate::KeyBinding &binding = entry.layers[previousModifiers & 0x3];
+        key = binding.key;
+        text = &binding.text;
+        autoShifted = binding.autoShifted;
 
-    // If the pressed key is one of our designated modifiers, we put them into
-    // a special hash where we count how often it was pressed (use case: two
-    // shift keys, one is pressed, one is released, ...).
-    if (vk.key() == d->shiftModifier || vk.key() == d->altModifier) {
-        if (type == QKeyEvent::KeyPress) {
-            if (d->currentModifierHash.contains(vk.key()))
-                d->currentModifierHash.insert(vk.key(), 1);
-            else
-                d->currentModifierHash.insert(vk.key(), d->currentModifierHash.value(vk.key()) + 1);
-        } else {
-            d->currentModifierHash.insert(vk.key(), d->currentModifierHash.value(vk.key()) - 1);
-        }
-        key = Qt::Key_unknown;
-    } else if (d->currentModifierHash.value(d->shiftModifier) > 0 && d->currentModifierHash.value(d->altModifier) > 0) {
-        // Shift and 'altModifier' are both pressed
-        key = vk.altShiftKey();
         // The exakt nature of the modifiers is unimportant for us to generate the corresponding
         // key event, but if it's a common one, we send it to not confuse the receiving QObject too much.
-        modifiers |= keyToKeyboardModifier(d->altModifier);
-        modifiers |= keyToKeyboardModifier(d->shiftModifier);
-    } else if (d->currentModifierHash.value(d->shiftModifier) > 0) {
-        // Only shift is pressed, if auto-shifting is enabled, use the default key value and remember it
-        // for proper later key unicode generation.
-        if (d->autoShifting && vk.shiftKey() == Qt::Key_unknown) {
-            key = vk.key();
-            d->autoShiftingMark = true;
-        } else {
-            key = vk.shiftKey();
-        }
-        modifiers |= keyToKeyboardModifier(d->shiftModifier);
-    } else if (d->currentModifierHash.value(d->altModifier) > 0) {
-        // Only 'altModifier' is pressed
-        key = vk.altKey();
-        modifiers |= keyToKeyboardModifier(d->altModifier);
-    } else {
-        // No modifiers are pressed
-        key = vk.key();
-        modifiers = Qt::NoModifier;
+        // This also covers additional modifiers like Qt::Key_Control added with addModifier().
+        modifiers = d->modifierFlags[previousModifiers];
+
+        // Latched modifiers apply to this key only
+        if (type == QKeyEvent::KeyPress && entry.layers[0].key != Qt::Key_CapsLock)
+            state.keyPressed();
     }
 
     // Altough we already considered the currently pressed modifiers, we only checked for
@@ -703,62 +2544,37 @@ QKeyEvent *QVirtualKeyboard::generateKeyEvent(const QVirtualKey &vk, QKeyEvent::
         d->rememberedStandardModifiers &= ~keyToKeyboardModifier(key);
     }
 
-    // CapsLock functionality is similar to modifier handling above.
-    if (d->capsLock && key == Qt::Key_CapsLock) {
-        if (type == QKeyEvent::KeyPress) {
-            if (!d->currentModifierHash.contains(d->shiftModifier))
-                d->currentModifierHash.insert(d->shiftModifier, 1);
-            else
-                d->currentModifierHash.insert(d->shiftModifier, d->currentModifierHash.value(d->shiftModifier) + 1);
-        } else {
-            d->currentModifierHash.insert(d->shiftModifier, d->currentModifierHash.value(d->shiftModifier) - 1);
-        }
-    }
-
-    // If dead key behavior is on and we have a dead key do special threatment
+    // CapsLock holds the 'shift' modifier until the user releases (or unchecks) it.
+    if (d->capsLock && key == Qt::Key_CapsLock)
+        state.hold(QVirtualKeyModifierState::ShiftIndex, type == QKeyEvent::KeyPress);
+    if (state.activeMask() != previousModifiers)
+        emit modifiersChanged();
+
+    // If dead key behavior is on and we have a dead key do special threatment. Dead
+    // keys are collected until a normal key is pressed, pressing the last dead
+    // key again generates its spacing equivalent. Only then the precomputed text
+    // does not fit the key.
+    QString composedText;
     if (d->deadKeys && type == QEvent::KeyPress) {
         if (isDeadKey(key)) {
-            if (d->lastDeadKey == key) {
-                key = deadKeyToUndeadKey(key);
-                d->lastDeadKey = Qt::Key_unknown;
+            if (!d->pendingDeadKeys.isEmpty() && d->pendingDeadKeys.last() == key) {
+                key = QVirtualKeyComposer::spacingKey(key);
+                d->pendingDeadKeys.clear();
             } else {
-                d->lastDeadKey = key;
+                if (d->pendingDeadKeys.count() == QVirtualKeyComposer::MaximumSequenceLength)
+                    d->pendingDeadKeys.removeFirst();
+                d->pendingDeadKeys.append(key);
                 key = Qt::Key_unknown;
             }
-        } else if (d->lastDeadKey != Qt::Key_unknown && key != Qt::Key_unknown) {
-            key = combineKeys(d->lastDeadKey, key);
-            d->lastDeadKey = Qt::Key_unknown;
+            composedText = QVirtualKeyboardPrivate::keyText(key, d->autoShifting, autoShifted);
+            text = &composedText;
+        } else if (!d->pendingDeadKeys.isEmpty() && key != Qt::Key_unknown) {
+            key = d->composer.compose(d->pendingDeadKeys, key);
+            d->pendingDeadKeys.clear();
+            composedText = QVirtualKeyboardPrivate::keyText(key, d->autoShifting, autoShifted);
+            text = &composedText;
         }
     }
 
-    // Generate unicode to send together with the key and apply some further
-    // fine-tuning for some keys with unpleasant behavior.
-    QString unicode = "";
-    switch (key) {
-        case Qt::Key_unknown:
-        case Qt::Key_Shift:
-        case Qt::Key_Control:
-        case Qt::Key_Alt:
-        case Qt::Key_Meta:
-        case Qt::Key_Super_L:
-        case Qt::Key_Super_R:
-        case Qt::Key_Menu:
-        case Qt::Key_CapsLock:
-        case Qt::Key_NumLock:
-        case Qt::Key_Escape: break;
-        //NOTE: Maybe there are some more keys out there which should not generate
-        //      any visible output
-        case Qt::Key_Tab: unicode = "\t"; break;
-        default: unicode = QString(key);
-    }
-
-    // Last but not least check if auto-shifting is enabled, we generate a lowercase
-    // unicode value, otherwise auto-shift was applied (because the user pressed the
-    // 'shift' modifier key), we send it uppercase. This mimics the behavior of full
-    // keyboard layouts.
-    if (d->autoShifting) {
-        d->autoShiftingMark ? unicode = unicode.toUpper() : unicode = unicode.toLower();
-        d->autoShiftingMark = false;
-    }
-    return new QKeyEvent(type, key, modifiers | d->rememberedStandardModifiers, unicode, vk.autoRepeat());
+    return QKeyEvent(type, key, modifiers | d->rememberedStandardModifiers, *text);
 }
@@ -16,10 +16,17 @@
 
 #include <QObject>
 #include <QKeyEvent>
+#include <QStringList>
+#include <QHash>
 
 #include "qvirtualkeyboardglobal.h"
 
 class QVirtualKey;
+class QVirtualKeyboardLayout;
+class QVirtualKeyRecorder;
+class QMouseEvent;
+class QTouchEvent;
+class QWidget;
 
 class QVirtualKeyboardPrivate;
 
@@ -32,8 +39,20 @@ class Q_QVK_EXPORT QVirtualKeyboard : public QObject
     Q_PROPERTY(bool autoShifting READ autoShifting WRITE setAutoShifting)
     Q_PROPERTY(bool deadKeys READ deadKeys WRITE setDeadKeys)
     Q_PROPERTY(bool capsLock READ capsLock WRITE setCapsLock)
+    Q_PROPERTY(DispatchMode dispatchMode READ dispatchMode WRITE setDispatchMode)
+    Q_PROPERTY(int autoRepeatDelay READ autoRepeatDelay WRITE setAutoRepeatDelay)
+    Q_PROPERTY(int autoRepeatInterval READ autoRepeatInterval WRITE setAutoRepeatInterval)
+    Q_PROPERTY(int batchInterval READ batchInterval WRITE setBatchInterval)
+    Q_PROPERTY(int batchSize READ batchSize WRITE setBatchSize)
+    Q_PROPERTY(int hitRadius READ hitRadius WRITE setHitRadius)
+    Q_ENUMS(DispatchMode)
+    Q_ENUMS(ModifierMode)
 
 public:
+    enum DispatchMode { EventFilterDispatch, DirectDispatch };
+    enum ModifierMode { MomentaryModifier, LatchingModifier, LockingModifier };
+    enum LatencyStage { GenerateLatency, KeyEventLatency, KeySignalLatency, TotalLatency, LatencyStageCount };
+
     explicit QVirtualKeyboard(QObject *parent = 0);
     virtual ~QVirtualKeyboard();
 
@@ -44,6 +63,14 @@ public:
     Qt::Key shiftModifier() const;
     void setAltModifier(Qt::Key modifierKey);
     Qt::Key altModifier() const;
+    bool addModifier(Qt::Key key, ModifierMode mode = MomentaryModifier);
+    void removeModifier(Qt::Key key);
+    QList<Qt::Key> modifierKeys() const;
+    ModifierMode modifierMode(Qt::Key key) const;
+    bool isModifierActive(Qt::Key key) const;
+    bool isModifierLocked(Qt::Key key) const;
+    Qt::KeyboardModifiers keyboardModifiers() const;
+    void resetModifiers();
 
     void setAutoShifting(bool enabled);
     bool autoShifting() const;
@@ -51,36 +78,114 @@ public:
     void setDeadKeys(bool enabled);
     bool deadKeys() const;
     static bool isDeadKey(Qt::Key key);
+    bool addComposeFile(const QString &fileName);
+    void clearComposeFiles();
 
     void setCapsLock(bool enabled);
     bool capsLock() const;
 
     bool setLayout(const QString &fileName);
+    bool setLayoutAsync(const QString &fileName);
+    bool isLayoutLoading() const;
+    bool preloadLayout(const QString &fileName);
+    void unloadLayout(const QString &fileName);
+    QStringList preloadedLayouts() const;
+    int layoutChangedKeys() const;
+    bool validateLayout(const QString &fileName, QStringList *errors = 0);
+
     void setLayoutVersion(int version);
     int layoutVersion() const;
     void setLayoutName(const QString &name);
     const QString layoutName() const;
 
+    QVirtualKey *keyAt(QObject *container, const QPoint &pos) const;
+    void setHitRadius(int pixels);
+    int hitRadius() const;
+    void setKeyWeights(const QHash<QString, qreal> &weights);
+    QHash<QString, qreal> keyWeights() const;
+
+    void setDispatchMode(DispatchMode mode);
+    DispatchMode dispatchMode() const;
+
+    void setAutoRepeatDelay(int msecs);
+    int autoRepeatDelay() const;
+    void setAutoRepeatInterval(int msecs);
+    int autoRepeatInterval() const;
+    void setAutoRepeatAcceleration(qreal factor, int minimumInterval);
+    qreal autoRepeatAcceleration() const;
+    int autoRepeatMinimumInterval() const;
+
+    void setBatchInterval(int msecs);
+    int batchInterval() const;
+    void setBatchSize(int events);
+    int batchSize() const;
+    void flushKeyEvents();
+
+    void setInstrumentationEnabled(bool enabled);
+    bool instrumentationEnabled() const;
+    qint64 latencyPercentile(LatencyStage stage, int percent, const QString &key = QString(), const QString &layout = QString()) const;
+    int latencySamples(const QString &key = QString(), const QString &layout = QString()) const;
+    bool dumpInstrumentation(const QString &fileName) const;
+    void resetInstrumentation();
+
+    void setGlyphCacheLimit(int kilobytes);
+    int glyphCacheLimit() const;
+    int glyphCacheSize() const;
+    int glyphCacheHits() const;
+    int glyphCacheMisses() const;
+    void clearGlyphCache();
+
     QVirtualKey *findVirtualKey(const QString &name) const;
-    static Qt::Key stringToKey(const QString &string);
+    static Qt::Key stringToKey(const QString &string, bool *ok = 0);
+    static QString keyToString(Qt::Key key);
 
 Q_SIGNALS:
     void keyEvent(QKeyEvent *);
     void keyPressed(int key, Qt::KeyboardModifiers modifiers, const QString &text);
     void keyReleased(int key, Qt::KeyboardModifiers modifiers, const QString &text);
+    void keyEventBatch(const QList<QKeyEvent> &events);
+    void modifiersChanged();
+    void layoutLoaded(const QString &fileName, bool success);
 
 protected:
     bool eventFilter(QObject *object, QEvent *event);
-    QKeyEvent *generateKeyEvent(const QVirtualKey &vk, QKeyEvent::Type type);
+    void timerEvent(QTimerEvent *event);
+    QKeyEvent generateKeyEvent(const QVirtualKey &vk, QKeyEvent::Type type);
+
+private Q_SLOTS:
+    void layoutReadFinished();
+    void virtualKeyDestroyed(QObject *object);
+    void virtualKeyRenamed();
 
 private:
     static Qt::KeyboardModifier keyToKeyboardModifier(Qt::Key key);
-    static Qt::Key deadKeyToUndeadKey(Qt::Key key);
-    static Qt::Key combineKeys(Qt::Key key1, Qt::Key key2);
+
+    void applyLayout(const QVirtualKeyboardLayout &layout);
+    void beginUpdate();
+    void endUpdate();
+    void registerKey(QVirtualKey *key);
+    void unregisterKey(QVirtualKey *key);
+    void virtualKeyPressed(QVirtualKey *vk);
+    void virtualKeyReleased(QVirtualKey *vk);
+    void deliverKeyEvent(QKeyEvent &ke, bool pressed);
+    bool redirectMouseEvent(QWidget *container, QMouseEvent *event);
+#if QT_VERSION >= 0x040600
+    void touchEvent(QWidget *container, QTouchEvent *event);
+#endif
+    void releaseTouchPoints(QObject *container);
+    bool isTouching() const;
+    QByteArray saveInputState() const;
+    bool restoreInputState(const QByteArray &state);
+    void startAutoRepeat(QVirtualKey *vk, const QKeyEvent &ke);
+    void stopAutoRepeat(QVirtualKey *vk);
+    void scheduleAutoRepeat();
+    void autoRepeat();
 
     QVirtualKeyboardPrivate *d;
 
-    friend class QVirtualKeyboardLayoutReader;
+    friend class QVirtualKey;
+    friend class QVirtualKeyPredictor;
+    friend class QVirtualKeyRecorder;
 };
 
 #endif
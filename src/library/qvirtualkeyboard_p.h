@@ -14,36 +14,221 @@
 #include <QString>
 #include <QHash>
 #include <QList>
+#include <QStringList>
+#include <QBasicTimer>
+#include <QKeyEvent>
+#include <QTime>
+#include <QVector>
+#include <QPointer>
+#include <qmath.h>
+#ifndef QT_NO_CONCURRENT
+#  include <QFutureWatcher>
+#endif
+
+#include "qvirtualkeyboardlayout_p.h"
+#include "qvirtualkeycomposer_p.h"
+#include "qvirtualkeyglyphcache_p.h"
+#include "qvirtualkeyhitindex_p.h"
+#include "qvirtualkeymodifierstate_p.h"
+#include "qvirtualkeyboardinstrumentation_p.h"
+#include "qvirtualkeypredictor.h"
+#include "qvirtualkeyrecorder.h"
 
 class QVirtualKeyboardPrivate
 {
 public:
     QVirtualKeyboardPrivate()
-        : shiftModifier(Qt::Key_Shift)
-        , altModifier(Qt::Key_AltGr)
+        : modifierState(Qt::Key_Shift, Qt::Key_AltGr)
         , rememberedStandardModifiers(Qt::NoModifier)
         , autoShifting(true)
-        , autoShiftingMark(false)
         , deadKeys(true)
         , capsLock(true)
-        , lastDeadKey(Qt::Key_unknown)
         , keyboardLayoutVersion(1)
         , keyboardLayoutName("Custom")
+        , dispatchMode(QVirtualKeyboard::EventFilterDispatch)
+        , autoRepeatDelay(300)
+        , autoRepeatInterval(100)
+        , autoRepeatMinimumInterval(100)
+        , autoRepeatAcceleration(1.0)
+        , batchInterval(0)
+        , batchSize(32)
+#ifndef QVK_NO_INSTRUMENTATION
+        , instrumentation(0)
+#endif
+        , updateDepth(0)
+        , layoutRequest(0)
+        , layoutChangedKeys(0)
+        , keyDepth(0)
+        , hitRadius(6)
+        , redirectContainer(0)
+        , keyTableRevision(0)
+        , modifierFlagsRevision(-1)
     {}
 
+    enum { ModifierCombinations = 1 << QVirtualKeyModifierState::MaximumModifiers };
+
+    struct KeyBinding
+    {
+        KeyBinding() : key(Qt::Key_unknown), autoShifted(false) {}
+
+        Qt::Key key; ///< Generated key code
+        QString text; ///< Generated text, auto-shifting is applied
+        bool autoShifted; ///< Set if auto-shift replaced a missing shift key code
+    };
+
+    // Everything generateKeyEvent() needs of a virtual key, per layer
+    struct KeyTableEntry
+    {
+        KeyTableEntry() : key(0), keyRevision(-1), tableRevision(-1), modifierIndex(-1) {}
+
+        const QVirtualKey *key; ///< Owner of the entry, 0 for a free entry
+        int keyRevision; ///< QVirtualKeyPrivate::bindingRevision the entry was built with
+        int tableRevision; ///< keyTableRevision the entry was built with
+        int modifierIndex; ///< Index in modifierState if the key is a modifier, otherwise -1
+        KeyBinding layers[QVirtualKeyboardLayout::LayerCount];
+    };
+
+    static Qt::KeyboardModifier keyToKeyboardModifier(Qt::Key key);
+    static QString keyText(Qt::Key key, bool autoShifting, bool upper);
+    void buildKeyTableEntry(const QVirtualKey &vk, KeyTableEntry *entry) const;
+    const KeyTableEntry &keyTableEntry(const QVirtualKey &vk, KeyTableEntry *scratch);
+    void assignKeyId(QVirtualKey *key);
+    void releaseKeyId(QVirtualKey *key);
+    void updateModifierFlags();
+
+    // Called when the auto-shifting or modifier configuration changes
+    void invalidateKeyTable() { ++keyTableRevision; }
+
+    struct PendingKeyEvent
+    {
+        PendingKeyEvent(const QKeyEvent &event, bool pressed) : event(event), pressed(pressed) {}
+
+        QKeyEvent event;
+        bool pressed; ///< Set if keyPressed() is emitted for the event, otherwise keyReleased()
+    };
+
+    struct RepeatingKey
+    {
+        RepeatingKey(QVirtualKey *key, const QKeyEvent &event, int due)
+            : key(key)
+            , press(QEvent::KeyPress, event.key(), event.modifiers(), event.text(), true)
+            , release(QEvent::KeyRelease, event.key(), event.modifiers(), event.text(), true)
+            , due(due)
+            , repeats(0)
+        {}
+
+        QVirtualKey *key;
+        QKeyEvent press; ///< Precomputed repeated press
+        QKeyEvent release; ///< Precomputed repeated release, sent before the press
+        int due; ///< Time of the next repetition on repeatClock
+        int repeats; ///< Number of repetitions so far
+    };
+
+    int autoRepeatIntervalAfter(int repeats) const
+    {
+        const qreal interval = autoRepeatInterval * qPow(autoRepeatAcceleration, repeats);
+        return qMax(qMin(autoRepeatMinimumInterval, autoRepeatInterval), qMin(autoRepeatInterval, qRound(interval)));
+    }
+
+    // Result of reading a layout file for setLayoutAsync()
+    struct LayoutRead
+    {
+        LayoutRead() : request(0), ok(false) {}
+
+        QString fileName;
+        int request; ///< Value of layoutRequest when the read was started
+        bool ok;
+        QVirtualKeyboardLayout layout;
+    };
+
+    const QVirtualKeyboardLayout *preloadedLayout(const QString &fileName) const
+    {
+        QHash<QString, QVirtualKeyboardLayout>::const_iterator it = layoutCache.constFind(fileName);
+        if (it != layoutCache.constEnd())
+            return &it.value();
+        for (it = layoutCache.constBegin(); it != layoutCache.constEnd(); ++it) {
+            if (it.value().name == fileName)
+                return &it.value();
+        }
+        return 0;
+    }
+
+    // A press of a printable character directly followed by its release
+    static bool isPrintablePair(const PendingKeyEvent &press, const PendingKeyEvent &release)
+    {
+        return press.pressed && !release.pressed
+            && press.event.type() == QEvent::KeyPress && release.event.type() == QEvent::KeyRelease
+            && press.event.key() == release.event.key() && press.event.modifiers() == release.event.modifiers()
+            && !press.event.text().isEmpty() && press.event.text().at(0).isPrint();
+    }
+
+    // Name a registered virtual key is indexed under
+    struct IndexedKey
+    {
+        QString name; ///< Object name at the time it was indexed, empty if it had none
+        int references; ///< Number of key containers the key is registered with
+    };
+
+    void indexVirtualKey(QVirtualKey *key);
+    void unindexVirtualKey(const QObject *key);
+    void reindexVirtualKey(QVirtualKey *key);
+    void indexNamedKeys();
+    QVirtualKey *indexedVirtualKey(const QString &name) const;
+
     QHash<QObject *, QList<QVirtualKey *> > virtualKeyHash;
-    QHash<Qt::Key, int> currentModifierHash;
+    QMultiHash<QString, QVirtualKey *> virtualKeyIndex; ///< Registered virtual keys by object name
+    QHash<const QObject *, IndexedKey> indexedKeys; ///< Index entries of the registered virtual keys
+    QList<QVirtualKey *> unnamedKeys; ///< Registered virtual keys which had no object name yet
+    QHash<QString, QVirtualKeyboardLayout> layoutCache; ///< Preloaded layouts by file name
 
-    Qt::Key shiftModifier; ///< Stores the current 'shift' modifier
-    Qt::Key altModifier; ///< Stores the current 'alt' modifier
+    QVirtualKeyModifierState modifierState; ///< 'shift', 'alt' and additional modifiers
     Qt::KeyboardModifiers rememberedStandardModifiers;
 
     uint autoShifting : 1; ///< Determines if auto-shifting is enabled
-    uint autoShiftingMark : 1; ///< Temporary marker for internal use
     uint deadKeys : 1; ///< Determines if dead keys are enabled
     uint capsLock : 1; ///< Determines if caps-lock behavior is enabled
 
-    Qt::Key lastDeadKey; ///< Stores the last dead key for internal use
+    QList<Qt::Key> pendingDeadKeys; ///< Dead keys pressed since the last normal key
+    QVirtualKeyComposer composer; ///< Dead key composition table
+    QStringList composeFiles; ///< Compose files added with addComposeFile()
+    QString layoutComposeFile; ///< Compose file of the current layout
+    QVirtualKeyGlyphCache glyphCache; ///< Rasterized labels shared by all registered keys
     int keyboardLayoutVersion; ///< Information about the current layout
     QString keyboardLayoutName; ///< Information about the current layout
+    QVirtualKeyboard::DispatchMode dispatchMode; ///< How virtual keys report presses
+    int autoRepeatDelay; ///< Milliseconds until a held key repeats
+    int autoRepeatInterval; ///< Milliseconds between the first repetitions
+    int autoRepeatMinimumInterval; ///< Shortest interval reached by acceleration
+    qreal autoRepeatAcceleration; ///< Factor applied to the interval after every repetition
+    QList<RepeatingKey> repeatingKeys; ///< Held keys which repeat
+    QBasicTimer repeatTimer; ///< Fires when the next held key is due
+    QTime repeatClock; ///< Time base of RepeatingKey::due
+    int batchInterval; ///< Milliseconds key events are queued, 0 for immediate delivery
+    int batchSize; ///< Maximum number of queued key events
+    QList<PendingKeyEvent> pendingKeyEvents; ///< Key events queued by batched delivery
+    QBasicTimer batchTimer; ///< Sends the queued key events
+#ifndef QVK_NO_INSTRUMENTATION
+    QVirtualKeyboardInstrumentation *instrumentation; ///< Latency histograms, only set if enabled
+#endif
+    int updateDepth; ///< Nesting level of beginUpdate()
+    int layoutRequest; ///< Incremented by every layout change, outdates running reads
+    QString loadingLayout; ///< File name read by setLayoutAsync(), empty if none is running
+    int layoutChangedKeys; ///< Virtual keys changed by the last applyLayout()
+    QString layoutFile; ///< File or preloaded layout name the current layout was set with
+    QPointer<QVirtualKeyRecorder> recorder; ///< Records the virtual key presses, if set
+    QList<QPointer<QVirtualKeyPredictor> > predictors; ///< Fed with the key presses of a keyEventBatch()
+    int keyDepth; ///< Nesting level of virtual key press and release handling
+
+    QVirtualKeyHitIndex hitIndex; ///< Nearest key lookup for presses between keys
+    int hitRadius; ///< Maximum distance of a press to the key it is redirected to
+    QHash<QString, qreal> keyWeights; ///< Weights of keys by lower case text for hit resolution
+    QPointer<QVirtualKey> redirectedKey; ///< Key receiving the mouse events of a container press
+    QObject *redirectContainer; ///< Container whose mouse events are redirected
+    QHash<int, QPointer<QVirtualKey> > touchKeys; ///< Keys pressed by touch points, by touch point id
+
+    QVector<KeyTableEntry> keyTable; ///< Precomputed layers of the registered keys, by key id
+    QList<int> freeKeyIds; ///< Unused entries of keyTable
+    int keyTableRevision; ///< Incremented when all entries of keyTable are outdated
+    Qt::KeyboardModifiers modifierFlags[ModifierCombinations]; ///< Event modifiers by active modifier mask
+    int modifierFlagsRevision; ///< keyTableRevision modifierFlags were computed with
 };
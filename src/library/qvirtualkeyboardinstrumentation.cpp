@@ -0,0 +1,289 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include "qvirtualkeyboardinstrumentation_p.h"
+
+#ifndef QVK_NO_INSTRUMENTATION
+
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+
+static inline int atomicValue(const QAtomicInt &value)
+{
+#if QT_VERSION >= 0x050000
+    return value.load();
+#else
+    return value;
+#endif
+}
+
+/*!
+    \internal
+    \class QVirtualKeyLatencyHistogram qvirtualkeyboardinstrumentation_p.h
+    \brief Lock-free histogram of latencies in microseconds.
+
+    The buckets grow logarithmically with four buckets per power of two, so
+    a percentile read from the histogram is at most 25% above the real value.
+    Recording is a single atomic increment, the histogram can be read while
+    the keyboard records into it.
+*/
+
+/*!
+    \internal
+    \brief Constructs an empty histogram.
+*/
+QVirtualKeyLatencyHistogram::QVirtualKeyLatencyHistogram()
+{
+}
+
+/*!
+    \internal
+    \brief Counts one sample of \a microseconds.
+*/
+void QVirtualKeyLatencyHistogram::record(qint64 microseconds)
+{
+    buckets[bucket(microseconds)].fetchAndAddRelaxed(1);
+}
+
+/*!
+    \internal
+    \brief Adds the samples of all buckets to the \a buckets array of BucketCount elements.
+*/
+void QVirtualKeyLatencyHistogram::addTo(int *buckets) const
+{
+    for (int i = 0; i < BucketCount; ++i)
+        buckets[i] += atomicValue(this->buckets[i]);
+}
+
+/*!
+    \internal
+    \brief Drops all samples.
+*/
+void QVirtualKeyLatencyHistogram::reset()
+{
+    for (int i = 0; i < BucketCount; ++i)
+        buckets[i].fetchAndStoreRelaxed(0);
+}
+
+/*!
+    \internal
+    \brief Returns the bucket of \a microseconds.
+
+    Values below 4 have a bucket each, larger values are split into four
+    buckets per power of two by the two bits below the highest set bit.
+*/
+int QVirtualKeyLatencyHistogram::bucket(qint64 microseconds)
+{
+    if (microseconds < 4)
+        return qMax(qint64(0), microseconds);
+    microseconds = qMin(microseconds, qint64(0x7fffffff));
+
+    int msb = 2;
+    while (microseconds >> (msb + 1))
+        ++msb;
+    return (msb - 1) * 4 + int((microseconds >> (msb - 2)) & 3);
+}
+
+/*!
+    \internal
+    \brief Returns the largest value in microseconds which falls into \a bucket.
+*/
+qint64 QVirtualKeyLatencyHistogram::bucketLimit(int bucket)
+{
+    if (bucket < 4)
+        return bucket;
+    const int msb = bucket / 4 + 1;
+    return (qint64(5 + bucket % 4) << (msb - 2)) - 1;
+}
+
+/*!
+    \internal
+    \brief Returns the \a percent percentile of the \a buckets in microseconds, or -1
+           if there are no samples.
+*/
+qint64 QVirtualKeyLatencyHistogram::percentile(const int *buckets, int percent)
+{
+    qint64 samples = 0;
+    for (int i = 0; i < BucketCount; ++i)
+        samples += buckets[i];
+    if (samples == 0)
+        return -1;
+
+    const qint64 rank = qMax(qint64(1), (samples * qBound(0, percent, 100) + 99) / 100);
+    qint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank)
+            return bucketLimit(i);
+    }
+    return bucketLimit(BucketCount - 1);
+}
+
+/*!
+    \internal
+    \class QVirtualKeyboardInstrumentation qvirtualkeyboardinstrumentation_p.h
+    \brief Latency histograms of the key event dispatch of a virtual keyboard.
+
+    The virtual keyboard calls begin() when a press or release of a virtual key
+    arrives, generated() when the key event is produced, keyEventDelivered() when
+    the keyEvent() signal returned and end() when the keyPressed() or keyReleased()
+    signal returned. The histograms are kept per layout and per key name, only
+    the keyboard thread adds new keys and layouts.
+
+    \sa QVirtualKeyboard::setInstrumentationEnabled()
+*/
+
+/*!
+    \internal
+    \brief Constructs an instrumentation without samples.
+*/
+QVirtualKeyboardInstrumentation::QVirtualKeyboardInstrumentation()
+    : current(0)
+    , generatedAt(0)
+    , deliveredAt(0)
+{
+}
+
+/*!
+    \internal
+    \brief Destroys the histograms.
+*/
+QVirtualKeyboardInstrumentation::~QVirtualKeyboardInstrumentation()
+{
+    foreach (const KeyTable &keys, layouts)
+        qDeleteAll(keys);
+}
+
+/*!
+    \internal
+    \brief Starts timing the dispatch of \a key in \a layout.
+*/
+void QVirtualKeyboardInstrumentation::begin(const QString &key, const QString &layout)
+{
+    timer.start();
+    generatedAt = deliveredAt = 0;
+
+    KeyTable &keys = layouts[layout];
+    Histograms *&histograms = keys[key];
+    if (!histograms)
+        histograms = new Histograms;
+    current = histograms;
+}
+
+/*!
+    \internal
+    \brief Records the latencies of the dispatch started by begin().
+*/
+void QVirtualKeyboardInstrumentation::end()
+{
+    if (!current)
+        return;
+
+    const qint64 endedAt = timer.nsecsElapsed();
+    current->stages[QVirtualKeyboard::GenerateLatency].record(generatedAt / 1000);
+    current->stages[QVirtualKeyboard::KeyEventLatency].record((deliveredAt - generatedAt) / 1000);
+    current->stages[QVirtualKeyboard::KeySignalLatency].record((endedAt - deliveredAt) / 1000);
+    current->stages[QVirtualKeyboard::TotalLatency].record(endedAt / 1000);
+    current = 0;
+}
+
+/*!
+    \internal
+    \brief Adds the samples of \a stage to \a buckets.
+
+    Only the samples of \a key and \a layout are added, an empty string matches
+    all keys or layouts.
+*/
+void QVirtualKeyboardInstrumentation::collect(QVirtualKeyboard::LatencyStage stage, const QString &key, const QString &layout, int *buckets) const
+{
+    for (QHash<QString, KeyTable>::const_iterator it = layouts.constBegin(); it != layouts.constEnd(); ++it) {
+        if (!layout.isEmpty() && it.key() != layout)
+            continue;
+        if (!key.isEmpty()) {
+            if (const Histograms *histograms = it.value().value(key))
+                histograms->stages[stage].addTo(buckets);
+        } else {
+            foreach (const Histograms *histograms, it.value())
+                histograms->stages[stage].addTo(buckets);
+        }
+    }
+}
+
+/*!
+    \internal
+    \brief Writes the samples and percentiles per layout and key to \a fileName.
+
+    The file has one tab separated line per layout and key: the layout name,
+    the key name, the number of dispatched events and p50, p95 and p99 in
+    microseconds for every stage.
+*/
+bool QVirtualKeyboardInstrumentation::dump(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
+        return false;
+
+    static const char *stageNames[] = { "generate", "keyEvent", "keySignal", "total" };
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    stream << "# layout\tkey\tevents";
+    for (int stage = 0; stage < QVirtualKeyboard::LatencyStageCount; ++stage)
+        stream << '\t' << stageNames[stage] << ".p50\t" << stageNames[stage] << ".p95\t" << stageNames[stage] << ".p99";
+    stream << '\n';
+
+    QStringList layoutNames = layouts.keys();
+    qSort(layoutNames);
+    foreach (const QString &layout, layoutNames) {
+        const KeyTable &keys = layouts[layout];
+        QStringList keyNames = keys.keys();
+        qSort(keyNames);
+        foreach (const QString &key, keyNames) {
+            const Histograms *histograms = keys.value(key);
+            int events = 0;
+            stream << layout << '\t' << key;
+            for (int stage = 0; stage < QVirtualKeyboard::LatencyStageCount; ++stage) {
+                int buckets[QVirtualKeyLatencyHistogram::BucketCount] = { 0 };
+                histograms->stages[stage].addTo(buckets);
+                if (stage == 0) {
+                    for (int i = 0; i < QVirtualKeyLatencyHistogram::BucketCount; ++i)
+                        events += buckets[i];
+                    stream << '\t' << events;
+                }
+                stream << '\t' << QVirtualKeyLatencyHistogram::percentile(buckets, 50)
+                       << '\t' << QVirtualKeyLatencyHistogram::percentile(buckets, 95)
+                       << '\t' << QVirtualKeyLatencyHistogram::percentile(buckets, 99);
+            }
+            stream << '\n';
+        }
+    }
+
+    stream.flush();
+    return file.error() == QFile::NoError;
+}
+
+/*!
+    \internal
+    \brief Drops all samples.
+*/
+void QVirtualKeyboardInstrumentation::reset()
+{
+    foreach (const KeyTable &keys, layouts) {
+        foreach (Histograms *histograms, keys) {
+            for (int stage = 0; stage < QVirtualKeyboard::LatencyStageCount; ++stage)
+                histograms->stages[stage].reset();
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,80 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#ifndef QVIRTUALKEYBOARDINSTRUMENTATION_P_H
+#define QVIRTUALKEYBOARDINSTRUMENTATION_P_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QString>
+
+#include "qvirtualkeyboard.h"
+
+#ifndef QVK_NO_INSTRUMENTATION
+
+#include <QElapsedTimer>
+
+class QVirtualKeyLatencyHistogram
+{
+public:
+    enum { BucketCount = 124 };
+
+    QVirtualKeyLatencyHistogram();
+
+    void record(qint64 microseconds);
+    void addTo(int *buckets) const;
+    void reset();
+
+    static int bucket(qint64 microseconds);
+    static qint64 bucketLimit(int bucket);
+    static qint64 percentile(const int *buckets, int percent);
+
+private:
+    QAtomicInt buckets[BucketCount];
+};
+
+class QVirtualKeyboardInstrumentation
+{
+public:
+    QVirtualKeyboardInstrumentation();
+    ~QVirtualKeyboardInstrumentation();
+
+    void begin(const QString &key, const QString &layout);
+    void generated() { generatedAt = timer.nsecsElapsed(); }
+    void keyEventDelivered() { deliveredAt = timer.nsecsElapsed(); }
+    void end();
+
+    void collect(QVirtualKeyboard::LatencyStage stage, const QString &key, const QString &layout, int *buckets) const;
+    bool dump(const QString &fileName) const;
+    void reset();
+
+private:
+    struct Histograms
+    {
+        QVirtualKeyLatencyHistogram stages[QVirtualKeyboard::LatencyStageCount];
+    };
+    typedef QHash<QString, Histograms *> KeyTable;
+
+    QHash<QString, KeyTable> layouts; ///< Histograms per layout and per key name
+    Histograms *current; ///< Histograms of the key being dispatched
+    QElapsedTimer timer; ///< Started when a press or release arrives
+    qint64 generatedAt;
+    qint64 deliveredAt;
+};
+
+#  define QVK_TRACE(call) do { if (d->instrumentation) d->instrumentation->call; } while (0)
+#else
+#  define QVK_TRACE(call) do {} while (0)
+#endif
+
+#endif
@@ -0,0 +1,430 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include "qvirtualkeyboardlayout_p.h"
+#include "qvirtualkeyboardlayoutreader.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QHash>
+#include <QVector>
+#include <QtEndian>
+#include <QObject>
+
+/*
+    Compiled layout format (all integers are 32 bit little endian):
+
+    Header      "QVKL", format version, layout version, name string, compose file string,
+                entry count, entry table offset, string count, string table offset
+    Entry       name string, then for each layer: flags, key, text string, icon string
+    Strings     offset table followed by (length, UTF-16LE data) records, each
+                record padded to 4 bytes. String 0 is always the empty string.
+*/
+
+static const char compiledMagic[4] = { 'Q', 'V', 'K', 'L' };
+static const quint32 compiledFormatVersion = 2;
+static const int compiledHeaderSize = 9 * 4;
+static const int compiledEntrySize = 4 + QVirtualKeyboardLayout::LayerCount * 4 * 4;
+
+enum CompiledBindingFlag { BindingDefined = 0x1 };
+
+static inline quint32 readUInt32(const uchar *data)
+{
+    return qFromLittleEndian<quint32>(data);
+}
+
+static inline void appendUInt32(QByteArray &data, quint32 value)
+{
+    uchar buffer[4];
+    qToLittleEndian<quint32>(value, buffer);
+    data.append(reinterpret_cast<const char *>(buffer), 4);
+}
+
+static inline void writeUInt32(QByteArray &data, int offset, quint32 value)
+{
+    qToLittleEndian<quint32>(value, reinterpret_cast<uchar *>(data.data() + offset));
+}
+
+/*!
+    \internal
+    \class QVirtualKeyboardLayout qvirtualkeyboardlayout_p.h
+    \brief In-memory representation of a virtual keyboard layout.
+
+    A layout is either read from a layout XML file (see QVirtualKeyboardLayoutReader)
+    or from a compiled layout file created by the \c qvkmc tool. Compiled layouts
+    contain already resolved key codes and text fallbacks and are memory mapped
+    while being read, so no XML parsing is involved.
+
+    \sa QVirtualKeyboard::setLayout()
+*/
+
+bool QVirtualKeyboardLayout::Binding::operator==(const Binding &other) const
+{
+    return defined == other.defined && key == other.key && text == other.text && icon == other.icon;
+}
+
+bool QVirtualKeyboardLayout::Entry::operator==(const Entry &other) const
+{
+    if (name != other.name)
+        return false;
+    for (int layer = 0; layer < LayerCount; ++layer) {
+        if (bindings[layer] != other.bindings[layer])
+            return false;
+    }
+    return true;
+}
+
+/*!
+    \internal
+    \brief Constructs an empty layout.
+*/
+QVirtualKeyboardLayout::QVirtualKeyboardLayout()
+    : version(1)
+{
+}
+
+/*!
+    \internal
+    \brief Loads the layout file \a fileName, which may be either a layout XML
+           file or a compiled layout.
+
+    Compiled layouts are memory mapped if the underlying file engine supports
+    it, otherwise they are read into memory at once.
+*/
+bool QVirtualKeyboardLayout::load(const QString &fileName, QString *errorString)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        if (errorString)
+            *errorString = QObject::tr("Unable to open keyboard layout: %1").arg(file.errorString());
+        return false;
+    }
+
+    bool ok;
+    const qint64 size = file.size();
+    uchar *mapped = size > 0 ? file.map(0, size) : 0;
+    char magic[sizeof(compiledMagic)];
+    if (mapped) {
+        if (isCompiled(mapped, size)) {
+            ok = readCompiled(mapped, size, errorString);
+            file.unmap(mapped);
+        } else {
+            file.unmap(mapped);
+            ok = readXml(&file, errorString);
+        }
+    } else if (file.peek(magic, sizeof(magic)) == sizeof(magic)
+               && isCompiled(reinterpret_cast<const uchar *>(magic), sizeof(magic))) {
+        const QByteArray data = file.readAll();
+        ok = readCompiled(reinterpret_cast<const uchar *>(data.constData()), data.size(), errorString);
+    } else {
+        ok = readXml(&file, errorString);
+    }
+
+    // The compose file is stored relative to the layout file
+    if (ok && !composeFile.isEmpty() && QFileInfo(composeFile).isRelative())
+        composeFile = QFileInfo(fileName).dir().filePath(composeFile);
+    return ok;
+}
+
+/*!
+    \internal
+    \brief Reads a layout XML file from \a device.
+
+    \sa QVirtualKeyboardLayoutReader
+*/
+bool QVirtualKeyboardLayout::readXml(QIODevice *device, QString *errorString)
+{
+    QVirtualKeyboardLayoutReader reader(this);
+    if (!reader.read(device)) {
+        if (errorString)
+            *errorString = reader.errorString();
+        return false;
+    }
+    return true;
+}
+
+/*!
+    \internal
+    \brief Validates the layout XML file \a fileName in strict mode and returns
+           true if it has no errors.
+
+    The errors are appended to \a errors formatted as \c {line:column: message},
+    errors which concern the whole file are reported at line and column 0.
+    If \a keyNames is not empty, virtual keys not contained in it are reported.
+    Compiled layouts are checked for being readable and against \a keyNames, their
+    errors are reported at line and column 0 as they carry no positions. If \a layout is not null,
+    the layout read is stored in it, so validating and compiling a layout needs only
+    one pass over the file. Unlike load(), the compose file is kept as the file
+    gives it, so a compiled layout resolves it relative to itself when loaded.
+
+    \sa QVirtualKeyboardLayoutReader::setStrict()
+*/
+bool QVirtualKeyboardLayout::validate(const QString &fileName, QStringList *errors, const QSet<QString> &keyNames,
+                                      QVirtualKeyboardLayout *layout)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        if (errors)
+            errors->append(QLatin1String("0:0: ") + QObject::tr("Unable to open keyboard layout: %1").arg(file.errorString()));
+        return false;
+    }
+
+    QVirtualKeyboardLayout scratch;
+    if (!layout)
+        layout = &scratch;
+
+    char magic[sizeof(compiledMagic)];
+    if (file.peek(magic, sizeof(magic)) == sizeof(magic)
+            && isCompiled(reinterpret_cast<const uchar *>(magic), sizeof(magic))) {
+        const QByteArray data = file.readAll();
+        QString errorString;
+        if (!layout->readCompiled(reinterpret_cast<const uchar *>(data.constData()), data.size(), &errorString)) {
+            if (errors)
+                errors->append(QLatin1String("0:0: ") + errorString);
+            return false;
+        }
+        bool ok = true;
+        if (!keyNames.isEmpty()) {
+            foreach (const Entry &entry, layout->entries) {
+                if (!keyNames.contains(entry.name)) {
+                    if (errors)
+                        errors->append(QLatin1String("0:0: ")
+                                       + QObject::tr("There is no virtual key named '%1'.").arg(entry.name));
+                    ok = false;
+                }
+            }
+        }
+        return ok;
+    }
+
+    QVirtualKeyboardLayoutReader reader(layout);
+    reader.setStrict(true);
+    reader.setKeyNames(keyNames);
+    const bool ok = reader.read(&file);
+    if (errors)
+        *errors += reader.validationErrors();
+    return ok;
+}
+
+/*!
+    \internal
+    \brief Checks wether \a data starts with the compiled layout signature.
+*/
+bool QVirtualKeyboardLayout::isCompiled(const uchar *data, qint64 size)
+{
+    return data && size >= qint64(sizeof(compiledMagic))
+        && qstrncmp(reinterpret_cast<const char *>(data), compiledMagic, sizeof(compiledMagic)) == 0;
+}
+
+/*!
+    \internal
+    \brief Returns the file name a compiled version of the layout XML file
+           \a fileName is expected at, i.e. \c numbers.qvkm becomes \c numbers.qvkc.
+*/
+QString QVirtualKeyboardLayout::compiledFileName(const QString &fileName)
+{
+    QFileInfo info(fileName);
+    QString compiled = info.completeBaseName() + QLatin1String(".qvkc");
+    if (info.path() != QLatin1String("."))
+        compiled.prepend(info.path() + QLatin1Char('/'));
+    return compiled;
+}
+
+/*!
+    \internal
+    \brief Returns the name of the XML element describing \a layer.
+*/
+const char *QVirtualKeyboardLayout::layerElementName(Layer layer)
+{
+    switch (layer) {
+        case DefaultLayer: return "default";
+        case ShiftLayer: return "shift";
+        case AltLayer: return "alt";
+        case AltShiftLayer: return "altshift";
+        default: return "";
+    }
+}
+
+/*!
+    \internal
+    \brief Reads a compiled layout of \a size bytes at \a data.
+
+    All offsets are checked against \a size, a truncated or otherwise corrupt
+    file is rejected as a whole.
+*/
+bool QVirtualKeyboardLayout::readCompiled(const uchar *data, qint64 size, QString *errorString)
+{
+    if (!isCompiled(data, size) || size < compiledHeaderSize) {
+        if (errorString)
+            *errorString = QObject::tr("The file is not a compiled virtual keyboard layout file.");
+        return false;
+    }
+    if (readUInt32(data + 4) != compiledFormatVersion) {
+        if (errorString)
+            *errorString = QObject::tr("Unsupported compiled layout format version %1.").arg(readUInt32(data + 4));
+        return false;
+    }
+
+    const quint32 entryCount = readUInt32(data + 20);
+    const quint32 entryOffset = readUInt32(data + 24);
+    const quint32 stringCount = readUInt32(data + 28);
+    const quint32 stringOffset = readUInt32(data + 32);
+
+    if (stringCount == 0
+        || quint64(stringOffset) + quint64(stringCount) * 4 > quint64(size)
+        || quint64(entryOffset) + quint64(entryCount) * compiledEntrySize > quint64(size)) {
+        if (errorString)
+            *errorString = QObject::tr("The compiled layout file is truncated.");
+        return false;
+    }
+
+    // Resolve the string table once, entries share the strings implicitly
+    QVector<QString> strings(stringCount);
+    for (quint32 i = 0; i < stringCount; ++i) {
+        const quint32 offset = readUInt32(data + stringOffset + i * 4);
+        const quint32 length = quint64(offset) + 4 <= quint64(size) ? readUInt32(data + offset) : 0;
+        if (quint64(offset) + 4 + quint64(length) * 2 > quint64(size)) {
+            if (errorString)
+                *errorString = QObject::tr("The compiled layout file is truncated.");
+            return false;
+        }
+        const uchar *chars = data + offset + 4;
+        QString string;
+        string.resize(length);
+        QChar *out = string.data();
+        for (quint32 c = 0; c < length; ++c)
+            out[c] = QChar(qFromLittleEndian<quint16>(chars + c * 2));
+        strings[i] = string;
+    }
+
+    // String indices are checked like the offsets, the layout is only changed
+    // once the whole file was read
+    const quint32 nameIndex = readUInt32(data + 12);
+    const quint32 composeIndex = readUInt32(data + 16);
+    bool valid = nameIndex < stringCount && composeIndex < stringCount;
+
+    QList<Entry> compiledEntries;
+    for (quint32 i = 0; valid && i < entryCount; ++i) {
+        const uchar *record = data + entryOffset + i * compiledEntrySize;
+        Entry entry;
+        const quint32 entryName = readUInt32(record);
+        valid = entryName < stringCount;
+        entry.name = strings.value(entryName);
+        record += 4;
+        for (int layer = 0; valid && layer < LayerCount; ++layer, record += 16) {
+            const quint32 text = readUInt32(record + 8);
+            const quint32 icon = readUInt32(record + 12);
+            valid = text < stringCount && icon < stringCount;
+            Binding &binding = entry.bindings[layer];
+            binding.defined = readUInt32(record) & BindingDefined;
+            binding.key = Qt::Key(readUInt32(record + 4));
+            binding.text = strings.value(text);
+            binding.icon = strings.value(icon);
+        }
+        compiledEntries.append(entry);
+    }
+    if (!valid) {
+        if (errorString)
+            *errorString = QObject::tr("The compiled layout file is corrupt.");
+        return false;
+    }
+
+    name = strings.at(nameIndex);
+    composeFile = strings.at(composeIndex);
+    version = int(readUInt32(data + 8));
+    entries = compiledEntries;
+    return true;
+}
+
+/*!
+    \internal
+    \brief Serializes the layout into the compiled layout format.
+
+    Identical strings (for example icon file names shared by several keys) are
+    stored only once.
+*/
+QByteArray QVirtualKeyboardLayout::toCompiled() const
+{
+    QHash<QString, quint32> stringIndex;
+    QList<QString> strings;
+    strings.append(QString());
+    stringIndex.insert(QString(), 0);
+
+    // Intern all strings first, the entry table refers to them by index
+    QVector<quint32> entryStrings;
+    for (int i = 0; i < entries.count(); ++i) {
+        const Entry &entry = entries.at(i);
+        QList<QString> values;
+        values << entry.name;
+        for (int layer = 0; layer < LayerCount; ++layer)
+            values << entry.bindings[layer].text << entry.bindings[layer].icon;
+        foreach (const QString &value, values) {
+            if (!stringIndex.contains(value)) {
+                stringIndex.insert(value, strings.count());
+                strings.append(value);
+            }
+            entryStrings.append(stringIndex.value(value));
+        }
+    }
+    foreach (const QString &value, QList<QString>() << name << composeFile) {
+        if (!stringIndex.contains(value)) {
+            stringIndex.insert(value, strings.count());
+            strings.append(value);
+        }
+    }
+
+    const quint32 entryOffset = compiledHeaderSize;
+    const quint32 stringOffset = entryOffset + entries.count() * compiledEntrySize;
+
+    QByteArray data;
+    data.append(compiledMagic, sizeof(compiledMagic));
+    appendUInt32(data, compiledFormatVersion);
+    appendUInt32(data, quint32(version));
+    appendUInt32(data, stringIndex.value(name));
+    appendUInt32(data, stringIndex.value(composeFile));
+    appendUInt32(data, entries.count());
+    appendUInt32(data, entryOffset);
+    appendUInt32(data, strings.count());
+    appendUInt32(data, stringOffset);
+
+    int next = 0;
+    for (int i = 0; i < entries.count(); ++i) {
+        const Entry &entry = entries.at(i);
+        appendUInt32(data, entryStrings.at(next++));
+        for (int layer = 0; layer < LayerCount; ++layer) {
+            const Binding &binding = entry.bindings[layer];
+            appendUInt32(data, binding.defined ? BindingDefined : 0);
+            appendUInt32(data, quint32(binding.key));
+            appendUInt32(data, entryStrings.at(next++));
+            appendUInt32(data, entryStrings.at(next++));
+        }
+    }
+
+    // Reserve the offset table, it is filled while the records are appended
+    const int offsetTable = data.size();
+    data.append(QByteArray(strings.count() * 4, '\0'));
+    for (int i = 0; i < strings.count(); ++i) {
+        const QString &string = strings.at(i);
+        writeUInt32(data, offsetTable + i * 4, data.size());
+        appendUInt32(data, string.length());
+        for (int c = 0; c < string.length(); ++c) {
+            uchar buffer[2];
+            qToLittleEndian<quint16>(string.at(c).unicode(), buffer);
+            data.append(reinterpret_cast<const char *>(buffer), 2);
+        }
+        while (data.size() % 4)
+            data.append('\0');
+    }
+    return data;
+}
@@ -0,0 +1,73 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#ifndef QVIRTUALKEYBOARDLAYOUT_P_H
+#define QVIRTUALKEYBOARDLAYOUT_P_H
+
+#include <QString>
+#include <QList>
+#include <QByteArray>
+#include <QSet>
+#include <QStringList>
+
+#include "qvirtualkeyboardglobal.h"
+
+class QIODevice;
+
+class Q_QVK_EXPORT QVirtualKeyboardLayout
+{
+public:
+    enum Layer { DefaultLayer, ShiftLayer, AltLayer, AltShiftLayer, LayerCount };
+
+    struct Binding
+    {
+        Binding() : defined(false), key(Qt::Key_unknown) {}
+        bool operator==(const Binding &other) const;
+        bool operator!=(const Binding &other) const { return !operator==(other); }
+
+        bool defined; ///< Set if the layout file contains the element for this layer
+        Qt::Key key; ///< Resolved key code
+        QString text; ///< Displayed text, the fallback from 'key' is already applied
+        QString icon; ///< Icon file name, empty for no icon
+    };
+
+    struct Entry
+    {
+        bool operator==(const Entry &other) const;
+        bool operator!=(const Entry &other) const { return !operator==(other); }
+
+        QString name; ///< Object name of the virtual key
+        Binding bindings[LayerCount];
+    };
+
+    QVirtualKeyboardLayout();
+
+    bool load(const QString &fileName, QString *errorString = 0);
+    bool readXml(QIODevice *device, QString *errorString = 0);
+    bool readCompiled(const uchar *data, qint64 size, QString *errorString = 0);
+    QByteArray toCompiled() const;
+
+    static bool validate(const QString &fileName, QStringList *errors, const QSet<QString> &keyNames = QSet<QString>(),
+                         QVirtualKeyboardLayout *layout = 0);
+    static bool isCompiled(const uchar *data, qint64 size);
+    static QString compiledFileName(const QString &fileName);
+
+    static const char *layerElementName(Layer layer);
+
+    QString name;
+    int version;
+    QString composeFile; ///< Compose sequences of the layout, relative to the layout file
+    QList<Entry> entries;
+};
+
+#endif
@@ -13,43 +13,104 @@
 
 #include "qvirtualkeyboardlayoutreader.h"
 #include "qvirtualkeyboard.h"
-#include "qvirtualkey.h"
 
-#include <QIcon>
+static const char * const layoutAttributes[] = { "version", "name", "compose", 0 };
+static const char * const keyAttributes[] = { "name", 0 };
+static const char * const bindingAttributes[] = { "key", "text", "icon", 0 };
 
 /*!
     \internal
     \class QVirtualKeyboardLayoutReader qvirtualkeyboardlayoutreader.h
-    \brief
+    \brief Reads a virtual keyboard layout XML file into a QVirtualKeyboardLayout.
     \mainclass
 
-    \sa QXmlStreamReader
+    By default the reader is lenient: unknown elements are skipped and keys
+    which cannot be resolved are bound to Qt::Key_unknown. In strict mode the
+    file is validated in the same pass and every deviation from the layout
+    format is reported with its line and column by validationErrors():
+
+    \list
+    \o unknown elements and attributes,
+    \o an invalid layout version,
+    \o virtual keys without name, duplicate virtual keys and, if setKeyNames()
+       was called, virtual keys which do not exist,
+    \o virtual keys without \c <default> element and layers defined twice,
+    \o bindings without or with an unknown \c key attribute.
+    \endlist
+
+    \sa QXmlStreamReader, QVirtualKeyboardLayout::validate()
 */
 
 /*!
     \internal
-    \brief Constructs
+    \brief Constructs a reader which stores what it reads in \a layout.
 */
-QVirtualKeyboardLayoutReader::QVirtualKeyboardLayoutReader(QVirtualKeyboard *parent)
+QVirtualKeyboardLayoutReader::QVirtualKeyboardLayoutReader(QVirtualKeyboardLayout *layout)
     : QXmlStreamReader()
-    , parent(parent)
+    , layout(layout)
+    , strict(false)
+{
+}
+
+/*!
+    \internal
+    \brief Enables validation of the layout file while it is read if \a strict is set.
+*/
+void QVirtualKeyboardLayoutReader::setStrict(bool strict)
+{
+    this->strict = strict;
+}
+
+/*!
+    \internal
+    \brief Returns true if the layout file is validated while it is read.
+*/
+bool QVirtualKeyboardLayoutReader::isStrict() const
 {
+    return strict;
+}
+
+/*!
+    \internal
+    \brief Sets the object \a names of all virtual keys a layout may bind.
+
+    In strict mode virtual key elements whose name is not contained in
+    \a names are reported. If \a names is empty, any name is accepted.
+*/
+void QVirtualKeyboardLayoutReader::setKeyNames(const QSet<QString> &names)
+{
+    keyNames = names;
 }
 
 /*!
     \internal
     \brief Reads provided the virtual keyboard layout file.
+
+    In strict mode false is also returned if the file is well-formed, but
+    validation errors were found.
 */
 bool QVirtualKeyboardLayoutReader::read(QIODevice *device)
 {
     setDevice(device);
+    layout->entries.clear();
+    keyLines.clear();
+    errors.clear();
 
     while (!atEnd()) {
         readNext();
         if (isStartElement()) {
             if (name() == "virtualkeyboardlayout") {
-                parent->setLayoutVersion(attributes().value("version").toString().toInt());
-                parent->setLayoutName(attributes().value("name").toString());
+                if (strict) {
+                    checkAttributes(layoutAttributes);
+                    bool ok;
+                    attributes().value("version").toString().toInt(&ok);
+                    if (!ok)
+                        addValidationError(QObject::tr("The layout version '%1' is not a number.")
+                                           .arg(attributes().value("version").toString()));
+                }
+                layout->version = attributes().value("version").toString().toInt();
+                layout->name = attributes().value("name").toString();
+                layout->composeFile = attributes().value("compose").toString();
 
                 while (!atEnd()) {
                     readNext();
@@ -62,19 +123,55 @@ bool QVirtualKeyboardLayoutReader::read(QIODevice *device)
                 raiseError(QObject::tr("The file is not a virtual keyboard layout file."));
         }
     }
-    return !error();
+
+    if (error()) {
+        addValidationError(errorString());
+        return false;
+    }
+    return !strict || errors.isEmpty();
 }
 
 /*!
     \internal
-    \brief Process a virtual key XML element and lookup/load the correponding virtual
-           keyboard key.
+    \brief Returns the errors found by the last read() in strict mode, formatted
+           as \c {line:column: message}.
+
+    Errors which make the file unreadable (malformed XML) are included as well.
+*/
+QStringList QVirtualKeyboardLayoutReader::validationErrors() const
+{
+    return errors;
+}
+
+/*!
+    \internal
+    \brief Process a virtual key XML element and store its key bindings.
+
+    Key names are resolved and missing texts are derived from the key code here,
+    so applying the layout later on does not need to do any conversions.
 */
 void QVirtualKeyboardLayoutReader::readVirtualKey()
 {
     Q_ASSERT(isStartElement() && (name() == "vkey")); // More brackets for MSVC's strange operator precedence!
 
-    QVirtualKey *vkey = parent->findVirtualKey(attributes().value("name").toString());
+    QVirtualKeyboardLayout::Entry entry;
+    entry.name = attributes().value("name").toString();
+
+    const qint64 line = lineNumber();
+    const qint64 column = columnNumber();
+    if (strict) {
+        checkAttributes(keyAttributes);
+        if (entry.name.isEmpty()) {
+            addValidationError(QObject::tr("The virtual key has no name."));
+        } else if (keyLines.contains(entry.name)) {
+            addValidationError(QObject::tr("The virtual key '%1' is already defined in line %2.")
+                               .arg(entry.name).arg(keyLines.value(entry.name)));
+        } else {
+            keyLines.insert(entry.name, line);
+            if (!keyNames.isEmpty() && !keyNames.contains(entry.name))
+                addValidationError(QObject::tr("There is no virtual key named '%1'.").arg(entry.name));
+        }
+    }
 
     while (!atEnd()) {
         readNext();
@@ -82,36 +179,51 @@ void QVirtualKeyboardLayoutReader::readVirtualKey()
         if (isEndElement())
             break;
         if (isStartElement()) {
-            if (vkey) {
-                Qt::Key key = QVirtualKeyboard::stringToKey(attributes().value("key").toString());
-                QString text = attributes().value("text").toString();
-
-                if (name() == "default") {
-                    vkey->setKey(key);
-                    text.isEmpty() ? vkey->setText(QString(vkey->key())) : vkey->setText(text);
-                    vkey->setIcon(QIcon(attributes().value("icon").toString()));
-                } else if (name() == "shift") {
-                    vkey->setShiftKey(key);
-                    text.isEmpty() ? vkey->setShiftText(QString(vkey->shiftKey())) : vkey->setShiftText(text);
-                    vkey->setShiftIcon(QIcon(attributes().value("icon").toString()));
-                } else if (name() == "alt") {
-                    vkey->setAltKey(key);
-                    text.isEmpty() ? vkey->setAltText(QString(vkey->altKey())) : vkey->setAltText(text);
-                    vkey->setAltIcon(QIcon(attributes().value("icon").toString()));
-                } else if (name() == "altshift") {
-                    vkey->setAltShiftKey(key);
-                    text.isEmpty() ? vkey->setAltShiftText(QString(vkey->altShiftKey())) : vkey->setAltShiftText(text);
-                    vkey->setAltShiftIcon(QIcon(attributes().value("icon").toString()));
+            int layer = 0;
+            while (layer < QVirtualKeyboardLayout::LayerCount
+                   && name() != QVirtualKeyboardLayout::layerElementName(QVirtualKeyboardLayout::Layer(layer)))
+                ++layer;
+            if (layer == QVirtualKeyboardLayout::LayerCount) {
+                readUnkownElement();
+                continue;
+            }
+
+            QVirtualKeyboardLayout::Binding &binding = entry.bindings[layer];
+            const QString key = attributes().value("key").toString();
+            if (strict) {
+                checkAttributes(bindingAttributes);
+                if (binding.defined)
+                    addValidationError(QObject::tr("The <%1> element is defined twice.").arg(name().toString()));
+                if (key.isEmpty()) {
+                    addValidationError(QObject::tr("The <%1> element has no key.").arg(name().toString()));
+                } else {
+                    bool ok;
+                    binding.key = QVirtualKeyboard::stringToKey(key, &ok);
+                    if (!ok)
+                        addValidationError(QObject::tr("Unknown key '%1'.").arg(key));
                 }
+            } else {
+                binding.key = QVirtualKeyboard::stringToKey(key);
             }
+            binding.defined = true;
+            binding.text = attributes().value("text").toString();
+            if (binding.text.isEmpty())
+                binding.text = QString(QChar(binding.key));
+            binding.icon = attributes().value("icon").toString();
 
             while (!atEnd()) {
                 readNext();
                 if (isEndElement())
                     break;
+                if (isStartElement())
+                    readUnkownElement();
             }
         }
     }
+
+    if (strict && !error() && !entry.bindings[QVirtualKeyboardLayout::DefaultLayer].defined)
+        addValidationError(QObject::tr("The virtual key '%1' has no <default> element.").arg(entry.name), line, column);
+    layout->entries.append(entry);
 }
 
 /*!
@@ -122,12 +234,43 @@ void QVirtualKeyboardLayoutReader::readUnkownElement()
 {
     Q_ASSERT(isStartElement());
 
-    while (!atEnd()) {
+    if (strict)
+        addValidationError(QObject::tr("Unknown element <%1>.").arg(name().toString()));
+
+    // Nested elements are skipped without further errors
+    int depth = 1;
+    while (depth > 0 && !atEnd()) {
         readNext();
 
         if (isEndElement())
-            break;
-        if (isStartElement())
-            readUnkownElement();
+            --depth;
+        else if (isStartElement())
+            ++depth;
     }
 }
+
+/*!
+    \internal
+    \brief Reports every attribute of the current element which is not in the
+           null terminated list \a allowed.
+*/
+void QVirtualKeyboardLayoutReader::checkAttributes(const char * const *allowed)
+{
+    foreach (const QXmlStreamAttribute &attribute, attributes()) {
+        const char * const *it = allowed;
+        while (*it && attribute.name() != *it)
+            ++it;
+        if (!*it)
+            addValidationError(QObject::tr("Unknown attribute '%1' of <%2>.")
+                               .arg(attribute.name().toString(), name().toString()));
+    }
+}
+
+/*!
+    \internal
+    \brief Records the validation error \a message found at \a line and \a column.
+*/
+void QVirtualKeyboardLayoutReader::addValidationError(const QString &message, qint64 line, qint64 column)
+{
+    errors.append(QString::fromLatin1("%1:%2: %3").arg(line).arg(column).arg(message));
+}
@@ -15,22 +15,39 @@
 #define QVIRTUALKEYBOARDLAYOUTREADER_H
 
 #include <QXmlStreamReader>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+
+#include "qvirtualkeyboardlayout_p.h"
 
 class QIODevice;
-class QVirtualKeyboard;
 
 class QVirtualKeyboardLayoutReader : public QXmlStreamReader
 {
 public:
-    explicit QVirtualKeyboardLayoutReader(QVirtualKeyboard *parent);
+    explicit QVirtualKeyboardLayoutReader(QVirtualKeyboardLayout *layout);
+
+    void setStrict(bool strict);
+    bool isStrict() const;
+    void setKeyNames(const QSet<QString> &names);
 
     bool read(QIODevice *device);
+    QStringList validationErrors() const;
 
 private:
     void readVirtualKey();
     void readUnkownElement();
 
-    QVirtualKeyboard *parent;
+    void checkAttributes(const char * const *allowed);
+    void addValidationError(const QString &message, qint64 line, qint64 column);
+    void addValidationError(const QString &message) { addValidationError(message, lineNumber(), columnNumber()); }
+
+    QVirtualKeyboardLayout *layout;
+    bool strict; ///< Set if every deviation from the layout format is reported
+    QSet<QString> keyNames; ///< Names of the virtual keys which may be bound, empty for any
+    QHash<QString, qint64> keyLines; ///< Line of every virtual key element read, by name
+    QStringList errors; ///< Validation errors formatted as 'line:column: message'
 };
 
 #endif
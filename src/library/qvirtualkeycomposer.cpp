@@ -0,0 +1,235 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include "qvirtualkeycomposer_p.h"
+#include "qvirtualkeycomposetable_p.h"
+#include "qvirtualkeyboard.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <QRegExp>
+#include <QStringList>
+#include <QDebug>
+
+/*!
+    \internal
+    \class QVirtualKeyComposer qvirtualkeycomposer_p.h
+    \brief Combines sequences of dead keys and a base key into a single key.
+
+    The built-in table covers all canonical Unicode compositions of the base
+    characters in the Basic Multilingual Plane with the combining marks of the
+    dead keys Qt knows about. Sequences of several dead keys (for example
+    circumflex and acute for Vietnamese) are composed step by step.
+
+    Additional sequences can be loaded from files in the X11 Compose format:
+
+    \code
+    # Comments start with a hash
+    <dead_circumflex> <dead_acute> <a> : "ấ"
+    <dead_caron> <U0067> : "ǧ"
+    \endcode
+
+    Loaded sequences take precedence over the built-in table. Lines which do not
+    start with a dead key (for example \c Multi_key sequences) are ignored.
+
+    \sa QVirtualKeyboard::deadKeys
+*/
+
+/*!
+    \internal
+    \brief Composes the pressed \a deadKeys with \a key.
+
+    Returns Qt::Key_unknown if the sequence has no composition.
+*/
+Qt::Key QVirtualKeyComposer::compose(const QList<Qt::Key> &deadKeys, Qt::Key key) const
+{
+    if (deadKeys.isEmpty())
+        return key;
+
+    if (!sequences.isEmpty()) {
+        QHash<QString, Qt::Key>::const_iterator it = sequences.constFind(sequenceKey(deadKeys, key));
+        if (it != sequences.constEnd())
+            return it.value();
+    }
+
+    // A dead key followed by space generates its spacing character
+    if (key == Qt::Key_Space)
+        return spacingKey(deadKeys.last());
+
+    // Apply the dead keys in the order they were pressed, most layouts do
+    // also accept the reversed order for stacked marks.
+    Qt::Key result = key;
+    for (int i = 0; i < deadKeys.count() && result != Qt::Key_unknown; ++i)
+        result = composeBuiltin(deadKeys.at(i), result);
+    if (result == Qt::Key_unknown && deadKeys.count() > 1) {
+        result = key;
+        for (int i = deadKeys.count() - 1; i >= 0 && result != Qt::Key_unknown; --i)
+            result = composeBuiltin(deadKeys.at(i), result);
+    }
+    return result;
+}
+
+/*!
+    \internal
+    \brief Looks up the composition of a single \a deadKey and \a key in the built-in table.
+*/
+Qt::Key QVirtualKeyComposer::composeBuiltin(Qt::Key deadKey, Qt::Key key)
+{
+    if (deadKey < Qt::Key_Dead_Grave || deadKey > Qt::Key_Dead_Horn || key < 0 || key > 0xffff)
+        return Qt::Key_unknown;
+
+    const quint16 dead = deadKey - Qt::Key_Dead_Grave;
+    const quint16 base = key;
+    int low = 0;
+    int high = qvirtualkeyComposeTableSize;
+    while (low < high) {
+        const int middle = (low + high) / 2;
+        const QVirtualKeyComposeEntry &entry = qvirtualkeyComposeTable[middle];
+        if (entry.deadKey < dead || (entry.deadKey == dead && entry.base < base))
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    if (low < qvirtualkeyComposeTableSize) {
+        const QVirtualKeyComposeEntry &entry = qvirtualkeyComposeTable[low];
+        if (entry.deadKey == dead && entry.base == base)
+            return Qt::Key(entry.result);
+    }
+    return Qt::Key_unknown;
+}
+
+/*!
+    \internal
+    \brief Returns the spacing (undead) equivalent of \a deadKey, which is generated
+           if the same dead key is pressed twice or followed by space.
+*/
+Qt::Key QVirtualKeyComposer::spacingKey(Qt::Key deadKey)
+{
+    if (deadKey < Qt::Key_Dead_Grave || deadKey > Qt::Key_Dead_Horn)
+        return Qt::Key_unknown;
+    return Qt::Key(qvirtualkeySpacingTable[deadKey - Qt::Key_Dead_Grave]);
+}
+
+/*!
+    \internal
+    \brief Loads additional compose sequences from \a fileName.
+
+    Sequences for lowercase letters are also registered for the uppercase letter
+    with the uppercase result, because virtual keys usually generate the uppercase
+    key code for letters.
+*/
+bool QVirtualKeyComposer::load(const QString &fileName, QString *errorString)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        if (errorString)
+            *errorString = file.errorString();
+        return false;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    QRegExp symbolPattern("<([^>]+)>");
+    int lineNumber = 0;
+
+    while (!stream.atEnd()) {
+        const QString line = stream.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#')))
+            continue;
+
+        const int colon = line.indexOf(QLatin1Char(':'), line.lastIndexOf(QLatin1Char('>')));
+        const int quote = line.indexOf(QLatin1Char('"'), colon);
+        const int endQuote = line.indexOf(QLatin1Char('"'), quote + 1);
+        if (colon < 0 || quote < 0 || endQuote < 0) {
+            qWarning() << "QVirtualKeyComposer::load(" << fileName << ") Malformed line" << lineNumber;
+            continue;
+        }
+
+        QList<Qt::Key> symbols;
+        bool ok = true;
+        int pos = 0;
+        while (ok && (pos = symbolPattern.indexIn(line.left(colon), pos)) != -1) {
+            symbols.append(parseKeySymbol(symbolPattern.cap(1), &ok));
+            pos += symbolPattern.matchedLength();
+        }
+        const QString result = line.mid(quote + 1, endQuote - quote - 1);
+
+        // Only dead key sequences are relevant for virtual keyboards
+        if (!ok || symbols.count() < 2 || !QVirtualKeyboard::isDeadKey(symbols.first()))
+            continue;
+        if (result.length() != 1 || symbols.count() > MaximumSequenceLength + 1) {
+            qWarning() << "QVirtualKeyComposer::load(" << fileName << ") Unsupported sequence in line" << lineNumber;
+            continue;
+        }
+
+        const Qt::Key key = symbols.takeLast();
+        sequences.insert(sequenceKey(symbols, key), Qt::Key(result.at(0).unicode()));
+
+        const QChar base(key);
+        if (key <= 0xffff && base.isLower() && result.at(0).isLower())
+            sequences.insert(sequenceKey(symbols, Qt::Key(base.toUpper().unicode())),
+                             Qt::Key(result.at(0).toUpper().unicode()));
+    }
+    return true;
+}
+
+/*!
+    \internal
+    \brief Removes all sequences loaded from compose files.
+*/
+void QVirtualKeyComposer::clear()
+{
+    sequences.clear();
+}
+
+/*!
+    \internal
+    \brief Builds the lookup key of the loaded sequences.
+*/
+QString QVirtualKeyComposer::sequenceKey(const QList<Qt::Key> &deadKeys, Qt::Key key)
+{
+    QString sequence;
+    foreach (Qt::Key deadKey, deadKeys)
+        sequence += QString::number(deadKey, 16) + QLatin1Char(' ');
+    return sequence + QString::number(key, 16);
+}
+
+/*!
+    \internal
+    \brief Converts a X11 Compose key \a symbol (without the angle brackets) to a Qt::Key.
+
+    Dead keys use the X11 names (\c dead_acute), other keys are given as a single
+    character, as Unicode code point (\c U00E2) or as Qt::Key name without the
+    \c Key_ prefix.
+*/
+Qt::Key QVirtualKeyComposer::parseKeySymbol(const QString &symbol, bool *ok)
+{
+    *ok = true;
+    if (symbol.length() == 1)
+        return Qt::Key(symbol.at(0).unicode());
+
+    if (symbol.startsWith(QLatin1String("dead_"))) {
+        for (int key = Qt::Key_Dead_Grave; key <= Qt::Key_Dead_Horn; ++key) {
+            if (QVirtualKeyboard::keyToString(Qt::Key(key)).mid(4).toLower() == symbol)
+                return Qt::Key(key);
+        }
+    } else if (symbol.length() > 1 && symbol.at(0) == QLatin1Char('U')) {
+        const uint code = symbol.mid(1).toUInt(ok, 16);
+        if (*ok && code <= 0xffff)
+            return Qt::Key(code);
+    }
+
+    const Qt::Key key = QVirtualKeyboard::stringToKey(QLatin1String("Key_") + symbol, ok);
+    return *ok ? key : Qt::Key_unknown;
+}
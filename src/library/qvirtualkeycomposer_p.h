@@ -0,0 +1,42 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#ifndef QVIRTUALKEYCOMPOSER_P_H
+#define QVIRTUALKEYCOMPOSER_P_H
+
+#include <QString>
+#include <QHash>
+#include <QList>
+
+#include "qvirtualkeyboardglobal.h"
+
+class Q_QVK_EXPORT QVirtualKeyComposer
+{
+public:
+    enum { MaximumSequenceLength = 4 };
+
+    Qt::Key compose(const QList<Qt::Key> &deadKeys, Qt::Key key) const;
+    bool load(const QString &fileName, QString *errorString = 0);
+    void clear();
+
+    static Qt::Key composeBuiltin(Qt::Key deadKey, Qt::Key key);
+    static Qt::Key spacingKey(Qt::Key deadKey);
+
+private:
+    static QString sequenceKey(const QList<Qt::Key> &deadKeys, Qt::Key key);
+    static Qt::Key parseKeySymbol(const QString &symbol, bool *ok);
+
+    QHash<QString, Qt::Key> sequences; ///< Sequences loaded from compose files
+};
+
+#endif
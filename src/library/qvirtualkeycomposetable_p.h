@@ -0,0 +1,867 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+// This file is generated by util/gencomposetable.py from Unicode 14.0.0 data, do not edit.
+
+#ifndef QVIRTUALKEYCOMPOSETABLE_P_H
+#define QVIRTUALKEYCOMPOSETABLE_P_H
+
+#include <QtGlobal>
+
+struct QVirtualKeyComposeEntry
+{
+    quint16 deadKey; ///< Offset of the dead key from Qt::Key_Dead_Grave
+    quint16 base;
+    quint16 result;
+};
+
+// Sorted by dead key and base character
+static const QVirtualKeyComposeEntry qvirtualkeyComposeTable[] = {
+    // Qt::Key_Dead_Grave
+    {  0, 0x0041, 0x00c0 },
+    {  0, 0x0045, 0x00c8 },
+    {  0, 0x0049, 0x00cc },
+    {  0, 0x004e, 0x01f8 },
+    {  0, 0x004f, 0x00d2 },
+    {  0, 0x0055, 0x00d9 },
+    {  0, 0x0057, 0x1e80 },
+    {  0, 0x0059, 0x1ef2 },
+    {  0, 0x0061, 0x00e0 },
+    {  0, 0x0065, 0x00e8 },
+    {  0, 0x0069, 0x00ec },
+    {  0, 0x006e, 0x01f9 },
+    {  0, 0x006f, 0x00f2 },
+    {  0, 0x0075, 0x00f9 },
+    {  0, 0x0077, 0x1e81 },
+    {  0, 0x0079, 0x1ef3 },
+    {  0, 0x00a8, 0x1fed },
+    {  0, 0x00c2, 0x1ea6 },
+    {  0, 0x00ca, 0x1ec0 },
+    {  0, 0x00d4, 0x1ed2 },
+    {  0, 0x00dc, 0x01db },
+    {  0, 0x00e2, 0x1ea7 },
+    {  0, 0x00ea, 0x1ec1 },
+    {  0, 0x00f4, 0x1ed3 },
+    {  0, 0x00fc, 0x01dc },
+    {  0, 0x0102, 0x1eb0 },
+    {  0, 0x0103, 0x1eb1 },
+    {  0, 0x0112, 0x1e14 },
+    {  0, 0x0113, 0x1e15 },
+    {  0, 0x014c, 0x1e50 },
+    {  0, 0x014d, 0x1e51 },
+    {  0, 0x01a0, 0x1edc },
+    {  0, 0x01a1, 0x1edd },
+    {  0, 0x01af, 0x1eea },
+    {  0, 0x01b0, 0x1eeb },
+    {  0, 0x0391, 0x1fba },
+    {  0, 0x0395, 0x1fc8 },
+    {  0, 0x0397, 0x1fca },
+    {  0, 0x0399, 0x1fda },
+    {  0, 0x039f, 0x1ff8 },
+    {  0, 0x03a5, 0x1fea },
+    {  0, 0x03a9, 0x1ffa },
+    {  0, 0x03b1, 0x1f70 },
+    {  0, 0x03b5, 0x1f72 },
+    {  0, 0x03b7, 0x1f74 },
+    {  0, 0x03b9, 0x1f76 },
+    {  0, 0x03bf, 0x1f78 },
+    {  0, 0x03c5, 0x1f7a },
+    {  0, 0x03c9, 0x1f7c },
+    {  0, 0x03ca, 0x1fd2 },
+    {  0, 0x03cb, 0x1fe2 },
+    {  0, 0x0415, 0x0400 },
+    {  0, 0x0418, 0x040d },
+    {  0, 0x0435, 0x0450 },
+    {  0, 0x0438, 0x045d },
+    {  0, 0x1f00, 0x1f02 },
+    {  0, 0x1f01, 0x1f03 },
+    {  0, 0x1f08, 0x1f0a },
+    {  0, 0x1f09, 0x1f0b },
+    {  0, 0x1f10, 0x1f12 },
+    {  0, 0x1f11, 0x1f13 },
+    {  0, 0x1f18, 0x1f1a },
+    {  0, 0x1f19, 0x1f1b },
+    {  0, 0x1f20, 0x1f22 },
+    {  0, 0x1f21, 0x1f23 },
+    {  0, 0x1f28, 0x1f2a },
+    {  0, 0x1f29, 0x1f2b },
+    {  0, 0x1f30, 0x1f32 },
+    {  0, 0x1f31, 0x1f33 },
+    {  0, 0x1f38, 0x1f3a },
+    {  0, 0x1f39, 0x1f3b },
+    {  0, 0x1f40, 0x1f42 },
+    {  0, 0x1f41, 0x1f43 },
+    {  0, 0x1f48, 0x1f4a },
+    {  0, 0x1f49, 0x1f4b },
+    {  0, 0x1f50, 0x1f52 },
+    {  0, 0x1f51, 0x1f53 },
+    {  0, 0x1f59, 0x1f5b },
+    {  0, 0x1f60, 0x1f62 },
+    {  0, 0x1f61, 0x1f63 },
+    {  0, 0x1f68, 0x1f6a },
+    {  0, 0x1f69, 0x1f6b },
+    {  0, 0x1f80, 0x1f82 },
+    {  0, 0x1f81, 0x1f83 },
+    {  0, 0x1f88, 0x1f8a },
+    {  0, 0x1f89, 0x1f8b },
+    {  0, 0x1f90, 0x1f92 },
+    {  0, 0x1f91, 0x1f93 },
+    {  0, 0x1f98, 0x1f9a },
+    {  0, 0x1f99, 0x1f9b },
+    {  0, 0x1fa0, 0x1fa2 },
+    {  0, 0x1fa1, 0x1fa3 },
+    {  0, 0x1fa8, 0x1faa },
+    {  0, 0x1fa9, 0x1fab },
+    {  0, 0x1fb3, 0x1fb2 },
+    {  0, 0x1fbe, 0x1f76 },
+    {  0, 0x1fbf, 0x1fcd },
+    {  0, 0x1fc3, 0x1fc2 },
+    {  0, 0x1ff3, 0x1ff2 },
+    {  0, 0x1ffe, 0x1fdd },
+    {  0, 0x2126, 0x1ffa },
+    // Qt::Key_Dead_Acute
+    {  1, 0x0041, 0x00c1 },
+    {  1, 0x0043, 0x0106 },
+    {  1, 0x0045, 0x00c9 },
+    {  1, 0x0047, 0x01f4 },
+    {  1, 0x0049, 0x00cd },
+    {  1, 0x004b, 0x1e30 },
+    {  1, 0x004c, 0x0139 },
+    {  1, 0x004d, 0x1e3e },
+    {  1, 0x004e, 0x0143 },
+    {  1, 0x004f, 0x00d3 },
+    {  1, 0x0050, 0x1e54 },
+    {  1, 0x0052, 0x0154 },
+    {  1, 0x0053, 0x015a },
+    {  1, 0x0055, 0x00da },
+    {  1, 0x0057, 0x1e82 },
+    {  1, 0x0059, 0x00dd },
+    {  1, 0x005a, 0x0179 },
+    {  1, 0x0061, 0x00e1 },
+    {  1, 0x0063, 0x0107 },
+    {  1, 0x0065, 0x00e9 },
+    {  1, 0x0067, 0x01f5 },
+    {  1, 0x0069, 0x00ed },
+    {  1, 0x006b, 0x1e31 },
+    {  1, 0x006c, 0x013a },
+    {  1, 0x006d, 0x1e3f },
+    {  1, 0x006e, 0x0144 },
+    {  1, 0x006f, 0x00f3 },
+    {  1, 0x0070, 0x1e55 },
+    {  1, 0x0072, 0x0155 },
+    {  1, 0x0073, 0x015b },
+    {  1, 0x0075, 0x00fa },
+    {  1, 0x0077, 0x1e83 },
+    {  1, 0x0079, 0x00fd },
+    {  1, 0x007a, 0x017a },
+    {  1, 0x00a8, 0x0385 },
+    {  1, 0x00c2, 0x1ea4 },
+    {  1, 0x00c5, 0x01fa },
+    {  1, 0x00c6, 0x01fc },
+    {  1, 0x00c7, 0x1e08 },
+    {  1, 0x00ca, 0x1ebe },
+    {  1, 0x00cf, 0x1e2e },
+    {  1, 0x00d4, 0x1ed0 },
+    {  1, 0x00d5, 0x1e4c },
+    {  1, 0x00d8, 0x01fe },
+    {  1, 0x00dc, 0x01d7 },
+    {  1, 0x00e2, 0x1ea5 },
+    {  1, 0x00e5, 0x01fb },
+    {  1, 0x00e6, 0x01fd },
+    {  1, 0x00e7, 0x1e09 },
+    {  1, 0x00ea, 0x1ebf },
+    {  1, 0x00ef, 0x1e2f },
+    {  1, 0x00f4, 0x1ed1 },
+    {  1, 0x00f5, 0x1e4d },
+    {  1, 0x00f8, 0x01ff },
+    {  1, 0x00fc, 0x01d8 },
+    {  1, 0x0102, 0x1eae },
+    {  1, 0x0103, 0x1eaf },
+    {  1, 0x0112, 0x1e16 },
+    {  1, 0x0113, 0x1e17 },
+    {  1, 0x014c, 0x1e52 },
+    {  1, 0x014d, 0x1e53 },
+    {  1, 0x0168, 0x1e78 },
+    {  1, 0x0169, 0x1e79 },
+    {  1, 0x01a0, 0x1eda },
+    {  1, 0x01a1, 0x1edb },
+    {  1, 0x01af, 0x1ee8 },
+    {  1, 0x01b0, 0x1ee9 },
+    {  1, 0x0391, 0x0386 },
+    {  1, 0x0395, 0x0388 },
+    {  1, 0x0397, 0x0389 },
+    {  1, 0x0399, 0x038a },
+    {  1, 0x039f, 0x038c },
+    {  1, 0x03a5, 0x038e },
+    {  1, 0x03a9, 0x038f },
+    {  1, 0x03b1, 0x03ac },
+    {  1, 0x03b5, 0x03ad },
+    {  1, 0x03b7, 0x03ae },
+    {  1, 0x03b9, 0x03af },
+    {  1, 0x03bf, 0x03cc },
+    {  1, 0x03c5, 0x03cd },
+    {  1, 0x03c9, 0x03ce },
+    {  1, 0x03ca, 0x0390 },
+    {  1, 0x03cb, 0x03b0 },
+    {  1, 0x03d2, 0x03d3 },
+    {  1, 0x0413, 0x0403 },
+    {  1, 0x041a, 0x040c },
+    {  1, 0x0433, 0x0453 },
+    {  1, 0x043a, 0x045c },
+    {  1, 0x1f00, 0x1f04 },
+    {  1, 0x1f01, 0x1f05 },
+    {  1, 0x1f08, 0x1f0c },
+    {  1, 0x1f09, 0x1f0d },
+    {  1, 0x1f10, 0x1f14 },
+    {  1, 0x1f11, 0x1f15 },
+    {  1, 0x1f18, 0x1f1c },
+    {  1, 0x1f19, 0x1f1d },
+    {  1, 0x1f20, 0x1f24 },
+    {  1, 0x1f21, 0x1f25 },
+    {  1, 0x1f28, 0x1f2c },
+    {  1, 0x1f29, 0x1f2d },
+    {  1, 0x1f30, 0x1f34 },
+    {  1, 0x1f31, 0x1f35 },
+    {  1, 0x1f38, 0x1f3c },
+    {  1, 0x1f39, 0x1f3d },
+    {  1, 0x1f40, 0x1f44 },
+    {  1, 0x1f41, 0x1f45 },
+    {  1, 0x1f48, 0x1f4c },
+    {  1, 0x1f49, 0x1f4d },
+    {  1, 0x1f50, 0x1f54 },
+    {  1, 0x1f51, 0x1f55 },
+    {  1, 0x1f59, 0x1f5d },
+    {  1, 0x1f60, 0x1f64 },
+    {  1, 0x1f61, 0x1f65 },
+    {  1, 0x1f68, 0x1f6c },
+    {  1, 0x1f69, 0x1f6d },
+    {  1, 0x1f80, 0x1f84 },
+    {  1, 0x1f81, 0x1f85 },
+    {  1, 0x1f88, 0x1f8c },
+    {  1, 0x1f89, 0x1f8d },
+    {  1, 0x1f90, 0x1f94 },
+    {  1, 0x1f91, 0x1f95 },
+    {  1, 0x1f98, 0x1f9c },
+    {  1, 0x1f99, 0x1f9d },
+    {  1, 0x1fa0, 0x1fa4 },
+    {  1, 0x1fa1, 0x1fa5 },
+    {  1, 0x1fa8, 0x1fac },
+    {  1, 0x1fa9, 0x1fad },
+    {  1, 0x1fb3, 0x1fb4 },
+    {  1, 0x1fbe, 0x03af },
+    {  1, 0x1fbf, 0x1fce },
+    {  1, 0x1fc3, 0x1fc4 },
+    {  1, 0x1ff3, 0x1ff4 },
+    {  1, 0x1ffe, 0x1fde },
+    {  1, 0x2126, 0x038f },
+    {  1, 0x212a, 0x1e30 },
+    {  1, 0x212b, 0x01fa },
+    // Qt::Key_Dead_Circumflex
+    {  2, 0x0041, 0x00c2 },
+    {  2, 0x0043, 0x0108 },
+    {  2, 0x0045, 0x00ca },
+    {  2, 0x0047, 0x011c },
+    {  2, 0x0048, 0x0124 },
+    {  2, 0x0049, 0x00ce },
+    {  2, 0x004a, 0x0134 },
+    {  2, 0x004f, 0x00d4 },
+    {  2, 0x0053, 0x015c },
+    {  2, 0x0055, 0x00db },
+    {  2, 0x0057, 0x0174 },
+    {  2, 0x0059, 0x0176 },
+    {  2, 0x005a, 0x1e90 },
+    {  2, 0x0061, 0x00e2 },
+    {  2, 0x0063, 0x0109 },
+    {  2, 0x0065, 0x00ea },
+    {  2, 0x0067, 0x011d },
+    {  2, 0x0068, 0x0125 },
+    {  2, 0x0069, 0x00ee },
+    {  2, 0x006a, 0x0135 },
+    {  2, 0x006f, 0x00f4 },
+    {  2, 0x0073, 0x015d },
+    {  2, 0x0075, 0x00fb },
+    {  2, 0x0077, 0x0175 },
+    {  2, 0x0079, 0x0177 },
+    {  2, 0x007a, 0x1e91 },
+    {  2, 0x1ea0, 0x1eac },
+    {  2, 0x1ea1, 0x1ead },
+    {  2, 0x1eb8, 0x1ec6 },
+    {  2, 0x1eb9, 0x1ec7 },
+    {  2, 0x1ecc, 0x1ed8 },
+    {  2, 0x1ecd, 0x1ed9 },
+    // Qt::Key_Dead_Tilde
+    {  3, 0x0041, 0x00c3 },
+    {  3, 0x0045, 0x1ebc },
+    {  3, 0x0049, 0x0128 },
+    {  3, 0x004e, 0x00d1 },
+    {  3, 0x004f, 0x00d5 },
+    {  3, 0x0055, 0x0168 },
+    {  3, 0x0056, 0x1e7c },
+    {  3, 0x0059, 0x1ef8 },
+    {  3, 0x0061, 0x00e3 },
+    {  3, 0x0065, 0x1ebd },
+    {  3, 0x0069, 0x0129 },
+    {  3, 0x006e, 0x00f1 },
+    {  3, 0x006f, 0x00f5 },
+    {  3, 0x0075, 0x0169 },
+    {  3, 0x0076, 0x1e7d },
+    {  3, 0x0079, 0x1ef9 },
+    {  3, 0x00c2, 0x1eaa },
+    {  3, 0x00ca, 0x1ec4 },
+    {  3, 0x00d4, 0x1ed6 },
+    {  3, 0x00e2, 0x1eab },
+    {  3, 0x00ea, 0x1ec5 },
+    {  3, 0x00f4, 0x1ed7 },
+    {  3, 0x0102, 0x1eb4 },
+    {  3, 0x0103, 0x1eb5 },
+    {  3, 0x01a0, 0x1ee0 },
+    {  3, 0x01a1, 0x1ee1 },
+    {  3, 0x01af, 0x1eee },
+    {  3, 0x01b0, 0x1eef },
+    // Qt::Key_Dead_Macron
+    {  4, 0x0041, 0x0100 },
+    {  4, 0x0045, 0x0112 },
+    {  4, 0x0047, 0x1e20 },
+    {  4, 0x0049, 0x012a },
+    {  4, 0x004f, 0x014c },
+    {  4, 0x0055, 0x016a },
+    {  4, 0x0059, 0x0232 },
+    {  4, 0x0061, 0x0101 },
+    {  4, 0x0065, 0x0113 },
+    {  4, 0x0067, 0x1e21 },
+    {  4, 0x0069, 0x012b },
+    {  4, 0x006f, 0x014d },
+    {  4, 0x0075, 0x016b },
+    {  4, 0x0079, 0x0233 },
+    {  4, 0x00c4, 0x01de },
+    {  4, 0x00c6, 0x01e2 },
+    {  4, 0x00d5, 0x022c },
+    {  4, 0x00d6, 0x022a },
+    {  4, 0x00dc, 0x01d5 },
+    {  4, 0x00e4, 0x01df },
+    {  4, 0x00e6, 0x01e3 },
+    {  4, 0x00f5, 0x022d },
+    {  4, 0x00f6, 0x022b },
+    {  4, 0x00fc, 0x01d6 },
+    {  4, 0x01ea, 0x01ec },
+    {  4, 0x01eb, 0x01ed },
+    {  4, 0x0226, 0x01e0 },
+    {  4, 0x0227, 0x01e1 },
+    {  4, 0x022e, 0x0230 },
+    {  4, 0x022f, 0x0231 },
+    {  4, 0x0391, 0x1fb9 },
+    {  4, 0x0399, 0x1fd9 },
+    {  4, 0x03a5, 0x1fe9 },
+    {  4, 0x03b1, 0x1fb1 },
+    {  4, 0x03b9, 0x1fd1 },
+    {  4, 0x03c5, 0x1fe1 },
+    {  4, 0x0418, 0x04e2 },
+    {  4, 0x0423, 0x04ee },
+    {  4, 0x0438, 0x04e3 },
+    {  4, 0x0443, 0x04ef },
+    {  4, 0x1e36, 0x1e38 },
+    {  4, 0x1e37, 0x1e39 },
+    {  4, 0x1e5a, 0x1e5c },
+    {  4, 0x1e5b, 0x1e5d },
+    {  4, 0x1fbe, 0x1fd1 },
+    // Qt::Key_Dead_Breve
+    {  5, 0x0041, 0x0102 },
+    {  5, 0x0045, 0x0114 },
+    {  5, 0x0047, 0x011e },
+    {  5, 0x0049, 0x012c },
+    {  5, 0x004f, 0x014e },
+    {  5, 0x0055, 0x016c },
+    {  5, 0x0061, 0x0103 },
+    {  5, 0x0065, 0x0115 },
+    {  5, 0x0067, 0x011f },
+    {  5, 0x0069, 0x012d },
+    {  5, 0x006f, 0x014f },
+    {  5, 0x0075, 0x016d },
+    {  5, 0x0228, 0x1e1c },
+    {  5, 0x0229, 0x1e1d },
+    {  5, 0x0391, 0x1fb8 },
+    {  5, 0x0399, 0x1fd8 },
+    {  5, 0x03a5, 0x1fe8 },
+    {  5, 0x03b1, 0x1fb0 },
+    {  5, 0x03b9, 0x1fd0 },
+    {  5, 0x03c5, 0x1fe0 },
+    {  5, 0x0410, 0x04d0 },
+    {  5, 0x0415, 0x04d6 },
+    {  5, 0x0416, 0x04c1 },
+    {  5, 0x0418, 0x0419 },
+    {  5, 0x0423, 0x040e },
+    {  5, 0x0430, 0x04d1 },
+    {  5, 0x0435, 0x04d7 },
+    {  5, 0x0436, 0x04c2 },
+    {  5, 0x0438, 0x0439 },
+    {  5, 0x0443, 0x045e },
+    {  5, 0x1ea0, 0x1eb6 },
+    {  5, 0x1ea1, 0x1eb7 },
+    {  5, 0x1fbe, 0x1fd0 },
+    // Qt::Key_Dead_Abovedot
+    {  6, 0x0041, 0x0226 },
+    {  6, 0x0042, 0x1e02 },
+    {  6, 0x0043, 0x010a },
+    {  6, 0x0044, 0x1e0a },
+    {  6, 0x0045, 0x0116 },
+    {  6, 0x0046, 0x1e1e },
+    {  6, 0x0047, 0x0120 },
+    {  6, 0x0048, 0x1e22 },
+    {  6, 0x0049, 0x0130 },
+    {  6, 0x004d, 0x1e40 },
+    {  6, 0x004e, 0x1e44 },
+    {  6, 0x004f, 0x022e },
+    {  6, 0x0050, 0x1e56 },
+    {  6, 0x0052, 0x1e58 },
+    {  6, 0x0053, 0x1e60 },
+    {  6, 0x0054, 0x1e6a },
+    {  6, 0x0057, 0x1e86 },
+    {  6, 0x0058, 0x1e8a },
+    {  6, 0x0059, 0x1e8e },
+    {  6, 0x005a, 0x017b },
+    {  6, 0x0061, 0x0227 },
+    {  6, 0x0062, 0x1e03 },
+    {  6, 0x0063, 0x010b },
+    {  6, 0x0064, 0x1e0b },
+    {  6, 0x0065, 0x0117 },
+    {  6, 0x0066, 0x1e1f },
+    {  6, 0x0067, 0x0121 },
+    {  6, 0x0068, 0x1e23 },
+    {  6, 0x006d, 0x1e41 },
+    {  6, 0x006e, 0x1e45 },
+    {  6, 0x006f, 0x022f },
+    {  6, 0x0070, 0x1e57 },
+    {  6, 0x0072, 0x1e59 },
+    {  6, 0x0073, 0x1e61 },
+    {  6, 0x0074, 0x1e6b },
+    {  6, 0x0077, 0x1e87 },
+    {  6, 0x0078, 0x1e8b },
+    {  6, 0x0079, 0x1e8f },
+    {  6, 0x007a, 0x017c },
+    {  6, 0x015a, 0x1e64 },
+    {  6, 0x015b, 0x1e65 },
+    {  6, 0x0160, 0x1e66 },
+    {  6, 0x0161, 0x1e67 },
+    {  6, 0x017f, 0x1e9b },
+    {  6, 0x1e62, 0x1e68 },
+    {  6, 0x1e63, 0x1e69 },
+    // Qt::Key_Dead_Diaeresis
+    {  7, 0x0041, 0x00c4 },
+    {  7, 0x0045, 0x00cb },
+    {  7, 0x0048, 0x1e26 },
+    {  7, 0x0049, 0x00cf },
+    {  7, 0x004f, 0x00d6 },
+    {  7, 0x0055, 0x00dc },
+    {  7, 0x0057, 0x1e84 },
+    {  7, 0x0058, 0x1e8c },
+    {  7, 0x0059, 0x0178 },
+    {  7, 0x0061, 0x00e4 },
+    {  7, 0x0065, 0x00eb },
+    {  7, 0x0068, 0x1e27 },
+    {  7, 0x0069, 0x00ef },
+    {  7, 0x006f, 0x00f6 },
+    {  7, 0x0074, 0x1e97 },
+    {  7, 0x0075, 0x00fc },
+    {  7, 0x0077, 0x1e85 },
+    {  7, 0x0078, 0x1e8d },
+    {  7, 0x0079, 0x00ff },
+    {  7, 0x00d5, 0x1e4e },
+    {  7, 0x00f5, 0x1e4f },
+    {  7, 0x016a, 0x1e7a },
+    {  7, 0x016b, 0x1e7b },
+    {  7, 0x0399, 0x03aa },
+    {  7, 0x03a5, 0x03ab },
+    {  7, 0x03b9, 0x03ca },
+    {  7, 0x03c5, 0x03cb },
+    {  7, 0x03d2, 0x03d4 },
+    {  7, 0x0406, 0x0407 },
+    {  7, 0x0410, 0x04d2 },
+    {  7, 0x0415, 0x0401 },
+    {  7, 0x0416, 0x04dc },
+    {  7, 0x0417, 0x04de },
+    {  7, 0x0418, 0x04e4 },
+    {  7, 0x041e, 0x04e6 },
+    {  7, 0x0423, 0x04f0 },
+    {  7, 0x0427, 0x04f4 },
+    {  7, 0x042b, 0x04f8 },
+    {  7, 0x042d, 0x04ec },
+    {  7, 0x0430, 0x04d3 },
+    {  7, 0x0435, 0x0451 },
+    {  7, 0x0436, 0x04dd },
+    {  7, 0x0437, 0x04df },
+    {  7, 0x0438, 0x04e5 },
+    {  7, 0x043e, 0x04e7 },
+    {  7, 0x0443, 0x04f1 },
+    {  7, 0x0447, 0x04f5 },
+    {  7, 0x044b, 0x04f9 },
+    {  7, 0x044d, 0x04ed },
+    {  7, 0x0456, 0x0457 },
+    {  7, 0x04d8, 0x04da },
+    {  7, 0x04d9, 0x04db },
+    {  7, 0x04e8, 0x04ea },
+    {  7, 0x04e9, 0x04eb },
+    {  7, 0x1fbe, 0x03ca },
+    // Qt::Key_Dead_Abovering
+    {  8, 0x0041, 0x00c5 },
+    {  8, 0x0055, 0x016e },
+    {  8, 0x0061, 0x00e5 },
+    {  8, 0x0075, 0x016f },
+    {  8, 0x0077, 0x1e98 },
+    {  8, 0x0079, 0x1e99 },
+    // Qt::Key_Dead_Doubleacute
+    {  9, 0x004f, 0x0150 },
+    {  9, 0x0055, 0x0170 },
+    {  9, 0x006f, 0x0151 },
+    {  9, 0x0075, 0x0171 },
+    {  9, 0x0423, 0x04f2 },
+    {  9, 0x0443, 0x04f3 },
+    // Qt::Key_Dead_Caron
+    { 10, 0x0041, 0x01cd },
+    { 10, 0x0043, 0x010c },
+    { 10, 0x0044, 0x010e },
+    { 10, 0x0045, 0x011a },
+    { 10, 0x0047, 0x01e6 },
+    { 10, 0x0048, 0x021e },
+    { 10, 0x0049, 0x01cf },
+    { 10, 0x004b, 0x01e8 },
+    { 10, 0x004c, 0x013d },
+    { 10, 0x004e, 0x0147 },
+    { 10, 0x004f, 0x01d1 },
+    { 10, 0x0052, 0x0158 },
+    { 10, 0x0053, 0x0160 },
+    { 10, 0x0054, 0x0164 },
+    { 10, 0x0055, 0x01d3 },
+    { 10, 0x005a, 0x017d },
+    { 10, 0x0061, 0x01ce },
+    { 10, 0x0063, 0x010d },
+    { 10, 0x0064, 0x010f },
+    { 10, 0x0065, 0x011b },
+    { 10, 0x0067, 0x01e7 },
+    { 10, 0x0068, 0x021f },
+    { 10, 0x0069, 0x01d0 },
+    { 10, 0x006a, 0x01f0 },
+    { 10, 0x006b, 0x01e9 },
+    { 10, 0x006c, 0x013e },
+    { 10, 0x006e, 0x0148 },
+    { 10, 0x006f, 0x01d2 },
+    { 10, 0x0072, 0x0159 },
+    { 10, 0x0073, 0x0161 },
+    { 10, 0x0074, 0x0165 },
+    { 10, 0x0075, 0x01d4 },
+    { 10, 0x007a, 0x017e },
+    { 10, 0x00dc, 0x01d9 },
+    { 10, 0x00fc, 0x01da },
+    { 10, 0x01b7, 0x01ee },
+    { 10, 0x0292, 0x01ef },
+    { 10, 0x212a, 0x01e8 },
+    // Qt::Key_Dead_Cedilla
+    { 11, 0x0043, 0x00c7 },
+    { 11, 0x0044, 0x1e10 },
+    { 11, 0x0045, 0x0228 },
+    { 11, 0x0047, 0x0122 },
+    { 11, 0x0048, 0x1e28 },
+    { 11, 0x004b, 0x0136 },
+    { 11, 0x004c, 0x013b },
+    { 11, 0x004e, 0x0145 },
+    { 11, 0x0052, 0x0156 },
+    { 11, 0x0053, 0x015e },
+    { 11, 0x0054, 0x0162 },
+    { 11, 0x0063, 0x00e7 },
+    { 11, 0x0064, 0x1e11 },
+    { 11, 0x0065, 0x0229 },
+    { 11, 0x0067, 0x0123 },
+    { 11, 0x0068, 0x1e29 },
+    { 11, 0x006b, 0x0137 },
+    { 11, 0x006c, 0x013c },
+    { 11, 0x006e, 0x0146 },
+    { 11, 0x0072, 0x0157 },
+    { 11, 0x0073, 0x015f },
+    { 11, 0x0074, 0x0163 },
+    { 11, 0x0106, 0x1e08 },
+    { 11, 0x0107, 0x1e09 },
+    { 11, 0x0114, 0x1e1c },
+    { 11, 0x0115, 0x1e1d },
+    { 11, 0x212a, 0x0136 },
+    // Qt::Key_Dead_Ogonek
+    { 12, 0x0041, 0x0104 },
+    { 12, 0x0045, 0x0118 },
+    { 12, 0x0049, 0x012e },
+    { 12, 0x004f, 0x01ea },
+    { 12, 0x0055, 0x0172 },
+    { 12, 0x0061, 0x0105 },
+    { 12, 0x0065, 0x0119 },
+    { 12, 0x0069, 0x012f },
+    { 12, 0x006f, 0x01eb },
+    { 12, 0x0075, 0x0173 },
+    { 12, 0x014c, 0x01ec },
+    { 12, 0x014d, 0x01ed },
+    // Qt::Key_Dead_Iota
+    { 13, 0x0391, 0x1fbc },
+    { 13, 0x0397, 0x1fcc },
+    { 13, 0x03a9, 0x1ffc },
+    { 13, 0x03ac, 0x1fb4 },
+    { 13, 0x03ae, 0x1fc4 },
+    { 13, 0x03b1, 0x1fb3 },
+    { 13, 0x03b7, 0x1fc3 },
+    { 13, 0x03c9, 0x1ff3 },
+    { 13, 0x03ce, 0x1ff4 },
+    { 13, 0x1f00, 0x1f80 },
+    { 13, 0x1f01, 0x1f81 },
+    { 13, 0x1f02, 0x1f82 },
+    { 13, 0x1f03, 0x1f83 },
+    { 13, 0x1f04, 0x1f84 },
+    { 13, 0x1f05, 0x1f85 },
+    { 13, 0x1f06, 0x1f86 },
+    { 13, 0x1f07, 0x1f87 },
+    { 13, 0x1f08, 0x1f88 },
+    { 13, 0x1f09, 0x1f89 },
+    { 13, 0x1f0a, 0x1f8a },
+    { 13, 0x1f0b, 0x1f8b },
+    { 13, 0x1f0c, 0x1f8c },
+    { 13, 0x1f0d, 0x1f8d },
+    { 13, 0x1f0e, 0x1f8e },
+    { 13, 0x1f0f, 0x1f8f },
+    { 13, 0x1f20, 0x1f90 },
+    { 13, 0x1f21, 0x1f91 },
+    { 13, 0x1f22, 0x1f92 },
+    { 13, 0x1f23, 0x1f93 },
+    { 13, 0x1f24, 0x1f94 },
+    { 13, 0x1f25, 0x1f95 },
+    { 13, 0x1f26, 0x1f96 },
+    { 13, 0x1f27, 0x1f97 },
+    { 13, 0x1f28, 0x1f98 },
+    { 13, 0x1f29, 0x1f99 },
+    { 13, 0x1f2a, 0x1f9a },
+    { 13, 0x1f2b, 0x1f9b },
+    { 13, 0x1f2c, 0x1f9c },
+    { 13, 0x1f2d, 0x1f9d },
+    { 13, 0x1f2e, 0x1f9e },
+    { 13, 0x1f2f, 0x1f9f },
+    { 13, 0x1f60, 0x1fa0 },
+    { 13, 0x1f61, 0x1fa1 },
+    { 13, 0x1f62, 0x1fa2 },
+    { 13, 0x1f63, 0x1fa3 },
+    { 13, 0x1f64, 0x1fa4 },
+    { 13, 0x1f65, 0x1fa5 },
+    { 13, 0x1f66, 0x1fa6 },
+    { 13, 0x1f67, 0x1fa7 },
+    { 13, 0x1f68, 0x1fa8 },
+    { 13, 0x1f69, 0x1fa9 },
+    { 13, 0x1f6a, 0x1faa },
+    { 13, 0x1f6b, 0x1fab },
+    { 13, 0x1f6c, 0x1fac },
+    { 13, 0x1f6d, 0x1fad },
+    { 13, 0x1f6e, 0x1fae },
+    { 13, 0x1f6f, 0x1faf },
+    { 13, 0x1f70, 0x1fb2 },
+    { 13, 0x1f71, 0x1fb4 },
+    { 13, 0x1f74, 0x1fc2 },
+    { 13, 0x1f75, 0x1fc4 },
+    { 13, 0x1f7c, 0x1ff2 },
+    { 13, 0x1f7d, 0x1ff4 },
+    { 13, 0x1fb6, 0x1fb7 },
+    { 13, 0x1fc6, 0x1fc7 },
+    { 13, 0x1ff6, 0x1ff7 },
+    { 13, 0x2126, 0x1ffc },
+    // Qt::Key_Dead_Voiced_Sound
+    { 14, 0x3046, 0x3094 },
+    { 14, 0x304b, 0x304c },
+    { 14, 0x304d, 0x304e },
+    { 14, 0x304f, 0x3050 },
+    { 14, 0x3051, 0x3052 },
+    { 14, 0x3053, 0x3054 },
+    { 14, 0x3055, 0x3056 },
+    { 14, 0x3057, 0x3058 },
+    { 14, 0x3059, 0x305a },
+    { 14, 0x305b, 0x305c },
+    { 14, 0x305d, 0x305e },
+    { 14, 0x305f, 0x3060 },
+    { 14, 0x3061, 0x3062 },
+    { 14, 0x3064, 0x3065 },
+    { 14, 0x3066, 0x3067 },
+    { 14, 0x3068, 0x3069 },
+    { 14, 0x306f, 0x3070 },
+    { 14, 0x3072, 0x3073 },
+    { 14, 0x3075, 0x3076 },
+    { 14, 0x3078, 0x3079 },
+    { 14, 0x307b, 0x307c },
+    { 14, 0x309d, 0x309e },
+    { 14, 0x30a6, 0x30f4 },
+    { 14, 0x30ab, 0x30ac },
+    { 14, 0x30ad, 0x30ae },
+    { 14, 0x30af, 0x30b0 },
+    { 14, 0x30b1, 0x30b2 },
+    { 14, 0x30b3, 0x30b4 },
+    { 14, 0x30b5, 0x30b6 },
+    { 14, 0x30b7, 0x30b8 },
+    { 14, 0x30b9, 0x30ba },
+    { 14, 0x30bb, 0x30bc },
+    { 14, 0x30bd, 0x30be },
+    { 14, 0x30bf, 0x30c0 },
+    { 14, 0x30c1, 0x30c2 },
+    { 14, 0x30c4, 0x30c5 },
+    { 14, 0x30c6, 0x30c7 },
+    { 14, 0x30c8, 0x30c9 },
+    { 14, 0x30cf, 0x30d0 },
+    { 14, 0x30d2, 0x30d3 },
+    { 14, 0x30d5, 0x30d6 },
+    { 14, 0x30d8, 0x30d9 },
+    { 14, 0x30db, 0x30dc },
+    { 14, 0x30ef, 0x30f7 },
+    { 14, 0x30f0, 0x30f8 },
+    { 14, 0x30f1, 0x30f9 },
+    { 14, 0x30f2, 0x30fa },
+    { 14, 0x30fd, 0x30fe },
+    // Qt::Key_Dead_Semivoiced_Sound
+    { 15, 0x306f, 0x3071 },
+    { 15, 0x3072, 0x3074 },
+    { 15, 0x3075, 0x3077 },
+    { 15, 0x3078, 0x307a },
+    { 15, 0x307b, 0x307d },
+    { 15, 0x30cf, 0x30d1 },
+    { 15, 0x30d2, 0x30d4 },
+    { 15, 0x30d5, 0x30d7 },
+    { 15, 0x30d8, 0x30da },
+    { 15, 0x30db, 0x30dd },
+    // Qt::Key_Dead_Belowdot
+    { 16, 0x0041, 0x1ea0 },
+    { 16, 0x0042, 0x1e04 },
+    { 16, 0x0044, 0x1e0c },
+    { 16, 0x0045, 0x1eb8 },
+    { 16, 0x0048, 0x1e24 },
+    { 16, 0x0049, 0x1eca },
+    { 16, 0x004b, 0x1e32 },
+    { 16, 0x004c, 0x1e36 },
+    { 16, 0x004d, 0x1e42 },
+    { 16, 0x004e, 0x1e46 },
+    { 16, 0x004f, 0x1ecc },
+    { 16, 0x0052, 0x1e5a },
+    { 16, 0x0053, 0x1e62 },
+    { 16, 0x0054, 0x1e6c },
+    { 16, 0x0055, 0x1ee4 },
+    { 16, 0x0056, 0x1e7e },
+    { 16, 0x0057, 0x1e88 },
+    { 16, 0x0059, 0x1ef4 },
+    { 16, 0x005a, 0x1e92 },
+    { 16, 0x0061, 0x1ea1 },
+    { 16, 0x0062, 0x1e05 },
+    { 16, 0x0064, 0x1e0d },
+    { 16, 0x0065, 0x1eb9 },
+    { 16, 0x0068, 0x1e25 },
+    { 16, 0x0069, 0x1ecb },
+    { 16, 0x006b, 0x1e33 },
+    { 16, 0x006c, 0x1e37 },
+    { 16, 0x006d, 0x1e43 },
+    { 16, 0x006e, 0x1e47 },
+    { 16, 0x006f, 0x1ecd },
+    { 16, 0x0072, 0x1e5b },
+    { 16, 0x0073, 0x1e63 },
+    { 16, 0x0074, 0x1e6d },
+    { 16, 0x0075, 0x1ee5 },
+    { 16, 0x0076, 0x1e7f },
+    { 16, 0x0077, 0x1e89 },
+    { 16, 0x0079, 0x1ef5 },
+    { 16, 0x007a, 0x1e93 },
+    { 16, 0x00c2, 0x1eac },
+    { 16, 0x00ca, 0x1ec6 },
+    { 16, 0x00d4, 0x1ed8 },
+    { 16, 0x00e2, 0x1ead },
+    { 16, 0x00ea, 0x1ec7 },
+    { 16, 0x00f4, 0x1ed9 },
+    { 16, 0x0102, 0x1eb6 },
+    { 16, 0x0103, 0x1eb7 },
+    { 16, 0x01a0, 0x1ee2 },
+    { 16, 0x01a1, 0x1ee3 },
+    { 16, 0x01af, 0x1ef0 },
+    { 16, 0x01b0, 0x1ef1 },
+    { 16, 0x1e60, 0x1e68 },
+    { 16, 0x1e61, 0x1e69 },
+    { 16, 0x212a, 0x1e32 },
+    // Qt::Key_Dead_Hook
+    { 17, 0x0041, 0x1ea2 },
+    { 17, 0x0045, 0x1eba },
+    { 17, 0x0049, 0x1ec8 },
+    { 17, 0x004f, 0x1ece },
+    { 17, 0x0055, 0x1ee6 },
+    { 17, 0x0059, 0x1ef6 },
+    { 17, 0x0061, 0x1ea3 },
+    { 17, 0x0065, 0x1ebb },
+    { 17, 0x0069, 0x1ec9 },
+    { 17, 0x006f, 0x1ecf },
+    { 17, 0x0075, 0x1ee7 },
+    { 17, 0x0079, 0x1ef7 },
+    { 17, 0x00c2, 0x1ea8 },
+    { 17, 0x00ca, 0x1ec2 },
+    { 17, 0x00d4, 0x1ed4 },
+    { 17, 0x00e2, 0x1ea9 },
+    { 17, 0x00ea, 0x1ec3 },
+    { 17, 0x00f4, 0x1ed5 },
+    { 17, 0x0102, 0x1eb2 },
+    { 17, 0x0103, 0x1eb3 },
+    { 17, 0x01a0, 0x1ede },
+    { 17, 0x01a1, 0x1edf },
+    { 17, 0x01af, 0x1eec },
+    { 17, 0x01b0, 0x1eed },
+    // Qt::Key_Dead_Horn
+    { 18, 0x004f, 0x01a0 },
+    { 18, 0x0055, 0x01af },
+    { 18, 0x006f, 0x01a1 },
+    { 18, 0x0075, 0x01b0 },
+    { 18, 0x00d2, 0x1edc },
+    { 18, 0x00d3, 0x1eda },
+    { 18, 0x00d5, 0x1ee0 },
+    { 18, 0x00d9, 0x1eea },
+    { 18, 0x00da, 0x1ee8 },
+    { 18, 0x00f2, 0x1edd },
+    { 18, 0x00f3, 0x1edb },
+    { 18, 0x00f5, 0x1ee1 },
+    { 18, 0x00f9, 0x1eeb },
+    { 18, 0x00fa, 0x1ee9 },
+    { 18, 0x0168, 0x1eee },
+    { 18, 0x0169, 0x1eef },
+    { 18, 0x1ecc, 0x1ee2 },
+    { 18, 0x1ecd, 0x1ee3 },
+    { 18, 0x1ece, 0x1ede },
+    { 18, 0x1ecf, 0x1edf },
+    { 18, 0x1ee4, 0x1ef0 },
+    { 18, 0x1ee5, 0x1ef1 },
+    { 18, 0x1ee6, 0x1eec },
+    { 18, 0x1ee7, 0x1eed },
+};
+
+static const int qvirtualkeyComposeTableSize = sizeof(qvirtualkeyComposeTable) / sizeof(QVirtualKeyComposeEntry);
+
+// Spacing characters of the dead keys, in the same order
+static const quint16 qvirtualkeySpacingTable[] = {
+    0x0060,
+    0x00b4,
+    0x005e,
+    0x007e,
+    0x00af,
+    0x02d8,
+    0x02d9,
+    0x00a8,
+    0x02da,
+    0x02dd,
+    0x02c7,
+    0x00b8,
+    0x02db,
+    0x037a,
+    0x309b,
+    0x309c,
+    0x002e,
+    0x02c0,
+    0x02bc
+};
+
+#endif
@@ -0,0 +1,168 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include "qvirtualkeyglyphcache_p.h"
+
+#include <QFont>
+#include <QFontMetrics>
+#include <QPalette>
+#include <QPainter>
+#include <QStyle>
+
+/*!
+    \internal
+    \class QVirtualKeyGlyphCache qvirtualkeyglyphcache_p.h
+    \brief Rasterized key labels shared by all virtual keys of a virtual keyboard.
+
+    Each distinct label (text or icon) is rendered once per font, palette, state
+    and size. The cache is bounded by the number of bytes of the stored pixmaps,
+    least recently used labels are dropped first.
+
+    \sa QVirtualKeyboard::setGlyphCacheLimit()
+*/
+
+/*!
+    \internal
+    \brief Constructs an empty cache with a limit of 512 kilobytes.
+*/
+QVirtualKeyGlyphCache::QVirtualKeyGlyphCache()
+    : hits(0)
+    , misses(0)
+    , cache(512 * 1024)
+{
+}
+
+/*!
+    \internal
+    \brief Returns \a text rendered with \a font, \a palette and \a style.
+
+    Only the mnemonic handling of the text \a flags is applied, the alignment
+    is up to the caller when drawing the returned pixmap.
+*/
+QPixmap QVirtualKeyGlyphCache::text(const QString &text, const QFont &font, const QPalette &palette, bool enabled, QStyle *style, uint flags)
+{
+    flags = Qt::AlignCenter | (flags & (Qt::TextShowMnemonic | Qt::TextHideMnemonic));
+    const QString key = QString::fromLatin1("t%1|%2|%3|%4|%5|%6|").arg(font.key()).arg(palette.cacheKey()).arg(int(palette.currentColorGroup()))
+                        .arg(int(enabled)).arg(flags).arg(qulonglong(quintptr(style))) + text;
+
+    if (QPixmap *cached = cache.object(key)) {
+        ++hits;
+        return *cached;
+    }
+    ++misses;
+
+    const QSize size = QFontMetrics(font).size(flags, text);
+    if (size.isEmpty())
+        return QPixmap();
+
+    QPixmap pixmap(size);
+    pixmap.fill(Qt::transparent);
+    QPainter painter(&pixmap);
+    painter.setFont(font);
+    style->drawItemText(&painter, pixmap.rect(), flags, palette, enabled, text, QPalette::ButtonText);
+    painter.end();
+    insert(key, pixmap);
+    return pixmap;
+}
+
+/*!
+    \internal
+    \brief Returns the pixmap of \a icon for \a size, \a mode and \a state.
+*/
+QPixmap QVirtualKeyGlyphCache::icon(const QIcon &icon, const QSize &size, QIcon::Mode mode, QIcon::State state)
+{
+    const QString key = QString::fromLatin1("i%1|%2x%3|%4|%5").arg(icon.cacheKey())
+                        .arg(size.width()).arg(size.height()).arg(int(mode)).arg(int(state));
+
+    if (QPixmap *cached = cache.object(key)) {
+        ++hits;
+        return *cached;
+    }
+    ++misses;
+    const QPixmap pixmap = icon.pixmap(size, mode, state);
+    insert(key, pixmap);
+    return pixmap;
+}
+
+typedef QCache<QString, QIcon> QVirtualKeyIconCache;
+Q_GLOBAL_STATIC_WITH_ARGS(QVirtualKeyIconCache, sharedIcons, (256))
+
+/*!
+    \internal
+    \brief Returns the icon of the image \a fileName, shared by all virtual keys.
+
+    The same QIcon (and thus the same cache key in the glyph caches) is returned
+    for the same file name, so the image is decoded once for all keys and layouts
+    which use it, and only when it is painted first. The 256 most recently used
+    icons are kept.
+*/
+QIcon QVirtualKeyGlyphCache::sharedIcon(const QString &fileName)
+{
+    QVirtualKeyIconCache *icons = sharedIcons();
+    if (!icons)
+        return QIcon(fileName);
+
+    if (QIcon *icon = icons->object(fileName))
+        return *icon;
+    const QIcon icon(fileName);
+    icons->insert(fileName, new QIcon(icon));
+    return icon;
+}
+
+/*!
+    \internal
+    \brief Stores \a pixmap under \a key with its size in bytes as cost.
+*/
+void QVirtualKeyGlyphCache::insert(const QString &key, const QPixmap &pixmap)
+{
+    const int cost = qMax(1, pixmap.width() * pixmap.height() * pixmap.depth() / 8);
+    cache.insert(key, new QPixmap(pixmap), cost);
+}
+
+/*!
+    \internal
+    \brief Sets the cache limit to \a bytes.
+*/
+void QVirtualKeyGlyphCache::setMaxCost(int bytes)
+{
+    cache.setMaxCost(bytes);
+}
+
+/*!
+    \internal
+    \brief Returns the cache limit in bytes.
+*/
+int QVirtualKeyGlyphCache::maxCost() const
+{
+    return cache.maxCost();
+}
+
+/*!
+    \internal
+    \brief Returns the number of bytes currently used by cached pixmaps.
+*/
+int QVirtualKeyGlyphCache::totalCost() const
+{
+    return cache.totalCost();
+}
+
+/*!
+    \internal
+    \brief Drops all cached pixmaps and resets the statistics.
+*/
+void QVirtualKeyGlyphCache::clear()
+{
+    cache.clear();
+    hits = 0;
+    misses = 0;
+}
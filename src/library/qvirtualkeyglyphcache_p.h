@@ -0,0 +1,50 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#ifndef QVIRTUALKEYGLYPHCACHE_P_H
+#define QVIRTUALKEYGLYPHCACHE_P_H
+
+#include <QCache>
+#include <QPixmap>
+#include <QIcon>
+#include <QString>
+
+class QFont;
+class QPalette;
+class QStyle;
+
+class QVirtualKeyGlyphCache
+{
+public:
+    QVirtualKeyGlyphCache();
+
+    QPixmap text(const QString &text, const QFont &font, const QPalette &palette, bool enabled, QStyle *style, uint flags);
+    QPixmap icon(const QIcon &icon, const QSize &size, QIcon::Mode mode, QIcon::State state);
+
+    static QIcon sharedIcon(const QString &fileName);
+
+    void setMaxCost(int bytes);
+    int maxCost() const;
+    int totalCost() const;
+    void clear();
+
+    int hits;
+    int misses;
+
+private:
+    void insert(const QString &key, const QPixmap &pixmap);
+
+    QCache<QString, QPixmap> cache;
+};
+
+#endif
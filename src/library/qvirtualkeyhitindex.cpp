@@ -0,0 +1,162 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include "qvirtualkeyhitindex_p.h"
+#include "qvirtualkey.h"
+
+#include <qmath.h>
+
+/*!
+    \internal
+    \class QVirtualKeyHitIndex qvirtualkeyhitindex_p.h
+    \brief Resolves positions in key containers to the nearest virtual key.
+
+    Every key container gets a uniform grid whose cells are about as large as
+    its keys, each cell lists the keys overlapping it. A position is resolved
+    by measuring the distance to the keys of its cell and the 8 neighbouring
+    cells only, so the cost does not depend on the number of keys. The grids
+    are rebuilt lazily after invalidate(), which is called whenever a key is
+    moved, resized, shown, hidden or (un)registered.
+
+    \sa QVirtualKeyboard::keyAt()
+*/
+
+/*!
+    \internal
+    \brief Constructs an empty index.
+*/
+QVirtualKeyHitIndex::QVirtualKeyHitIndex()
+    : revision(0)
+{
+}
+
+/*!
+    \internal
+    \brief Drops the grid of \a container.
+*/
+void QVirtualKeyHitIndex::remove(QObject *container)
+{
+    grids.remove(container);
+}
+
+/*!
+    \internal
+    \brief Returns the key of \a keys at \a pos in \a container coordinates, or the
+           nearest key not further away than \a radius pixels.
+
+    Distances to keys are divided by the weight of their text in \a weights, so
+    more probable keys win near the border between two keys. Keys without weight
+    have the weight 1. Disabled keys are never returned.
+*/
+QVirtualKey *QVirtualKeyHitIndex::keyAt(QWidget *container, const QList<QVirtualKey *> &keys, const QPoint &pos, int radius,
+                                        const QHash<QString, qreal> &weights)
+{
+    Grid &grid = grids[container];
+    if (grid.revision != revision || grid.radius != radius) {
+        build(&grid, container, keys, radius);
+        grid.revision = revision;
+    }
+    if (grid.keys.isEmpty() || !grid.bounds.adjusted(-radius, -radius, radius, radius).contains(pos))
+        return 0;
+
+    // The cells are at least 'radius' large, so the neighbouring cells contain all candidates
+    const int column = qBound(0, (pos.x() - grid.bounds.left()) / grid.cellSize, grid.columns - 1);
+    const int row = qBound(0, (pos.y() - grid.bounds.top()) / grid.cellSize, grid.rows - 1);
+
+    QVirtualKey *nearest = 0;
+    qreal nearestScore = 0;
+    for (int r = qMax(0, row - 1); r <= qMin(grid.rows - 1, row + 1); ++r) {
+        for (int c = qMax(0, column - 1); c <= qMin(grid.columns - 1, column + 1); ++c) {
+            const int cell = r * grid.columns + c;
+            for (int i = grid.cellStart.at(cell); i < grid.cellStart.at(cell + 1); ++i) {
+                const int k = grid.cellKeys.at(i);
+                const QRect &rect = grid.rects.at(k);
+                const int dx = qMax(qMax(rect.left() - pos.x(), pos.x() - rect.right()), 0);
+                const int dy = qMax(qMax(rect.top() - pos.y(), pos.y() - rect.bottom()), 0);
+                if (dx > radius || dy > radius || dx * dx + dy * dy > radius * radius)
+                    continue;
+
+                QVirtualKey *key = grid.keys.at(k);
+                if (!key->isEnabled())
+                    continue;
+                qreal score = qSqrt(qreal(dx * dx + dy * dy));
+                if (score > 0 && !weights.isEmpty())
+                    score /= qMax(weights.value(key->text().toLower(), 1.0), qreal(0.01));
+                if (!nearest || score < nearestScore) {
+                    nearest = key;
+                    nearestScore = score;
+                }
+            }
+        }
+    }
+    return nearest;
+}
+
+/*!
+    \internal
+    \brief Builds \a grid from the visible \a keys of \a container for hits up to
+           \a radius pixels away from a key.
+*/
+void QVirtualKeyHitIndex::build(Grid *grid, QWidget *container, const QList<QVirtualKey *> &keys, int radius)
+{
+    grid->radius = radius;
+    grid->bounds = QRect();
+    grid->keys.clear();
+    grid->rects.clear();
+
+    int extent = 0;
+    foreach (QVirtualKey *key, keys) {
+        if (!key->isVisibleTo(container))
+            continue;
+        const QRect rect(key->mapTo(container, QPoint(0, 0)), key->size());
+        grid->keys.append(key);
+        grid->rects.append(rect);
+        grid->bounds |= rect;
+        extent += qMax(rect.width(), rect.height());
+    }
+    if (grid->keys.isEmpty()) {
+        grid->columns = grid->rows = 0;
+        grid->cellStart.fill(0, 1);
+        grid->cellKeys.clear();
+        return;
+    }
+
+    grid->cellSize = qMax(qMax(extent / grid->keys.count(), radius), 1);
+    grid->columns = grid->bounds.width() / grid->cellSize + 1;
+    grid->rows = grid->bounds.height() / grid->cellSize + 1;
+
+    // Count the keys per cell first, then fill the cells in one array
+    const int cells = grid->columns * grid->rows;
+    QVector<int> count(cells + 1, 0);
+    for (int pass = 0; pass < 2; ++pass) {
+        if (pass == 1) {
+            grid->cellStart.resize(cells + 1);
+            grid->cellStart[0] = 0;
+            for (int i = 0; i < cells; ++i)
+                grid->cellStart[i + 1] = grid->cellStart.at(i) + count.at(i);
+            grid->cellKeys.resize(grid->cellStart.at(cells));
+            count.fill(0);
+        }
+        for (int k = 0; k < grid->rects.count(); ++k) {
+            const QRect rect = grid->rects.at(k).translated(-grid->bounds.topLeft());
+            for (int r = rect.top() / grid->cellSize; r <= rect.bottom() / grid->cellSize; ++r) {
+                for (int c = rect.left() / grid->cellSize; c <= rect.right() / grid->cellSize; ++c) {
+                    const int cell = r * grid->columns + c;
+                    if (pass == 1)
+                        grid->cellKeys[grid->cellStart.at(cell) + count.at(cell)] = k;
+                    ++count[cell];
+                }
+            }
+        }
+    }
+}
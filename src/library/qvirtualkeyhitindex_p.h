@@ -0,0 +1,63 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#ifndef QVIRTUALKEYHITINDEX_P_H
+#define QVIRTUALKEYHITINDEX_P_H
+
+#include <QHash>
+#include <QList>
+#include <QPoint>
+#include <QRect>
+#include <QString>
+#include <QVector>
+
+class QObject;
+class QWidget;
+class QVirtualKey;
+
+class QVirtualKeyHitIndex
+{
+public:
+    QVirtualKeyHitIndex();
+
+    void invalidate() { ++revision; }
+    void remove(QObject *container);
+
+    QVirtualKey *keyAt(QWidget *container, const QList<QVirtualKey *> &keys, const QPoint &pos, int radius,
+                       const QHash<QString, qreal> &weights);
+
+private:
+    // Uniform grid over the keys of one container, in container coordinates
+    struct Grid
+    {
+        Grid() : revision(-1), radius(0), cellSize(1), columns(0), rows(0) {}
+
+        int revision; ///< QVirtualKeyHitIndex::revision the grid was built with
+        int radius; ///< Hit radius the cell size was chosen for
+        QRect bounds; ///< Bounding rectangle of all keys
+        int cellSize;
+        int columns;
+        int rows;
+        QVector<QVirtualKey *> keys;
+        QVector<QRect> rects; ///< Geometry of keys
+        QVector<int> cellStart; ///< Keys of cell i are cellKeys[cellStart[i]] up to cellKeys[cellStart[i + 1]]
+        QVector<int> cellKeys; ///< Indexes into keys
+    };
+
+    static void build(Grid *grid, QWidget *container, const QList<QVirtualKey *> &keys, int radius);
+
+    QHash<QObject *, Grid> grids; ///< Grids by key container
+    int revision; ///< Incremented when a key geometry changes
+};
+
+#endif
@@ -0,0 +1,255 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include "qvirtualkeymodifierstate_p.h"
+
+#include <QDataStream>
+
+/*!
+    \internal
+    \class QVirtualKeyModifierState qvirtualkeymodifierstate_p.h
+    \brief Fixed-size state machine of the modifier keys of a virtual keyboard.
+
+    The state holds up to MaximumModifiers modifier keys, the 'shift' and 'alt'
+    modifiers of the virtual keyboard always use the first two entries. Every
+    modifier counts its pressed virtual keys, so two shift keys can be pressed
+    and released in any order. Depending on its mode a modifier is active:
+
+    \list
+    \o MomentaryModifier: while one of its keys is pressed.
+    \o LatchingModifier: while pressed, and after a press and release without
+       other keys in between until the next key press (latched). Pressing it
+       again while latched locks it, pressing it once more unlocks it.
+    \o LockingModifier: from one press until the next press.
+    \endlist
+
+    Additionally a modifier can be held independent of its mode with hold(),
+    which is used by caps lock for the 'shift' modifier.
+
+    \sa QVirtualKeyboard::addModifier()
+*/
+
+/*!
+    \internal
+    \brief Constructs a state with the momentary \a shiftKey and \a altKey modifiers.
+*/
+QVirtualKeyModifierState::QVirtualKeyModifierState(Qt::Key shiftKey, Qt::Key altKey)
+    : modifierCount(0)
+{
+    add(shiftKey, QVirtualKeyboard::MomentaryModifier);
+    add(altKey, QVirtualKeyboard::MomentaryModifier);
+}
+
+/*!
+    \internal
+    \brief Returns the index of the modifier \a key or -1.
+*/
+int QVirtualKeyModifierState::indexOf(Qt::Key key) const
+{
+    for (int i = 0; i < modifierCount; ++i) {
+        if (modifiers[i].key == quint32(key))
+            return i;
+    }
+    return -1;
+}
+
+/*!
+    \internal
+    \brief Changes the key of the modifier at \a index to \a key and releases it.
+*/
+void QVirtualKeyModifierState::setKey(int index, Qt::Key key)
+{
+    Modifier &modifier = modifiers[index];
+    modifier.key = key;
+    modifier.pressCount = modifier.holdCount = modifier.flags = 0;
+}
+
+/*!
+    \internal
+    \brief Changes the mode of the modifier at \a index to \a mode and drops its latch or lock.
+*/
+void QVirtualKeyModifierState::setMode(int index, QVirtualKeyboard::ModifierMode mode)
+{
+    modifiers[index].mode = mode;
+    modifiers[index].flags = 0;
+}
+
+/*!
+    \internal
+    \brief Adds the modifier \a key with \a mode and returns its index, or -1 if
+           all MaximumModifiers are used.
+*/
+int QVirtualKeyModifierState::add(Qt::Key key, QVirtualKeyboard::ModifierMode mode)
+{
+    if (modifierCount == MaximumModifiers)
+        return -1;
+
+    const int index = modifierCount++;
+    setKey(index, key);
+    setMode(index, mode);
+    return index;
+}
+
+/*!
+    \internal
+    \brief Removes the modifier at \a index, the 'shift' and 'alt' modifiers cannot be removed.
+*/
+void QVirtualKeyModifierState::remove(int index)
+{
+    if (index <= AltIndex || index >= modifierCount)
+        return;
+    for (int i = index + 1; i < modifierCount; ++i)
+        modifiers[i - 1] = modifiers[i];
+    --modifierCount;
+}
+
+/*!
+    \internal
+    \brief Handles a press of a virtual key of the modifier at \a index.
+*/
+void QVirtualKeyModifierState::press(int index)
+{
+    Modifier &modifier = modifiers[index];
+    if (modifier.pressCount == 0xff)
+        return;
+
+    if (++modifier.pressCount == 1) {
+        if (modifier.mode == QVirtualKeyboard::LatchingModifier)
+            modifier.flags &= ~Chorded;
+        else if (modifier.mode == QVirtualKeyboard::LockingModifier)
+            modifier.flags ^= Locked;
+    }
+}
+
+/*!
+    \internal
+    \brief Handles a release of a virtual key of the modifier at \a index.
+
+    Releases without a preceding press are ignored.
+*/
+void QVirtualKeyModifierState::release(int index)
+{
+    Modifier &modifier = modifiers[index];
+    if (modifier.pressCount == 0)
+        return;
+
+    if (--modifier.pressCount == 0 && modifier.mode == QVirtualKeyboard::LatchingModifier
+            && !(modifier.flags & Chorded)) {
+        // Tapped without another key: latch, then lock, then release
+        if (modifier.flags & Locked)
+            modifier.flags = 0;
+        else if (modifier.flags & Latched)
+            modifier.flags = Locked;
+        else
+            modifier.flags = Latched;
+    }
+}
+
+/*!
+    \internal
+    \brief Holds or releases the modifier at \a index regardless of its mode if \a held.
+*/
+void QVirtualKeyModifierState::hold(int index, bool held)
+{
+    Modifier &modifier = modifiers[index];
+    if (held && modifier.holdCount < 0xff)
+        ++modifier.holdCount;
+    else if (!held && modifier.holdCount > 0)
+        --modifier.holdCount;
+}
+
+/*!
+    \internal
+    \brief Updates the state after a key which is no modifier was pressed.
+
+    Latched modifiers are released, pressed latching modifiers no longer latch
+    when they are released.
+*/
+void QVirtualKeyModifierState::keyPressed()
+{
+    for (int i = 0; i < modifierCount; ++i) {
+        Modifier &modifier = modifiers[i];
+        if (modifier.pressCount > 0)
+            modifier.flags |= Chorded;
+        modifier.flags &= ~Latched;
+    }
+}
+
+/*!
+    \internal
+    \brief Releases all modifiers, including latched and locked ones.
+*/
+void QVirtualKeyModifierState::reset()
+{
+    for (int i = 0; i < modifierCount; ++i)
+        modifiers[i].pressCount = modifiers[i].holdCount = modifiers[i].flags = 0;
+}
+
+/*!
+    \internal
+    \brief Writes the modifiers with their keys, modes and current state to \a out.
+*/
+void QVirtualKeyModifierState::save(QDataStream &out) const
+{
+    out << quint8(modifierCount);
+    for (int i = 0; i < modifierCount; ++i) {
+        const Modifier &modifier = modifiers[i];
+        out << modifier.key << modifier.mode << modifier.pressCount << modifier.holdCount << modifier.flags;
+    }
+}
+
+/*!
+    \internal
+    \brief Replaces the modifiers with the ones written by save() to \a in.
+
+    Returns false and leaves the state unchanged if \a in holds no valid state.
+*/
+bool QVirtualKeyModifierState::load(QDataStream &in)
+{
+    quint8 count = 0;
+    in >> count;
+    if (count <= AltIndex || count > MaximumModifiers)
+        return false;
+
+    Modifier loaded[MaximumModifiers];
+    for (int i = 0; i < count; ++i) {
+        Modifier &modifier = loaded[i];
+        in >> modifier.key >> modifier.mode >> modifier.pressCount >> modifier.holdCount >> modifier.flags;
+        if (modifier.mode > QVirtualKeyboard::LockingModifier)
+            return false;
+    }
+    if (in.status() != QDataStream::Ok)
+        return false;
+
+    for (int i = 0; i < count; ++i)
+        modifiers[i] = loaded[i];
+    modifierCount = count;
+    return true;
+}
+
+/*!
+    \internal
+    \brief Returns a bit mask of the active modifiers, bit n is set if the modifier
+           at index n is active.
+*/
+uint QVirtualKeyModifierState::activeMask() const
+{
+    uint mask = 0;
+    for (int i = 0; i < modifierCount; ++i) {
+        const Modifier &modifier = modifiers[i];
+        const bool pressed = modifier.pressCount > 0 && modifier.mode != QVirtualKeyboard::LockingModifier;
+        if (pressed || modifier.holdCount > 0 || (modifier.flags & (Latched | Locked)))
+            mask |= 1 << i;
+    }
+    return mask;
+}
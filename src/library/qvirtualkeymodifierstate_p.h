@@ -0,0 +1,66 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#ifndef QVIRTUALKEYMODIFIERSTATE_P_H
+#define QVIRTUALKEYMODIFIERSTATE_P_H
+
+#include "qvirtualkeyboard.h"
+
+class QDataStream;
+
+class Q_QVK_EXPORT QVirtualKeyModifierState
+{
+public:
+    enum { ShiftIndex = 0, AltIndex = 1, MaximumModifiers = 8 };
+
+    QVirtualKeyModifierState(Qt::Key shiftKey, Qt::Key altKey);
+
+    int count() const { return modifierCount; }
+    int indexOf(Qt::Key key) const;
+    Qt::Key key(int index) const { return Qt::Key(modifiers[index].key); }
+    void setKey(int index, Qt::Key key);
+    QVirtualKeyboard::ModifierMode mode(int index) const { return QVirtualKeyboard::ModifierMode(modifiers[index].mode); }
+    void setMode(int index, QVirtualKeyboard::ModifierMode mode);
+    int add(Qt::Key key, QVirtualKeyboard::ModifierMode mode);
+    void remove(int index);
+
+    void press(int index);
+    void release(int index);
+    void hold(int index, bool held);
+    void keyPressed();
+    void reset();
+
+    void save(QDataStream &out) const;
+    bool load(QDataStream &in);
+
+    bool isActive(int index) const { return activeMask() & (1 << index); }
+    bool isLocked(int index) const { return modifiers[index].flags & (Latched | Locked); }
+    uint activeMask() const;
+
+private:
+    enum Flag { Latched = 0x1, Locked = 0x2, Chorded = 0x4 };
+
+    struct Modifier
+    {
+        quint32 key; ///< Qt::Key of the modifier
+        quint8 mode; ///< QVirtualKeyboard::ModifierMode
+        quint8 pressCount; ///< Number of pressed virtual keys of the modifier
+        quint8 holdCount; ///< Presses which bypass the mode, e.g. from caps lock
+        quint8 flags; ///< Combination of Flag values
+    };
+
+    Modifier modifiers[MaximumModifiers];
+    int modifierCount;
+};
+
+#endif
@@ -0,0 +1,749 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include "qvirtualkeypredictor.h"
+#include "qvirtualkeypredictor_p.h"
+#include "qvirtualkeyboard_p.h"
+
+#include <QMap>
+#include <QTextStream>
+#include <QVarLengthArray>
+#include <QVector>
+#include <QtEndian>
+#include <QDebug>
+#include <qmath.h>
+#if QT_VERSION >= 0x040800
+#  include <QElapsedTimer>
+#else
+#  include <QTime>
+#endif
+
+#include <algorithm>
+
+/*
+    Dictionary format (all integers are little endian):
+
+    Header      "QVKD", format version, node count, word count (32 bit each)
+    Nodes       node count records of 8 bytes in breadth first order, so the
+                children of a node are stored next to each other and sorted by
+                character: character (16 bit UTF-16), frequency (8 bit, 0 if no
+                word ends here), maximum frequency in the subtree (8 bit), index
+                of the first child (31 bit, 0 for none) and a last sibling flag
+                (bit 31). Node 0 is the root, its character is not used.
+*/
+
+static const char dictionaryMagic[4] = { 'Q', 'V', 'K', 'D' };
+static const quint32 dictionaryFormatVersion = 1;
+static const quint32 lastSiblingFlag = 0x80000000;
+
+static inline void appendUInt32(QByteArray &data, quint32 value)
+{
+    uchar buffer[4];
+    qToLittleEndian<quint32>(value, buffer);
+    data.append(reinterpret_cast<const char *>(buffer), 4);
+}
+
+// Measures the time spent on a lookup in microseconds
+class QVirtualKeyBudgetTimer
+{
+public:
+    QVirtualKeyBudgetTimer() { timer.start(); }
+
+#if QT_VERSION >= 0x040800
+    qint64 elapsed() const { return timer.nsecsElapsed() / 1000; }
+
+private:
+    QElapsedTimer timer;
+#else
+    qint64 elapsed() const { return qint64(timer.elapsed()) * 1000; }
+
+private:
+    QTime timer;
+#endif
+};
+
+// Node reached by the completion search, linked to the node it was reached from
+struct QVirtualKeySearchStep
+{
+    quint32 node;
+    int parent; ///< Index of the previous step, -1 for a node matching the prefix
+};
+
+// Search queue entry, ordered by the best frequency reachable through it
+struct QVirtualKeySearchEntry
+{
+    int priority; ///< Frequency times two, plus one if the entry is a complete word
+    int step;
+
+    bool operator<(const QVirtualKeySearchEntry &other) const { return priority < other.priority; }
+};
+
+// Trie node while a dictionary is built
+struct QVirtualKeyBuildNode
+{
+    QVirtualKeyBuildNode(QChar character = QChar()) : character(character), frequency(0), maximumFrequency(0) {}
+
+    QChar character;
+    int frequency;
+    int maximumFrequency;
+    QMap<QChar, int> children; ///< Child node indexes by character
+};
+
+/*!
+    \internal
+    \class QVirtualKeyDictionary qvirtualkeypredictor_p.h
+    \brief Read-only word list for completions, stored as a memory mapped trie.
+
+    Every node stores the highest word frequency found below it, so the most
+    frequent completions of a prefix are found by a best-first search which
+    visits only a few nodes more than the completions are long, independent
+    of the size of the dictionary.
+
+    \sa QVirtualKeyPredictor
+*/
+
+/*!
+    \internal
+    \brief Constructs an empty dictionary.
+*/
+QVirtualKeyDictionary::QVirtualKeyDictionary()
+    : mapped(0)
+    , nodes(0)
+    , nodeCount(0)
+    , wordCount(0)
+{
+}
+
+/*!
+    \internal
+    \brief Destroys the dictionary and unmaps its file.
+*/
+QVirtualKeyDictionary::~QVirtualKeyDictionary()
+{
+    clear();
+}
+
+/*!
+    \internal
+    \brief Loads the compiled dictionary \a fileName.
+
+    The file is memory mapped if the underlying file engine supports it,
+    otherwise it is read into memory at once.
+*/
+bool QVirtualKeyDictionary::load(const QString &fileName, QString *errorString)
+{
+    clear();
+
+    file.setFileName(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        if (errorString)
+            *errorString = QObject::tr("Unable to open dictionary: %1").arg(file.errorString());
+        return false;
+    }
+
+    qint64 size = file.size();
+    const uchar *base = mapped = size > 0 ? file.map(0, size) : 0;
+    if (!mapped) {
+        data = file.readAll();
+        file.close();
+        base = reinterpret_cast<const uchar *>(data.constData());
+        size = data.size();
+    }
+
+    QString error;
+    if (size < headerSize || qstrncmp(reinterpret_cast<const char *>(base), dictionaryMagic, sizeof(dictionaryMagic)) != 0)
+        error = QObject::tr("The file is not a virtual keyboard dictionary.");
+    else if (qFromLittleEndian<quint32>(base + 4) != dictionaryFormatVersion)
+        error = QObject::tr("Unsupported dictionary format version %1.").arg(qFromLittleEndian<quint32>(base + 4));
+    else if (qFromLittleEndian<quint32>(base + 8) == 0
+             || quint64(size - headerSize) / nodeSize < qFromLittleEndian<quint32>(base + 8))
+        error = QObject::tr("The dictionary file is truncated.");
+
+    if (!error.isEmpty()) {
+        if (errorString)
+            *errorString = error;
+        clear();
+        return false;
+    }
+
+    nodes = base + headerSize;
+    nodeCount = qFromLittleEndian<quint32>(base + 8);
+    wordCount = qFromLittleEndian<quint32>(base + 12);
+    return true;
+}
+
+/*!
+    \internal
+    \brief Unloads the dictionary.
+*/
+void QVirtualKeyDictionary::clear()
+{
+    if (mapped)
+        file.unmap(mapped);
+    mapped = 0;
+    file.close();
+    data.clear();
+    nodes = 0;
+    nodeCount = 0;
+    wordCount = 0;
+}
+
+inline QChar QVirtualKeyDictionary::character(quint32 node) const
+{
+    return QChar(ushort(qFromLittleEndian<quint32>(nodes + node * nodeSize) & 0xffff));
+}
+
+inline int QVirtualKeyDictionary::frequency(quint32 node) const
+{
+    return (qFromLittleEndian<quint32>(nodes + node * nodeSize) >> 16) & 0xff;
+}
+
+inline int QVirtualKeyDictionary::maximumFrequency(quint32 node) const
+{
+    return qFromLittleEndian<quint32>(nodes + node * nodeSize) >> 24;
+}
+
+inline quint32 QVirtualKeyDictionary::firstChild(quint32 node) const
+{
+    return qFromLittleEndian<quint32>(nodes + node * nodeSize + 4) & ~lastSiblingFlag;
+}
+
+inline bool QVirtualKeyDictionary::isLastSibling(quint32 node) const
+{
+    return qFromLittleEndian<quint32>(nodes + node * nodeSize + 4) & lastSiblingFlag;
+}
+
+/*!
+    \internal
+    \brief Stores up to \a maximum words starting with \a prefix in \a candidates,
+           most frequent first.
+
+    Letters of \a prefix match both their upper and lower case form, the
+    candidates start with \a prefix as given followed by the rest of the
+    dictionary word. \a prefix itself is never a candidate.
+
+    If the search takes longer than \a budget microseconds, it stops with the
+    candidates found so far and false is returned.
+*/
+bool QVirtualKeyDictionary::complete(const QString &prefix, int maximum, qint64 budget, QStringList *candidates) const
+{
+    candidates->clear();
+    if (isEmpty() || maximum <= 0)
+        return true;
+
+    QVirtualKeyBudgetTimer timer;
+
+    // Nodes matching the prefix, there is more than one if it matches in different cases
+    QVarLengthArray<quint32, 4> matches;
+    matches.append(0);
+    for (int i = 0; i < prefix.length() && matches.size() > 0; ++i) {
+        const QChar c = prefix.at(i).toLower();
+        QVarLengthArray<quint32, 4> next;
+        for (int j = 0; j < matches.size(); ++j) {
+            for (quint32 child = firstChild(matches[j]); child && child < nodeCount; ++child) {
+                if (character(child).toLower() == c)
+                    next.append(child);
+                if (isLastSibling(child))
+                    break;
+            }
+        }
+        matches = next;
+    }
+
+    QVector<QVirtualKeySearchStep> steps;
+    QVector<QVirtualKeySearchEntry> queue;
+    for (int i = 0; i < matches.size(); ++i) {
+        const QVirtualKeySearchStep step = { matches[i], -1 };
+        const QVirtualKeySearchEntry entry = { maximumFrequency(matches[i]) * 2, steps.count() };
+        steps.append(step);
+        queue.append(entry);
+    }
+    std::make_heap(queue.begin(), queue.end());
+
+    int visited = 0;
+    while (!queue.isEmpty() && candidates->count() < maximum) {
+        if ((++visited & 31) == 0 && timer.elapsed() > budget)
+            return false;
+
+        std::pop_heap(queue.begin(), queue.end());
+        const QVirtualKeySearchEntry entry = queue.last();
+        queue.resize(queue.count() - 1);
+        const quint32 node = steps.at(entry.step).node;
+
+        // No entry left in the queue can lead to a more frequent word than this one
+        if (entry.priority & 1) {
+            QString suffix;
+            for (int s = entry.step; steps.at(s).parent >= 0; s = steps.at(s).parent)
+                suffix.prepend(character(steps.at(s).node));
+            const QString candidate = prefix + suffix;
+            if (!suffix.isEmpty() && !candidates->contains(candidate))
+                candidates->append(candidate);
+            continue;
+        }
+
+        if (frequency(node) > 0) {
+            const QVirtualKeySearchEntry word = { frequency(node) * 2 + 1, entry.step };
+            queue.append(word);
+            std::push_heap(queue.begin(), queue.end());
+        }
+        for (quint32 child = firstChild(node); child && child < nodeCount; ++child) {
+            const QVirtualKeySearchStep step = { child, entry.step };
+            const QVirtualKeySearchEntry next = { maximumFrequency(child) * 2, steps.count() };
+            steps.append(step);
+            queue.append(next);
+            std::push_heap(queue.begin(), queue.end());
+            if (isLastSibling(child))
+                break;
+        }
+    }
+    return true;
+}
+
+/*!
+    \internal
+    \brief Returns the compiled dictionary of \a words, each with a frequency from 1 to 255.
+
+    Words given more than once keep their highest frequency.
+*/
+QByteArray QVirtualKeyDictionary::build(const QList<QPair<QString, quint32> > &words)
+{
+    QVector<QVirtualKeyBuildNode> trie(1);
+    quint32 wordCount = 0;
+    for (int i = 0; i < words.count(); ++i) {
+        const QString &word = words.at(i).first;
+        if (word.isEmpty())
+            continue;
+
+        int node = 0;
+        for (int j = 0; j < word.length(); ++j) {
+            const QChar c = word.at(j);
+            const int child = trie.at(node).children.value(c, -1);
+            if (child < 0) {
+                trie.append(QVirtualKeyBuildNode(c));
+                trie[node].children.insert(c, trie.count() - 1);
+                node = trie.count() - 1;
+            } else {
+                node = child;
+            }
+        }
+        if (trie.at(node).frequency == 0)
+            ++wordCount;
+        trie[node].frequency = qBound(int(trie.at(node).frequency), int(words.at(i).second), 255);
+    }
+
+    // Children are always added after their parent
+    for (int i = trie.count() - 1; i >= 0; --i) {
+        int maximum = trie.at(i).frequency;
+        foreach (int child, trie.at(i).children)
+            maximum = qMax(maximum, trie.at(child).maximumFrequency);
+        trie[i].maximumFrequency = maximum;
+    }
+
+    // Breadth first order keeps the children of a node next to each other
+    QVector<int> order;
+    QVector<quint32> index(trie.count());
+    QVector<bool> lastSibling(trie.count());
+    order.append(0);
+    lastSibling[0] = true;
+    for (int i = 0; i < order.count(); ++i) {
+        const QMap<QChar, int> &children = trie.at(order.at(i)).children;
+        foreach (int child, children) {
+            index[child] = order.count();
+            order.append(child);
+        }
+        if (!children.isEmpty())
+            lastSibling[order.last()] = true;
+    }
+
+    QByteArray data;
+    data.reserve(headerSize + order.count() * nodeSize);
+    data.append(dictionaryMagic, sizeof(dictionaryMagic));
+    appendUInt32(data, dictionaryFormatVersion);
+    appendUInt32(data, order.count());
+    appendUInt32(data, wordCount);
+    foreach (int i, order) {
+        const QVirtualKeyBuildNode &node = trie.at(i);
+        appendUInt32(data, node.character.unicode() | (quint32(node.frequency) << 16) | (quint32(node.maximumFrequency) << 24));
+        const quint32 first = node.children.isEmpty() ? 0 : index.at(node.children.constBegin().value());
+        appendUInt32(data, first | (lastSibling.at(i) ? lastSiblingFlag : 0));
+    }
+    return data;
+}
+
+/*!
+    \class QVirtualKeyPredictor qvirtualkeypredictor.h
+    \brief The QVirtualKeyPredictor class offers completions of the word typed
+           on a virtual keyboard.
+    \mainclass
+
+    The predictor watches the key stream of a QVirtualKeyboard set with
+    setKeyboard() and keeps track of the word being typed: letters extend it,
+    backspace shortens it, and any other key ends it. After every change the
+    most frequent completions of the word are looked up in a dictionary and
+    reported with candidatesChanged().
+
+    Dictionaries are compiled from word lists with compileDictionary() or the
+    \c qvkmc tool and memory mapped by loadDictionary(), so their pages are
+    shared between processes and only touched as far as lookups need them.
+    A lookup visits only the nodes on the way to the best completions, so its
+    cost depends on the length of the words, not on the size of the dictionary.
+    The time a lookup may take per key stroke is limited by timeBudget().
+
+    \code
+    QVirtualKeyPredictor *predictor = new QVirtualKeyPredictor(this);
+    predictor->loadDictionary("en_US.qvkd");
+    predictor->setKeyboard(keyboard);
+    connect(predictor, SIGNAL(candidatesChanged(QStringList)), this, SLOT(showCandidates(QStringList)));
+    \endcode
+
+    \sa QVirtualKeyboard
+*/
+
+/*!
+    \fn void QVirtualKeyPredictor::candidatesChanged(const QStringList &candidates)
+    \brief This signal is emitted when the completions of the current word change.
+
+    The \a candidates are complete words starting with currentWord(), most
+    frequent first. The list is empty when no word is being typed.
+*/
+
+/*!
+    \brief Constructs a predictor without dictionary with the given \a parent.
+*/
+QVirtualKeyPredictor::QVirtualKeyPredictor(QObject *parent)
+    : QObject(parent)
+    , d(new QVirtualKeyPredictorPrivate)
+{
+}
+
+/*!
+    \brief Destroys the predictor.
+*/
+QVirtualKeyPredictor::~QVirtualKeyPredictor()
+{
+    if (d->keyboard)
+        d->keyboard->d->predictors.removeAll(this);
+    delete d;
+}
+
+/*!
+    \brief Watches the key stream of \a keyboard, replacing the previous keyboard.
+
+    The key presses are taken from QVirtualKeyboard::keyPressed(), or directly from
+    the keyboard if they are delivered with QVirtualKeyboard::keyEventBatch().
+    Pass 0 to stop watching.
+*/
+void QVirtualKeyPredictor::setKeyboard(QVirtualKeyboard *keyboard)
+{
+    if (d->keyboard) {
+        disconnect(d->keyboard, 0, this, 0);
+        d->keyboard->d->predictors.removeAll(this);
+        if (d->keyWeighting)
+            d->keyboard->setKeyWeights(QHash<QString, qreal>());
+    }
+    d->keyboard = keyboard;
+    if (keyboard) {
+        connect(keyboard, SIGNAL(keyPressed(int, Qt::KeyboardModifiers, const QString &)),
+                this, SLOT(processKey(int, Qt::KeyboardModifiers, const QString &)));
+        keyboard->d->predictors.append(this);
+    }
+    reset();
+}
+
+/*!
+    \brief Returns the keyboard whose key stream is watched.
+*/
+QVirtualKeyboard *QVirtualKeyPredictor::keyboard() const
+{
+    return d->keyboard;
+}
+
+/*!
+    \brief Loads the compiled dictionary \a fileName, replacing the previous one.
+
+    \sa compileDictionary()
+*/
+bool QVirtualKeyPredictor::loadDictionary(const QString &fileName)
+{
+    QString errorString;
+    const bool ok = d->dictionary.load(fileName, &errorString);
+    if (!ok)
+        qWarning() << "QVirtualKeyPredictor::loadDictionary(" << fileName << ")" << errorString;
+    updateCandidates();
+    return ok;
+}
+
+/*!
+    \brief Unloads the dictionary, no candidates are offered anymore.
+*/
+void QVirtualKeyPredictor::unloadDictionary()
+{
+    d->dictionary.clear();
+    updateCandidates();
+}
+
+/*!
+    \brief Returns the number of words in the dictionary.
+*/
+int QVirtualKeyPredictor::dictionaryWords() const
+{
+    return d->dictionary.words();
+}
+
+/*!
+    \brief Returns the size of the dictionary in bytes.
+*/
+int QVirtualKeyPredictor::dictionarySize() const
+{
+    return d->dictionary.size();
+}
+
+/*!
+    \brief Compiles the word list \a wordListFile into the dictionary \a fileName.
+
+    The word list is a UTF-8 text file with one word per line, optionally
+    followed by white space and the number of occurrences of the word in a
+    text corpus. Without numbers, words listed earlier are considered more
+    frequent. Empty lines and lines starting with '#' are ignored.
+
+    \sa loadDictionary()
+*/
+bool QVirtualKeyPredictor::compileDictionary(const QString &wordListFile, const QString &fileName, QString *errorString)
+{
+    QFile input(wordListFile);
+    if (!input.open(QFile::ReadOnly | QFile::Text)) {
+        if (errorString)
+            *errorString = QObject::tr("Unable to open word list: %1").arg(input.errorString());
+        return false;
+    }
+
+    QList<QPair<QString, qint64> > counts;
+    qint64 maximumCount = 0;
+    QTextStream stream(&input);
+    stream.setCodec("UTF-8");
+    while (!stream.atEnd()) {
+        const QString line = stream.readLine().simplified();
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#')))
+            continue;
+        const int space = line.indexOf(QLatin1Char(' '));
+        const qint64 count = space < 0 ? -1 : qMax(line.mid(space + 1).toLongLong(), Q_INT64_C(0));
+        counts.append(qMakePair(line.left(space), count));
+        maximumCount = qMax(maximumCount, count);
+    }
+
+    // Frequencies are scaled logarithmically to 1..255
+    QList<QPair<QString, quint32> > words;
+    for (int i = 0; i < counts.count(); ++i) {
+        quint32 frequency;
+        if (maximumCount > 0)
+            frequency = 1 + quint32(254 * qLn(1 + qMax(counts.at(i).second, Q_INT64_C(0))) / qLn(1 + maximumCount));
+        else
+            frequency = 255 - quint32(254 * qint64(i) / counts.count());
+        words.append(qMakePair(counts.at(i).first, frequency));
+    }
+
+    QFile output(fileName);
+    const QByteArray data = QVirtualKeyDictionary::build(words);
+    if (!output.open(QFile::WriteOnly | QFile::Truncate) || output.write(data) != data.size()) {
+        if (errorString)
+            *errorString = output.errorString();
+        return false;
+    }
+    return true;
+}
+
+/*!
+    \brief Limits the number of candidates offered to \a count, the default is 5.
+*/
+void QVirtualKeyPredictor::setMaximumCandidates(int count)
+{
+    d->maximumCandidates = qMax(0, count);
+    updateCandidates();
+}
+
+/*!
+    \brief Returns the maximum number of candidates offered.
+*/
+int QVirtualKeyPredictor::maximumCandidates() const
+{
+    return d->maximumCandidates;
+}
+
+/*!
+    \brief Limits the time a lookup may take to \a microseconds, the default is 1000.
+
+    If a lookup is not finished in time, the candidates found so far are offered.
+*/
+void QVirtualKeyPredictor::setTimeBudget(int microseconds)
+{
+    d->timeBudget = qMax(0, microseconds);
+}
+
+/*!
+    \brief Returns the time a lookup may take in microseconds.
+*/
+int QVirtualKeyPredictor::timeBudget() const
+{
+    return d->timeBudget;
+}
+
+/*!
+    \brief Makes presses between keys of the keyboard prefer likely next letters if
+           \a enabled, the default is false.
+
+    After every lookup the keys continuing the candidates get a weight of up to
+    2 with QVirtualKeyboard::setKeyWeights(), the more and the more frequent
+    candidates continue with a key, the higher.
+
+    \sa QVirtualKeyboard::keyAt()
+*/
+void QVirtualKeyPredictor::setKeyWeighting(bool enabled)
+{
+    if (d->keyWeighting == enabled)
+        return;
+    d->keyWeighting = enabled;
+    if (d->keyboard)
+        d->keyboard->setKeyWeights(QHash<QString, qreal>());
+    updateKeyWeights();
+}
+
+/*!
+    \brief Returns true if presses between keys prefer likely next letters.
+*/
+bool QVirtualKeyPredictor::keyWeighting() const
+{
+    return d->keyWeighting;
+}
+
+/*!
+    \brief Returns the word typed so far.
+*/
+QString QVirtualKeyPredictor::currentWord() const
+{
+    return d->word;
+}
+
+/*!
+    \brief Returns the completions of currentWord(), most frequent first.
+*/
+QStringList QVirtualKeyPredictor::candidates() const
+{
+    return d->candidates;
+}
+
+/*!
+    \brief Returns up to \a maximum completions of \a prefix, most frequent first.
+
+    The lookup is limited by timeBudget() like the ones for the key stream.
+*/
+QStringList QVirtualKeyPredictor::complete(const QString &prefix, int maximum) const
+{
+    QStringList candidates;
+    d->dictionary.complete(prefix, maximum, d->timeBudget, &candidates);
+    return candidates;
+}
+
+/*!
+    \brief Updates the current word with the pressed \a key, its \a modifiers and \a text.
+
+    This slot is connected to QVirtualKeyboard::keyPressed() by setKeyboard(),
+    but can also be fed from other sources. Presses without key code and text,
+    which the keyboard generates while dead keys are pending, keep the word.
+*/
+void QVirtualKeyPredictor::processKey(int key, Qt::KeyboardModifiers modifiers, const QString &text)
+{
+    if (key == Qt::Key_unknown && text.isEmpty())
+        return;
+
+    switch (key) {
+        case Qt::Key_Backspace:
+            if (!d->word.isEmpty()) {
+                d->word.chop(1);
+                updateCandidates();
+            }
+            return;
+        case Qt::Key_Shift:
+        case Qt::Key_Control:
+        case Qt::Key_Alt:
+        case Qt::Key_AltGr:
+        case Qt::Key_Meta:
+        case Qt::Key_CapsLock:
+            return;
+        default:
+            if (QVirtualKeyboard::isDeadKey(Qt::Key(key)))
+                return;
+    }
+
+    bool letters = !text.isEmpty() && !(modifiers & (Qt::ControlModifier | Qt::MetaModifier));
+    for (int i = 0; letters && i < text.length(); ++i)
+        letters = text.at(i).isLetterOrNumber() || text.at(i) == QLatin1Char('\'');
+
+    if (letters) {
+        d->word += text;
+        updateCandidates();
+    } else {
+        reset();
+    }
+}
+
+/*!
+    \brief Forgets the current word, for example when the text cursor was moved.
+*/
+void QVirtualKeyPredictor::reset()
+{
+    d->word.clear();
+    updateCandidates();
+}
+
+/*!
+    \internal
+    \brief Looks up the completions of the current word and reports them if they changed.
+*/
+void QVirtualKeyPredictor::updateCandidates()
+{
+    QStringList candidates;
+    if (!d->word.isEmpty())
+        d->dictionary.complete(d->word, d->maximumCandidates, d->timeBudget, &candidates);
+    if (candidates != d->candidates) {
+        d->candidates = candidates;
+        emit candidatesChanged(candidates);
+    }
+    updateKeyWeights();
+}
+
+/*!
+    \internal
+    \brief Weights the keys of the keyboard by the share of candidates continuing with them.
+
+    Candidates count by their rank, the first one 1, the second one 1/2 and so on.
+*/
+void QVirtualKeyPredictor::updateKeyWeights()
+{
+    if (!d->keyWeighting || !d->keyboard)
+        return;
+
+    QHash<QString, qreal> weights;
+    qreal total = 0;
+    const int next = d->word.length();
+    for (int i = 0; i < d->candidates.count(); ++i) {
+        const QString &candidate = d->candidates.at(i);
+        if (candidate.length() <= next)
+            continue;
+        const qreal share = qreal(1) / (i + 1);
+        weights[candidate.at(next).toLower()] += share;
+        total += share;
+    }
+    for (QHash<QString, qreal>::iterator it = weights.begin(); it != weights.end(); ++it)
+        it.value() = 1 + it.value() / total;
+    d->keyboard->setKeyWeights(weights);
+}
@@ -0,0 +1,71 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#ifndef QVIRTUALKEYPREDICTOR_H
+#define QVIRTUALKEYPREDICTOR_H
+
+#include <QObject>
+#include <QStringList>
+
+#include "qvirtualkeyboardglobal.h"
+
+class QVirtualKeyboard;
+class QVirtualKeyPredictorPrivate;
+
+class Q_QVK_EXPORT QVirtualKeyPredictor : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(int maximumCandidates READ maximumCandidates WRITE setMaximumCandidates)
+    Q_PROPERTY(int timeBudget READ timeBudget WRITE setTimeBudget)
+    Q_PROPERTY(bool keyWeighting READ keyWeighting WRITE setKeyWeighting)
+
+public:
+    explicit QVirtualKeyPredictor(QObject *parent = 0);
+    virtual ~QVirtualKeyPredictor();
+
+    void setKeyboard(QVirtualKeyboard *keyboard);
+    QVirtualKeyboard *keyboard() const;
+
+    bool loadDictionary(const QString &fileName);
+    void unloadDictionary();
+    int dictionaryWords() const;
+    int dictionarySize() const;
+    static bool compileDictionary(const QString &wordListFile, const QString &fileName, QString *errorString = 0);
+
+    void setMaximumCandidates(int count);
+    int maximumCandidates() const;
+    void setTimeBudget(int microseconds);
+    int timeBudget() const;
+    void setKeyWeighting(bool enabled);
+    bool keyWeighting() const;
+
+    QString currentWord() const;
+    QStringList candidates() const;
+    QStringList complete(const QString &prefix, int maximum) const;
+
+public Q_SLOTS:
+    void processKey(int key, Qt::KeyboardModifiers modifiers, const QString &text);
+    void reset();
+
+Q_SIGNALS:
+    void candidatesChanged(const QStringList &candidates);
+
+private:
+    void updateCandidates();
+    void updateKeyWeights();
+
+    QVirtualKeyPredictorPrivate *d;
+};
+
+#endif
@@ -0,0 +1,80 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#ifndef QVIRTUALKEYPREDICTOR_P_H
+#define QVIRTUALKEYPREDICTOR_P_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QPair>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+
+#include "qvirtualkeyboard.h"
+
+class QVirtualKeyDictionary
+{
+public:
+    QVirtualKeyDictionary();
+    ~QVirtualKeyDictionary();
+
+    bool load(const QString &fileName, QString *errorString = 0);
+    void clear();
+
+    bool isEmpty() const { return nodeCount == 0; }
+    int words() const { return wordCount; }
+    int size() const { return nodeCount ? int(headerSize + nodeCount * nodeSize) : 0; }
+
+    bool complete(const QString &prefix, int maximum, qint64 budget, QStringList *candidates) const;
+
+    static QByteArray build(const QList<QPair<QString, quint32> > &words);
+
+    enum { headerSize = 16, nodeSize = 8 };
+
+private:
+    // Node record: character (16 bit), frequency (8 bit), maximum frequency in the
+    // subtree (8 bit), then first child (31 bit) and a last sibling flag (1 bit)
+    QChar character(quint32 node) const;
+    int frequency(quint32 node) const;
+    int maximumFrequency(quint32 node) const;
+    quint32 firstChild(quint32 node) const;
+    bool isLastSibling(quint32 node) const;
+
+    QFile file; ///< Dictionary file, kept open while it is mapped
+    uchar *mapped; ///< Mapped dictionary file, if the file engine supports it
+    QByteArray data; ///< Dictionary read into memory if it cannot be mapped
+    const uchar *nodes; ///< Node records, node 0 is the root
+    quint32 nodeCount;
+    quint32 wordCount;
+};
+
+class QVirtualKeyPredictorPrivate
+{
+public:
+    QVirtualKeyPredictorPrivate()
+        : maximumCandidates(5)
+        , timeBudget(1000)
+        , keyWeighting(false)
+    {}
+
+    QPointer<QVirtualKeyboard> keyboard; ///< Keyboard whose key stream is watched
+    QVirtualKeyDictionary dictionary;
+    int maximumCandidates;
+    int timeBudget; ///< Microseconds a lookup may take
+    bool keyWeighting; ///< Set if the keyboard's key weights follow the candidates
+    QString word; ///< Word typed so far
+    QStringList candidates; ///< Completions of word, most frequent first
+};
+
+#endif
@@ -0,0 +1,520 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include "qvirtualkeyrecorder.h"
+#include "qvirtualkeyrecorder_p.h"
+#include "qvirtualkey.h"
+
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QKeyEvent>
+#include <QTextStream>
+#include <QTimer>
+#include <QDebug>
+
+#include "qvirtualkeyboard_p.h"
+
+/*
+    Log format (QDataStream, Qt 4.6 serialization, little endian):
+
+    Header      "QVKR", format version (32 bit)
+    Records     record type (8 bit) followed by its fields, timestamps are
+                milliseconds since the recording started (32 bit):
+
+    KeyName     key id (16 bit), object name of the virtual key; written before
+                the first press or release of the key
+    Press       timestamp, key id (16 bit), flags (8 bit, bit 0: checked)
+    Release     timestamp, key id (16 bit), flags (8 bit, bit 0: checked)
+    Layout      timestamp, file or preloaded layout name, layout name
+    State       timestamp, QVirtualKeyboard input state (QByteArray)
+
+    A press or release takes 8 bytes, the first one of a key additionally
+    its name.
+*/
+
+static const char recordMagic[4] = { 'Q', 'V', 'K', 'R' };
+static const quint32 recordFormatVersion = 1;
+
+static void setUpStream(QDataStream &stream)
+{
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream.setByteOrder(QDataStream::LittleEndian);
+}
+
+// Runs the event loop until 'time' milliseconds on 'clock' have passed
+static void waitUntil(const QTime &clock, quint32 time)
+{
+    const int remaining = int(time) - clock.elapsed();
+    if (remaining <= 0)
+        return;
+    QEventLoop loop;
+    QTimer::singleShot(remaining, &loop, SLOT(quit()));
+    loop.exec();
+}
+
+// One line of a golden file: type, key, modifiers and text, with the
+// characters which are not printable escaped
+static QString formatKeyEvent(const QKeyEvent &event)
+{
+    QString key = QVirtualKeyboard::keyToString(Qt::Key(event.key()));
+    if (key.isEmpty())
+        key = QString("0x%1").arg(uint(event.key()), 0, 16);
+
+    QString text;
+    foreach (const QChar &c, event.text()) {
+        if (c.isPrint() && c != QLatin1Char('"') && c != QLatin1Char('\\'))
+            text += c;
+        else
+            text += QString("\\x%1").arg(c.unicode(), 4, 16, QLatin1Char('0'));
+    }
+
+    QString line = QString("%1 %2 0x%3 \"%4\"")
+        .arg(QLatin1String(event.type() == QEvent::KeyPress ? "press" : "release"), key,
+             QString("%1").arg(uint(event.modifiers()), 8, 16, QLatin1Char('0')), text);
+    if (event.isAutoRepeat())
+        line += QLatin1String(" autorepeat");
+    if (event.count() > 1)
+        line += QString(" count=%1").arg(event.count());
+    return line;
+}
+
+/*!
+    \class QVirtualKeyRecorder
+    \brief Records the virtual key presses of a QVirtualKeyboard and replays them.
+
+    The recorder writes the raw stream of virtual key presses and releases,
+    before any modifier, dead key or auto-repeat processing, into a compact
+    binary log, together with the layout and the input state (modifiers,
+    pending dead keys and options) of the keyboard. Replaying the log feeds
+    the presses back into a keyboard with virtual keys of the same object
+    names, which does not need to be shown, and collects the generated key
+    events. These can be saved as a golden file and compared against it, so
+    an input problem reported by a user can be reproduced from their log and
+    kept as a regression test:
+
+    \code
+    QVirtualKeyRecorder recorder;
+    recorder.setKeyboard(keyboard);
+    recorder.replay("session.qvkr");
+    QString difference;
+    if (!recorder.compareReplayedEvents("session.golden", &difference))
+        qWarning() << difference;
+    \endcode
+
+    Replaying at maximum speed also measures the throughput of the keyboard.
+    It is deterministic: held keys do not auto-repeat, because the event loop
+    does not run. At real time the event loop runs between the presses as it
+    did while recording, so the timers of auto-repeat and batched delivery fire.
+
+    Only virtual keys with an object name are recorded.
+
+    \sa QVirtualKeyboard::findVirtualKey()
+*/
+
+/*!
+    \enum QVirtualKeyRecorder::ReplaySpeed
+    \brief Pace of replay().
+
+    \var QVirtualKeyRecorder::RealTimeReplay
+         Keeps the recorded time between the presses, running the event loop meanwhile.
+    \var QVirtualKeyRecorder::MaximumSpeedReplay
+         Feeds the presses without pause and without running the event loop.
+*/
+
+/*!
+    \brief Constructs a recorder without keyboard with the given \a parent.
+*/
+QVirtualKeyRecorder::QVirtualKeyRecorder(QObject *parent)
+    : QObject(parent)
+    , d(new QVirtualKeyRecorderPrivate)
+{
+}
+
+/*!
+    \brief Stops recording and destroys the recorder.
+*/
+QVirtualKeyRecorder::~QVirtualKeyRecorder()
+{
+    setKeyboard(0);
+    delete d;
+}
+
+/*!
+    \brief Records and replays the virtual key presses of \a keyboard, replacing the
+           previous keyboard and stopping a running recording.
+
+    A keyboard has at most one recorder, the previous recorder of \a keyboard is
+    detached from it. Pass 0 to detach this recorder.
+*/
+void QVirtualKeyRecorder::setKeyboard(QVirtualKeyboard *keyboard)
+{
+    stopRecording();
+    if (d->keyboard) {
+        disconnect(d->keyboard, 0, this, 0);
+        if (d->keyboard->d->recorder == this)
+            d->keyboard->d->recorder = 0;
+    }
+    d->keyboard = keyboard;
+    if (keyboard) {
+        if (keyboard->d->recorder)
+            keyboard->d->recorder->setKeyboard(0);
+        keyboard->d->recorder = this;
+        connect(keyboard, SIGNAL(modifiersChanged()), this, SLOT(recordState()));
+    }
+}
+
+/*!
+    \brief Returns the keyboard whose virtual key presses are recorded and replayed.
+*/
+QVirtualKeyboard *QVirtualKeyRecorder::keyboard() const
+{
+    return d->keyboard;
+}
+
+/*!
+    \brief Starts recording the virtual key presses of keyboard() into the log \a fileName.
+
+    The log starts with the current layout and input state of the keyboard, so
+    a replay starts from the same state. A running recording is stopped first.
+
+    \sa stopRecording(), replay()
+*/
+bool QVirtualKeyRecorder::startRecording(const QString &fileName)
+{
+    stopRecording();
+    if (!d->keyboard) {
+        qWarning("QVirtualKeyRecorder::startRecording(): No keyboard set");
+        return false;
+    }
+
+    d->file.setFileName(fileName);
+    if (!d->file.open(QFile::WriteOnly | QFile::Truncate)) {
+        qWarning() << "QVirtualKeyRecorder::startRecording(" << fileName << ")" << d->file.errorString();
+        return false;
+    }
+    d->stream.setDevice(&d->file);
+    setUpStream(d->stream);
+    d->stream.writeRawData(recordMagic, sizeof(recordMagic));
+    d->stream << recordFormatVersion;
+
+    d->keyIds.clear();
+    d->recordedKeys = 0;
+    d->clock.start();
+    recordLayout();
+    recordState();
+    return true;
+}
+
+/*!
+    \brief Stops recording and closes the log.
+*/
+void QVirtualKeyRecorder::stopRecording()
+{
+    if (!isRecording())
+        return;
+    d->stream.setDevice(0);
+    d->file.close();
+}
+
+/*!
+    \brief Returns true while virtual key presses are recorded.
+*/
+bool QVirtualKeyRecorder::isRecording() const
+{
+    return d->file.isOpen();
+}
+
+/*!
+    \brief Returns the number of virtual key presses and releases of the current or
+           last recording.
+*/
+int QVirtualKeyRecorder::recordedKeys() const
+{
+    return d->recordedKeys;
+}
+
+/*!
+    \brief Feeds the virtual key presses of the log \a fileName into keyboard() at
+           \a speed and collects the generated key events.
+
+    The layout and input state of the keyboard are restored as recorded, its
+    virtual keys are looked up by their object names. Checkable keys are set
+    to the checked state they had when they were pressed or released.
+
+    Returns false and sets \a errorString if the log cannot be read or refers to
+    a virtual key or layout which does not exist, the events up to the error are
+    replayed anyway.
+
+    \sa replayedEvents(), compareReplayedEvents()
+*/
+bool QVirtualKeyRecorder::replay(const QString &fileName, ReplaySpeed speed, QString *errorString)
+{
+    QString error;
+    QFile file(fileName);
+    if (!d->keyboard)
+        error = QLatin1String("No keyboard set");
+    else if (isRecording())
+        error = QLatin1String("Cannot replay while recording");
+    else if (!file.open(QFile::ReadOnly))
+        error = file.errorString();
+
+    QDataStream in(&file);
+    setUpStream(in);
+    if (error.isEmpty()) {
+        char magic[sizeof(recordMagic)];
+        quint32 version = 0;
+        if (in.readRawData(magic, sizeof(magic)) == int(sizeof(magic)) && qstrncmp(magic, recordMagic, sizeof(magic)) == 0)
+            in >> version;
+        if (version == 0)
+            error = QLatin1String("Not a virtual key log");
+        else if (version != recordFormatVersion)
+            error = QString("Unsupported log format version %1").arg(version);
+    }
+    if (!error.isEmpty()) {
+        if (errorString)
+            *errorString = error;
+        return false;
+    }
+
+    QVirtualKeyboard *keyboard = d->keyboard;
+    d->replayedEvents.clear();
+    d->replayedKeys = 0;
+    d->replaying = true;
+    connect(keyboard, SIGNAL(keyEvent(QKeyEvent *)), this, SLOT(captureKeyEvent(QKeyEvent *)));
+
+    QHash<quint16, QPointer<QVirtualKey> > keys;
+    QTime clock;
+    clock.start();
+    while (error.isEmpty() && !in.atEnd()) {
+        quint8 type = 0;
+        quint32 time = 0;
+        in >> type;
+        switch (type) {
+            case QVirtualKeyRecorderPrivate::KeyNameRecord: {
+                quint16 id = 0;
+                QString name;
+                in >> id >> name;
+                QVirtualKey *key = keyboard->findVirtualKey(name);
+                if (!key && in.status() == QDataStream::Ok)
+                    error = QString("Unknown virtual key '%1'").arg(name);
+                keys.insert(id, key);
+                break;
+            }
+            case QVirtualKeyRecorderPrivate::PressRecord:
+            case QVirtualKeyRecorderPrivate::ReleaseRecord: {
+                quint16 id = 0;
+                quint8 flags = 0;
+                in >> time >> id >> flags;
+                if (in.status() != QDataStream::Ok)
+                    break;
+                QVirtualKey *key = keys.value(id);
+                if (!key) {
+                    error = keys.contains(id) ? QString("Virtual key %1 was deleted").arg(id)
+                                              : QString("Undefined virtual key %1").arg(id);
+                    break;
+                }
+                if (speed == RealTimeReplay)
+                    waitUntil(clock, time);
+                const bool checked = flags & QVirtualKeyRecorderPrivate::CheckedFlag;
+                if (key->isCheckable() && key->isChecked() != checked)
+                    key->setChecked(checked);
+                if (type == QVirtualKeyRecorderPrivate::PressRecord)
+                    keyboard->virtualKeyPressed(key);
+                else
+                    keyboard->virtualKeyReleased(key);
+                ++d->replayedKeys;
+                break;
+            }
+            case QVirtualKeyRecorderPrivate::LayoutRecord: {
+                QString layoutFile, layoutName;
+                in >> time >> layoutFile >> layoutName;
+                if (in.status() != QDataStream::Ok)
+                    break;
+                if (speed == RealTimeReplay)
+                    waitUntil(clock, time);
+                if (layoutFile.isEmpty())
+                    keyboard->setLayoutName(layoutName);
+                else if (layoutFile != keyboard->d->layoutFile && !keyboard->setLayout(layoutFile))
+                    error = QString("Cannot load the layout '%1'").arg(layoutFile);
+                break;
+            }
+            case QVirtualKeyRecorderPrivate::StateRecord: {
+                QByteArray state;
+                in >> time >> state;
+                if (in.status() != QDataStream::Ok)
+                    break;
+                if (speed == RealTimeReplay)
+                    waitUntil(clock, time);
+                if (!keyboard->restoreInputState(state))
+                    error = QLatin1String("Invalid input state");
+                break;
+            }
+            default:
+                error = QString("Unknown record type %1").arg(type);
+                break;
+        }
+        if (error.isEmpty() && in.status() != QDataStream::Ok)
+            error = QLatin1String("Truncated log");
+    }
+
+    keyboard->flushKeyEvents();
+    disconnect(keyboard, SIGNAL(keyEvent(QKeyEvent *)), this, SLOT(captureKeyEvent(QKeyEvent *)));
+    d->replaying = false;
+
+    if (!error.isEmpty()) {
+        if (errorString)
+            *errorString = QString("%1 (at byte %2)").arg(error).arg(file.pos());
+        return false;
+    }
+    return true;
+}
+
+/*!
+    \brief Returns the number of virtual key presses and releases fed by the last replay().
+*/
+int QVirtualKeyRecorder::replayedKeys() const
+{
+    return d->replayedKeys;
+}
+
+/*!
+    \brief Returns the key events generated by the last replay(), one line per event.
+
+    Every line holds the event type, the key, the modifiers and the text, for
+    example \c {press Key_A 0x02000000 "A"}.
+*/
+QStringList QVirtualKeyRecorder::replayedEvents() const
+{
+    return d->replayedEvents;
+}
+
+/*!
+    \brief Writes replayedEvents() as golden file \a fileName.
+
+    \sa compareReplayedEvents()
+*/
+bool QVirtualKeyRecorder::saveReplayedEvents(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+        qWarning() << "QVirtualKeyRecorder::saveReplayedEvents(" << fileName << ")" << file.errorString();
+        return false;
+    }
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+    foreach (const QString &line, d->replayedEvents)
+        out << line << '\n';
+    out.flush();
+    return file.error() == QFile::NoError;
+}
+
+/*!
+    \brief Returns true if replayedEvents() match the golden file \a goldenFile.
+
+    Otherwise \a difference is set to the first differing event.
+
+    \sa saveReplayedEvents()
+*/
+bool QVirtualKeyRecorder::compareReplayedEvents(const QString &goldenFile, QString *difference) const
+{
+    QFile file(goldenFile);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        if (difference)
+            *difference = file.errorString();
+        return false;
+    }
+    QTextStream in(&file);
+    in.setCodec("UTF-8");
+
+    int line = 0;
+    for (; !in.atEnd(); ++line) {
+        const QString expected = in.readLine();
+        const QString replayed = line < d->replayedEvents.count() ? d->replayedEvents.at(line) : QString("<none>");
+        if (expected != replayed) {
+            if (difference)
+                *difference = QString("Event %1: expected %2, replayed %3").arg(line + 1).arg(expected, replayed);
+            return false;
+        }
+    }
+    if (line < d->replayedEvents.count()) {
+        if (difference)
+            *difference = QString("Event %1: expected <none>, replayed %2").arg(line + 1).arg(d->replayedEvents.at(line));
+        return false;
+    }
+    return true;
+}
+
+/*!
+    \internal
+    \brief Records the current input state of the keyboard, if it was changed by
+           something else than a virtual key, for example resetModifiers().
+
+    Besides modifiersChanged(), the keyboard calls it when the modifier keys or the
+    auto-shifting, dead key and caps lock options are set.
+*/
+void QVirtualKeyRecorder::recordState()
+{
+    if (!isRecording() || d->keyboard->d->keyDepth > 0)
+        return;
+    d->stream << quint8(QVirtualKeyRecorderPrivate::StateRecord) << d->timestamp() << d->keyboard->saveInputState();
+}
+
+/*!
+    \internal
+    \brief Records the current layout of the keyboard, called when it changes.
+*/
+void QVirtualKeyRecorder::recordLayout()
+{
+    if (!isRecording())
+        return;
+    QString layoutFile = d->keyboard->d->layoutFile;
+    if (!layoutFile.isEmpty() && QFileInfo(layoutFile).isFile())
+        layoutFile = QFileInfo(layoutFile).absoluteFilePath();
+    d->stream << quint8(QVirtualKeyRecorderPrivate::LayoutRecord) << d->timestamp()
+              << layoutFile << d->keyboard->layoutName();
+}
+
+/*!
+    \internal
+    \brief Records a press or release of the virtual \a key, before the keyboard handles it.
+*/
+void QVirtualKeyRecorder::recordKey(QVirtualKey *key, bool pressed)
+{
+    if (!isRecording() || d->replaying)
+        return;
+    const QString name = key->objectName();
+    if (name.isEmpty())
+        return;
+
+    QHash<QString, quint16>::const_iterator it = d->keyIds.constFind(name);
+    if (it == d->keyIds.constEnd()) {
+        if (d->keyIds.count() > 0xffff)
+            return;
+        it = d->keyIds.insert(name, quint16(d->keyIds.count()));
+        d->stream << quint8(QVirtualKeyRecorderPrivate::KeyNameRecord) << it.value() << name;
+    }
+
+    const quint8 type = pressed ? QVirtualKeyRecorderPrivate::PressRecord : QVirtualKeyRecorderPrivate::ReleaseRecord;
+    const quint8 flags = key->isChecked() ? QVirtualKeyRecorderPrivate::CheckedFlag : 0;
+    d->stream << type << d->timestamp() << it.value() << flags;
+    ++d->recordedKeys;
+}
+
+/*!
+    \internal
+    \brief Collects a key event generated by replay().
+*/
+void QVirtualKeyRecorder::captureKeyEvent(QKeyEvent *event)
+{
+    d->replayedEvents.append(formatKeyEvent(*event));
+}
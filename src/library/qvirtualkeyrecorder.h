@@ -0,0 +1,66 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#ifndef QVIRTUALKEYRECORDER_H
+#define QVIRTUALKEYRECORDER_H
+
+#include <QObject>
+#include <QStringList>
+
+#include "qvirtualkeyboardglobal.h"
+
+class QKeyEvent;
+class QVirtualKey;
+class QVirtualKeyboard;
+class QVirtualKeyRecorderPrivate;
+
+class Q_QVK_EXPORT QVirtualKeyRecorder : public QObject
+{
+    Q_OBJECT
+
+    Q_ENUMS(ReplaySpeed)
+
+public:
+    enum ReplaySpeed { RealTimeReplay, MaximumSpeedReplay };
+
+    explicit QVirtualKeyRecorder(QObject *parent = 0);
+    virtual ~QVirtualKeyRecorder();
+
+    void setKeyboard(QVirtualKeyboard *keyboard);
+    QVirtualKeyboard *keyboard() const;
+
+    bool startRecording(const QString &fileName);
+    void stopRecording();
+    bool isRecording() const;
+    int recordedKeys() const;
+
+    bool replay(const QString &fileName, ReplaySpeed speed = MaximumSpeedReplay, QString *errorString = 0);
+    int replayedKeys() const;
+    QStringList replayedEvents() const;
+    bool saveReplayedEvents(const QString &fileName) const;
+    bool compareReplayedEvents(const QString &goldenFile, QString *difference = 0) const;
+
+private Q_SLOTS:
+    void recordState();
+    void captureKeyEvent(QKeyEvent *event);
+
+private:
+    void recordKey(QVirtualKey *key, bool pressed);
+    void recordLayout();
+
+    QVirtualKeyRecorderPrivate *d;
+
+    friend class QVirtualKeyboard;
+};
+
+#endif
@@ -0,0 +1,51 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#ifndef QVIRTUALKEYRECORDER_P_H
+#define QVIRTUALKEYRECORDER_P_H
+
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QPointer>
+#include <QStringList>
+#include <QTime>
+
+#include "qvirtualkeyboard.h"
+
+class QVirtualKeyRecorderPrivate
+{
+public:
+    QVirtualKeyRecorderPrivate()
+        : recordedKeys(0)
+        , replaying(false)
+        , replayedKeys(0)
+    {}
+
+    enum RecordType { KeyNameRecord = 1, PressRecord, ReleaseRecord, LayoutRecord, StateRecord };
+    enum KeyFlag { CheckedFlag = 0x1 };
+
+    quint32 timestamp() const { return quint32(clock.elapsed()); }
+
+    QPointer<QVirtualKeyboard> keyboard; ///< Keyboard whose virtual key presses are recorded or replayed
+    QFile file; ///< Log being recorded, open while recording
+    QDataStream stream; ///< Writes the records to file
+    QTime clock; ///< Time base of the record timestamps
+    QHash<QString, quint16> keyIds; ///< Ids of the key names written to the log so far
+    int recordedKeys;
+    bool replaying; ///< Set while replay() feeds the keyboard
+    int replayedKeys;
+    QStringList replayedEvents; ///< Key events generated by the last replay, formatted
+};
+
+#endif
@@ -0,0 +1,211 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDirIterator>
+#include <QSet>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QXmlStreamReader>
+#ifndef QT_NO_CONCURRENT
+#  include <QtConcurrentMap>
+#endif
+
+#include "qvirtualkeyboardlayout_p.h"
+#include "qvirtualkeypredictor.h"
+
+struct Job
+{
+    QString input;
+    QString output; ///< Compiled layout to write, empty to only validate
+    QSet<QString> keyNames; ///< Virtual keys of the forms given with -u
+    bool dictionary; ///< Set if the input is a word list to compile into a dictionary
+};
+
+struct Result
+{
+    Result() : ok(true) {}
+
+    bool ok;
+    QStringList messages;
+};
+
+static void usage(QTextStream &err)
+{
+    err << "Usage: qvkmc [-c] [-u <form.ui>] [-j <jobs>] [-o <output>] <layout|directory> ..." << endl
+        << "       qvkmc -d [-j <jobs>] [-o <output>] <wordlist> ..." << endl
+        << endl
+        << "Validates virtual keyboard layout XML files and compiles them into the" << endl
+        << "binary layout format, which QVirtualKeyboard::setLayout() loads without" << endl
+        << "parsing XML. By default the output is written next to the input with the" << endl
+        << ".qvkc suffix. Directories are searched recursively for .qvkm files." << endl
+        << endl
+        << "  -c       Only validate the layouts, do not compile them." << endl
+        << "  -u <ui>  Report virtual keys which are not a QVirtualKey of the Qt designer" << endl
+        << "           form <ui>. May be given more than once." << endl
+        << "  -j <n>   Process <n> layouts in parallel, by default one per CPU core." << endl
+        << "  -o <out> Write the compiled layout to <out>, only for a single layout." << endl
+        << "  -d       Compile word lists into dictionaries for QVirtualKeyPredictor," << endl
+        << "           written next to the input with the .qvkd suffix by default." << endl
+        << endl
+        << "Errors are reported as <file>:<line>:<column>: <message>. The exit code is 1" << endl
+        << "if any layout has errors, layouts with errors are not compiled." << endl;
+}
+
+/*
+    Adds the object names of all QVirtualKey widgets of the form fileName to names.
+*/
+static bool readFormKeyNames(const QString &fileName, QSet<QString> *names, QTextStream &err)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        err << fileName << ": " << file.errorString() << endl;
+        return false;
+    }
+
+    QXmlStreamReader reader(&file);
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isStartElement() && reader.name() == "widget"
+                && reader.attributes().value("class") == "QVirtualKey")
+            names->insert(reader.attributes().value("name").toString());
+    }
+    if (reader.hasError()) {
+        err << fileName << ":" << reader.lineNumber() << ":" << reader.columnNumber() << ": " << reader.errorString() << endl;
+        return false;
+    }
+    return true;
+}
+
+/*
+    Validates and compiles one layout, or compiles one dictionary, runs in a worker thread.
+*/
+static Result process(const Job &job)
+{
+    Result result;
+    if (job.dictionary) {
+        QString errorString;
+        if (!QVirtualKeyPredictor::compileDictionary(job.input, job.output, &errorString)) {
+            result.messages.append(job.input + QLatin1String(": ") + errorString);
+            result.ok = false;
+        }
+        return result;
+    }
+
+    QVirtualKeyboardLayout layout;
+    QStringList errors;
+    if (!QVirtualKeyboardLayout::validate(job.input, &errors, job.keyNames, &layout)) {
+        foreach (const QString &error, errors)
+            result.messages.append(job.input + QLatin1Char(':') + error);
+        result.ok = false;
+        return result;
+    }
+    if (job.output.isEmpty())
+        return result;
+
+    // load() resolves the compose file relative to the compiled layout
+    const QDir inputDir = QFileInfo(job.input).absoluteDir();
+    const QDir outputDir = QFileInfo(job.output).absoluteDir();
+    if (!layout.composeFile.isEmpty() && QFileInfo(layout.composeFile).isRelative() && inputDir != outputDir)
+        layout.composeFile = outputDir.relativeFilePath(inputDir.absoluteFilePath(layout.composeFile));
+
+    QFile file(job.output);
+    const QByteArray data = layout.toCompiled();
+    if (!file.open(QFile::WriteOnly | QFile::Truncate) || file.write(data) != data.size()) {
+        result.messages.append(job.output + QLatin1String(": ") + file.errorString());
+        result.ok = false;
+    }
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream err(stderr);
+
+    QStringList inputs;
+    QString output;
+    bool checkOnly = false;
+    bool dictionary = false;
+    QSet<QString> keyNames;
+    QStringList args = app.arguments();
+    for (int i = 1; i < args.count(); ++i) {
+        if (args.at(i) == QLatin1String("-o") && i + 1 < args.count()) {
+            output = args.at(++i);
+        } else if (args.at(i) == QLatin1String("-c")) {
+            checkOnly = true;
+        } else if (args.at(i) == QLatin1String("-d")) {
+            dictionary = true;
+        } else if (args.at(i) == QLatin1String("-u") && i + 1 < args.count()) {
+            if (!readFormKeyNames(args.at(++i), &keyNames, err))
+                return 1;
+        } else if (args.at(i) == QLatin1String("-j") && i + 1 < args.count()) {
+            const int jobs = args.at(++i).toInt();
+            if (jobs > 0)
+                QThreadPool::globalInstance()->setMaxThreadCount(jobs);
+        } else if (args.at(i) == QLatin1String("-h") || args.at(i) == QLatin1String("--help")) {
+            usage(err);
+            return 0;
+        } else if (QFileInfo(args.at(i)).isDir()) {
+            QStringList found;
+            QDirIterator it(args.at(i), QStringList() << QLatin1String("*.qvkm"), QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext())
+                found.append(it.next());
+            found.sort();
+            inputs += found;
+        } else {
+            inputs.append(args.at(i));
+        }
+    }
+
+    if (inputs.isEmpty() || (!output.isEmpty() && (inputs.count() > 1 || checkOnly)) || (dictionary && checkOnly)) {
+        usage(err);
+        return 1;
+    }
+
+    QList<Job> jobs;
+    foreach (const QString &input, inputs) {
+        Job job;
+        job.input = input;
+        if (dictionary) {
+            const QFileInfo info(input);
+            job.output = output.isEmpty() ? info.dir().filePath(info.completeBaseName() + QLatin1String(".qvkd")) : output;
+        } else if (!checkOnly) {
+            job.output = output.isEmpty() ? QVirtualKeyboardLayout::compiledFileName(input) : output;
+        }
+        job.keyNames = keyNames;
+        job.dictionary = dictionary;
+        jobs.append(job);
+    }
+
+#ifndef QT_NO_CONCURRENT
+    const QList<Result> results = QtConcurrent::blockingMapped<QList<Result> >(jobs, process);
+#else
+    QList<Result> results;
+    foreach (const Job &job, jobs)
+        results.append(process(job));
+#endif
+
+    // Reported in input order, independent of which job finished first
+    bool success = true;
+    foreach (const Result &result, results) {
+        foreach (const QString &message, result.messages)
+            err << message << endl;
+        success &= result.ok;
+    }
+    return success ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+build_qtopia {
+    qtopia_project(stub)
+} else {
+    message(Build layout compiler for Qt or Qt/Embedded)
+    TEMPLATE     = app
+    TARGET       = qvkmc
+    CONFIG      += console release
+    CONFIG      -= app_bundle
+    DEFINES     += QT_NO_DEBUG_OUTPUT
+    greaterThan(QT_MAJOR_VERSION, 4): QT += concurrent
+
+    INCLUDEPATH += ../library
+    LIBS        += -L../library -lqtvirtualkeyboard
+
+    SOURCES     += main.cpp
+
+    target.path  = $$[QT_INSTALL_BINS]
+    INSTALLS    += target
+}
@@ -6,8 +6,13 @@ build_qtopia {
     TEMPLATE = subdirs
 }
 
+CONFIG  += ordered
+
 # Mandatory: The Qt virtual keyboard library
 SUBDIRS  = library
 
+# Recommended: The layout compiler
+SUBDIRS += qvkmc
+
 # Recommended: The Qt designer plugin
 SUBDIRS += plugin
@@ -0,0 +1,402 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QMouseEvent>
+#include <QPixmap>
+#include <QSignalSpy>
+#include <QThreadPool>
+
+#include "qvirtualkeyboard.h"
+#include "qvirtualkey.h"
+#include "qvirtualkeypredictor.h"
+
+class TestKeyboard : public QObject
+{
+    Q_OBJECT
+
+public slots:
+    void countBatch() { ++batches; }
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void sharedIcons();
+    void iconsDecodedOnFirstPaint();
+    void iconCreatedWhenQueried();
+    void asyncLayoutReplacesPending();
+    void setLayoutDuringAsync();
+    void layoutChangedKeys();
+    void findVirtualKey();
+    void autoRepeatProperty();
+    void predictorInput();
+
+private:
+    void waitForLayouts();
+    static void clickKey(QVirtualKey *vk);
+    QString writeLayout(const QString &name, const QString &keys);
+    QString writeIcon(const QString &name);
+
+    QDir dir;
+    QVirtualKeyboard *keyboard;
+    QWidget *container;
+    QVirtualKey *keyA;
+    QVirtualKey *keyB;
+    QVirtualKey *keyC;
+    QVirtualKey *keyD;
+    int batches;
+};
+
+void TestKeyboard::initTestCase()
+{
+    const QString path = QString("tst_keyboard_%1").arg(QCoreApplication::applicationPid());
+    QVERIFY(QDir::temp().mkpath(path));
+    dir = QDir(QDir::temp().filePath(path));
+}
+
+void TestKeyboard::cleanupTestCase()
+{
+    foreach (const QString &fileName, dir.entryList(QDir::Files))
+        dir.remove(fileName);
+    QDir::temp().rmdir(dir.dirName());
+}
+
+// Every test gets a new keyboard with four keys of the same size
+void TestKeyboard::init()
+{
+    keyboard = new QVirtualKeyboard;
+    container = new QWidget;
+    keyA = new QVirtualKey(container);
+    keyB = new QVirtualKey(container);
+    keyC = new QVirtualKey(container);
+    keyD = new QVirtualKey(container);
+    keyA->setObjectName("key_a");
+    keyB->setObjectName("key_b");
+    keyC->setObjectName("key_c");
+    keyD->setObjectName("key_d");
+    foreach (QVirtualKey *vk, container->findChildren<QVirtualKey *>())
+        vk->resize(40, 40);
+    QVERIFY(keyboard->addKeyContainer(container));
+}
+
+void TestKeyboard::cleanup()
+{
+    delete keyboard;
+    delete container;
+}
+
+// Writes a layout called \a name with the <vkey> elements \a keys and returns its path
+QString TestKeyboard::writeLayout(const QString &name, const QString &keys)
+{
+    const QString fileName = dir.filePath(name + ".qvkm");
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+        return QString();
+    file.write(QString("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                       "<virtualkeyboardlayout version=\"1\" name=\"%1\">\n%2</virtualkeyboardlayout>\n")
+               .arg(name, keys).toUtf8());
+    return fileName;
+}
+
+// Writes a 16x16 image called \a name and returns its path
+QString TestKeyboard::writeIcon(const QString &name)
+{
+    QImage image(16, 16, QImage::Format_ARGB32);
+    image.fill(0xff336699);
+    const QString fileName = dir.filePath(name);
+    return image.save(fileName, "PNG") ? fileName : QString();
+}
+
+// Waits until all layout reads finished and their results were delivered
+void TestKeyboard::waitForLayouts()
+{
+    QThreadPool::globalInstance()->waitForDone();
+    for (int i = 0; i < 50 && keyboard->isLayoutLoading(); ++i)
+        QTest::qWait(20);
+    QTest::qWait(20);
+}
+
+// Presses and releases \a vk with the mouse
+void TestKeyboard::clickKey(QVirtualKey *vk)
+{
+    QMouseEvent press(QEvent::MouseButtonPress, QPoint(5, 5), Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    QMouseEvent release(QEvent::MouseButtonRelease, QPoint(5, 5), Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(vk, &press);
+    QCoreApplication::sendEvent(vk, &release);
+}
+
+// Keys and layouts using the same image file share one icon
+void TestKeyboard::sharedIcons()
+{
+    const QString shift = writeIcon("shift.png");
+    const QString enter = writeIcon("enter.png");
+    const QString layout = writeLayout("Icons", QString(
+        "<vkey name=\"key_a\"><default key=\"Qt::Key_A\" /><shift key=\"Qt::Key_A\" icon=\"%1\" /></vkey>\n"
+        "<vkey name=\"key_b\"><default key=\"Qt::Key_B\" /><shift key=\"Qt::Key_B\" icon=\"%1\" /></vkey>\n"
+        "<vkey name=\"key_c\"><default key=\"Qt::Key_Return\" icon=\"%2\" /></vkey>\n"
+        "<vkey name=\"key_d\"><default key=\"Qt::Key_Enter\" icon=\"%2\" /></vkey>\n").arg(shift, enter));
+    QVERIFY(keyboard->setLayout(layout));
+
+    QVERIFY(!keyA->shiftIcon().isNull());
+    QCOMPARE(keyB->shiftIcon().cacheKey(), keyA->shiftIcon().cacheKey());
+    QVERIFY(!keyC->icon().isNull());
+    QCOMPARE(keyD->icon().cacheKey(), keyC->icon().cacheKey());
+    QVERIFY(keyC->icon().cacheKey() != keyA->shiftIcon().cacheKey());
+
+    // Another layout and layer with the same image gets the same icon
+    const QString other = writeLayout("OtherIcons", QString(
+        "<vkey name=\"key_c\"><default key=\"Qt::Key_C\" /><alt key=\"Qt::Key_C\" icon=\"%1\" /></vkey>\n").arg(shift));
+    QVERIFY(keyboard->setLayout(other));
+    QCOMPARE(keyC->altIcon().cacheKey(), keyA->shiftIcon().cacheKey());
+}
+
+// Applying a layout does not decode images, painting decodes each image once
+void TestKeyboard::iconsDecodedOnFirstPaint()
+{
+    const QString shift = writeIcon("paint.png");
+    const QString layout = writeLayout("Paint", QString(
+        "<vkey name=\"key_a\"><default key=\"Qt::Key_A\" /><shift key=\"Qt::Key_A\" icon=\"%1\" /></vkey>\n"
+        "<vkey name=\"key_b\"><default key=\"Qt::Key_A\" /><shift key=\"Qt::Key_A\" icon=\"%1\" /></vkey>\n").arg(shift));
+    QVERIFY(keyboard->setLayout(layout));
+    QCOMPARE(keyboard->glyphCacheMisses(), 0);
+    QCOMPARE(keyboard->glyphCacheSize(), 0);
+
+    QPixmap pixmap(keyA->size());
+    keyA->render(&pixmap);
+    const int misses = keyboard->glyphCacheMisses();
+    const int hits = keyboard->glyphCacheHits();
+    QVERIFY(misses > 0);
+
+    // The second key looks the same and is painted from the cache only
+    keyB->render(&pixmap);
+    QCOMPARE(keyboard->glyphCacheMisses(), misses);
+    QVERIFY(keyboard->glyphCacheHits() > hits);
+}
+
+// Icons of the shift, alt and alt+shift layers are created on first use, so
+// the image only has to exist by then
+void TestKeyboard::iconCreatedWhenQueried()
+{
+    const QString late = dir.filePath("late.png");
+    const QString layout = writeLayout("Late", QString(
+        "<vkey name=\"key_a\"><default key=\"Qt::Key_A\" /><altshift key=\"Qt::Key_A\" icon=\"%1\" /></vkey>\n").arg(late));
+    QVERIFY(keyboard->setLayout(layout));
+
+    QCOMPARE(writeIcon("late.png"), late);
+    QVERIFY(!keyA->altShiftIcon().pixmap(16, 16).isNull());
+}
+
+// Only the most recent request is applied and reported
+void TestKeyboard::asyncLayoutReplacesPending()
+{
+    const QString first = writeLayout("First", "<vkey name=\"key_a\"><default key=\"Qt::Key_1\" /></vkey>\n");
+    const QString second = writeLayout("Second", "<vkey name=\"key_a\"><default key=\"Qt::Key_2\" /></vkey>\n");
+    QSignalSpy spy(keyboard, SIGNAL(layoutLoaded(QString, bool)));
+
+    QVERIFY(keyboard->setLayoutAsync(first));
+    QVERIFY(keyboard->setLayoutAsync(second));
+#ifndef QT_NO_CONCURRENT
+    QVERIFY(keyboard->isLayoutLoading());
+#endif
+    waitForLayouts();
+
+    QVERIFY(!keyboard->isLayoutLoading());
+#ifndef QT_NO_CONCURRENT
+    QCOMPARE(spy.count(), 1);
+#endif
+    QCOMPARE(spy.last().at(0).toString(), second);
+    QCOMPARE(spy.last().at(1).toBool(), true);
+    QCOMPARE(keyboard->layoutName(), QString("Second"));
+    QCOMPARE(keyA->key(), Qt::Key_2);
+}
+
+// A synchronous layout change drops a pending asynchronous one
+void TestKeyboard::setLayoutDuringAsync()
+{
+    const QString first = writeLayout("First", "<vkey name=\"key_a\"><default key=\"Qt::Key_1\" /></vkey>\n");
+    const QString second = writeLayout("Second", "<vkey name=\"key_a\"><default key=\"Qt::Key_2\" /></vkey>\n");
+    QSignalSpy spy(keyboard, SIGNAL(layoutLoaded(QString, bool)));
+
+    QVERIFY(keyboard->setLayoutAsync(first));
+    QVERIFY(keyboard->setLayout(second));
+    QVERIFY(!keyboard->isLayoutLoading());
+    waitForLayouts();
+
+#ifndef QT_NO_CONCURRENT
+    QCOMPARE(spy.count(), 0);
+#endif
+    QCOMPARE(keyboard->layoutName(), QString("Second"));
+    QCOMPARE(keyA->key(), Qt::Key_2);
+}
+
+// Only keys whose key code, text or icon differ count as changed
+void TestKeyboard::layoutChangedKeys()
+{
+    const QString icon = writeIcon("changed.png");
+    const QString full = writeLayout("Full",
+        "<vkey name=\"key_a\"><default key=\"Qt::Key_A\" /></vkey>\n"
+        "<vkey name=\"key_b\"><default key=\"Qt::Key_B\" /></vkey>\n"
+        "<vkey name=\"key_c\"><default key=\"Qt::Key_C\" /></vkey>\n"
+        "<vkey name=\"key_d\"><default key=\"Qt::Key_D\" /></vkey>\n");
+    const QString partial = writeLayout("Partial", QString(
+        "<vkey name=\"key_a\"><default key=\"Qt::Key_A\" /></vkey>\n"
+        "<vkey name=\"key_b\"><default key=\"Qt::Key_B\" /></vkey>\n"
+        "<vkey name=\"key_c\"><default key=\"Qt::Key_X\" /></vkey>\n"
+        "<vkey name=\"key_d\"><default key=\"Qt::Key_D\" /><shift key=\"Qt::Key_D\" icon=\"%1\" /></vkey>\n"
+        "<vkey name=\"key_missing\"><default key=\"Qt::Key_M\" /></vkey>\n").arg(icon));
+
+    QVERIFY(keyboard->setLayout(full));
+    QCOMPARE(keyboard->layoutChangedKeys(), 4);
+    QVERIFY(keyboard->setLayout(full));
+    QCOMPARE(keyboard->layoutChangedKeys(), 0);
+
+    // A different key code and an added icon, the unknown key is skipped
+    QVERIFY(keyboard->setLayout(partial));
+    QCOMPARE(keyboard->layoutChangedKeys(), 2);
+    QVERIFY(keyboard->setLayout(partial));
+    QCOMPARE(keyboard->layoutChangedKeys(), 0);
+
+    // Keys changed by hand are compared with their current values
+    keyA->setText("z");
+    keyD->setShiftIcon(QIcon());
+    QVERIFY(keyboard->setLayout(partial));
+    QCOMPARE(keyboard->layoutChangedKeys(), 2);
+    QCOMPARE(keyA->text(), QString("A"));
+    QVERIFY(!keyD->shiftIcon().isNull());
+
+    // Preloaded layouts are applied the same way
+    QVERIFY(keyboard->preloadLayout(full));
+    QVERIFY(keyboard->setLayout(full));
+    QCOMPARE(keyboard->layoutChangedKeys(), 1);
+    QVERIFY(keyboard->setLayout(full));
+    QCOMPARE(keyboard->layoutChangedKeys(), 0);
+}
+
+// The name index follows keys which are added, named, removed and deleted
+void TestKeyboard::findVirtualKey()
+{
+    QCOMPARE(keyboard->findVirtualKey("key_a"), keyA);
+
+    // Keys are usually named after they were added to their container
+    QVirtualKey *late = new QVirtualKey(container);
+    late->setObjectName("key_late");
+    QCOMPARE(keyboard->findVirtualKey("key_late"), late);
+    delete late;
+    QVERIFY(!keyboard->findVirtualKey("key_late"));
+
+    // The first registered key wins if names are ambiguous
+    QWidget other;
+    QVirtualKey *duplicate = new QVirtualKey(&other);
+    duplicate->setObjectName("key_a");
+    QVERIFY(keyboard->addKeyContainer(&other));
+    QCOMPARE(keyboard->findVirtualKey("key_a"), keyA);
+    keyboard->removeKeyContainer(container);
+    QCOMPARE(keyboard->findVirtualKey("key_a"), duplicate);
+    QVERIFY(!keyboard->findVirtualKey("key_b"));
+    keyboard->removeKeyContainer(&other);
+    QVERIFY(keyboard->addKeyContainer(container));
+    QCOMPARE(keyboard->findVirtualKey("key_a"), keyA);
+
+#if QT_VERSION >= 0x050000
+    keyB->setObjectName("key_renamed");
+    QCOMPARE(keyboard->findVirtualKey("key_renamed"), keyB);
+    QVERIFY(!keyboard->findVirtualKey("key_b"));
+#endif
+}
+
+// QAbstractButton::autoRepeat of registered keys keeps its value and decides
+// whether the keyboard repeats the key, QAbstractButton itself never repeats it
+void TestKeyboard::autoRepeatProperty()
+{
+    qRegisterMetaType<Qt::KeyboardModifiers>("Qt::KeyboardModifiers");
+    keyA->setKey(Qt::Key_A);
+    keyboard->setAutoRepeatDelay(10);
+    keyboard->setAutoRepeatInterval(10);
+    QSignalSpy keyPresses(keyboard, SIGNAL(keyPressed(int, Qt::KeyboardModifiers, QString)));
+    QSignalSpy buttonPresses(keyA, SIGNAL(pressed()));
+
+    QMouseEvent press(QEvent::MouseButtonPress, QPoint(5, 5), Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    QMouseEvent release(QEvent::MouseButtonRelease, QPoint(5, 5), Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+
+    keyA->setAutoRepeat(true);
+    QVERIFY(keyA->autoRepeat());
+    QCoreApplication::sendEvent(keyA, &press);
+    QTest::qWait(200);
+    QCoreApplication::sendEvent(keyA, &release);
+    QVERIFY(keyPresses.count() > 1);
+    QCOMPARE(buttonPresses.count(), 1);
+
+    // Changing the property of a registered key applies from the next press
+    keyA->setAutoRepeat(false);
+    keyPresses.clear();
+    QCoreApplication::sendEvent(keyA, &press);
+    QTest::qWait(100);
+    QCoreApplication::sendEvent(keyA, &release);
+    QCOMPARE(keyPresses.count(), 1);
+
+    keyboard->removeKeyContainer(container);
+    QVERIFY(!keyA->autoRepeat());
+}
+
+// The predictor keeps the word while a dead key is pending, and gets the key
+// presses also when they are delivered with keyEventBatch()
+void TestKeyboard::predictorInput()
+{
+    const QString expected = QString("a") + QChar(0xe9);
+    keyboard->setDeadKeys(true);
+    keyA->setKey(Qt::Key_A);
+    keyB->setKey(Qt::Key_Dead_Acute);
+    keyC->setKey(Qt::Key_E);
+    keyD->setKey(Qt::Key_Space);
+
+    QVirtualKeyPredictor predictor;
+    predictor.setKeyboard(keyboard);
+    clickKey(keyA);
+    clickKey(keyB);
+    QCOMPARE(predictor.currentWord(), QString("a"));
+    clickKey(keyC);
+    QCOMPARE(predictor.currentWord().toLower(), expected);
+    clickKey(keyD);
+    QVERIFY(predictor.currentWord().isEmpty());
+
+    keyboard->setBatchInterval(1000);
+    batches = 0;
+    connect(keyboard, SIGNAL(keyEventBatch(QList<QKeyEvent>)), this, SLOT(countBatch()));
+    clickKey(keyA);
+    clickKey(keyB);
+    clickKey(keyC);
+    keyboard->flushKeyEvents();
+    QCOMPARE(batches, 1);
+    QCOMPARE(predictor.currentWord().toLower(), expected);
+}
+
+int main(int argc, char *argv[])
+{
+#if QT_VERSION >= 0x050000
+    // Run without a display unless a platform is requested explicitly
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+#endif
+    QApplication app(argc, argv);
+    TestKeyboard test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_keyboard.moc"
@@ -0,0 +1,228 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QDir>
+#include <QFile>
+
+#include "qvirtualkeyboardlayout_p.h"
+
+class TestLayout : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void validLayout();
+    void strictErrors();
+    void unknownKeyNames();
+    void malformedXml();
+    void missingFile();
+    void composeFile();
+
+private:
+    QString writeLayout(const QString &name, const QStringList &lines);
+    static QString position(const QStringList &lines, int line);
+
+    QDir dir;
+};
+
+void TestLayout::initTestCase()
+{
+    const QString path = QString("tst_layout_%1").arg(QCoreApplication::applicationPid());
+    QVERIFY(QDir::temp().mkpath(path));
+    dir = QDir(QDir::temp().filePath(path));
+}
+
+void TestLayout::cleanupTestCase()
+{
+    foreach (const QString &fileName, dir.entryList(QDir::Files))
+        dir.remove(fileName);
+    QDir::temp().rmdir(dir.dirName());
+}
+
+// Writes \a lines as layout file \a name and returns its path
+QString TestLayout::writeLayout(const QString &name, const QStringList &lines)
+{
+    const QString fileName = dir.filePath(name + ".qvkm");
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+        return QString();
+    file.write(lines.join("\n").toUtf8() + '\n');
+    return fileName;
+}
+
+// The "line:column: " prefix of an error reported after the element which
+// makes up line \a line (starting with 1) of \a lines
+QString TestLayout::position(const QStringList &lines, int line)
+{
+    return QString("%1:%2: ").arg(line).arg(lines.at(line - 1).length());
+}
+
+void TestLayout::validLayout()
+{
+    const QStringList lines = QStringList()
+        << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        << "<virtualkeyboardlayout version=\"2\" name=\"Valid\">"
+        << "<vkey name=\"key_a\">"
+        << "<default key=\"Qt::Key_A\" text=\"a\" />"
+        << "<shift key=\"Qt::Key_A\" icon=\"a.png\" />"
+        << "</vkey>"
+        << "</virtualkeyboardlayout>";
+
+    const QString fileName = writeLayout("valid", lines);
+    QStringList errors;
+    QVERIFY(QVirtualKeyboardLayout::validate(fileName, &errors));
+    QCOMPARE(errors, QStringList());
+
+    QVirtualKeyboardLayout layout;
+    QVERIFY(layout.load(fileName));
+    QCOMPARE(layout.name, QString("Valid"));
+    QCOMPARE(layout.version, 2);
+    QCOMPARE(layout.entries.count(), 1);
+    QCOMPARE(layout.entries.at(0).bindings[QVirtualKeyboardLayout::ShiftLayer].icon, QString("a.png"));
+}
+
+// Every problem is reported with the position of the element it was found in
+void TestLayout::strictErrors()
+{
+    const QStringList lines = QStringList()
+        << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        << "<virtualkeyboardlayout version=\"one\" name=\"Strict\">"
+        << "<vkey name=\"key_a\" colour=\"red\">"
+        << "<default key=\"Qt::Key_A\" />"
+        << "</vkey>"
+        << "<vkey name=\"key_b\">"
+        << "<default key=\"Qt::Key_Nope\" />"
+        << "<shift />"
+        << "<shift key=\"Qt::Key_B\" />"
+        << "</vkey>"
+        << "<vkey name=\"key_a\">"
+        << "<default key=\"Qt::Key_A\" />"
+        << "</vkey>"
+        << "<vkey name=\"key_c\">"
+        << "<shift key=\"Qt::Key_C\" />"
+        << "</vkey>"
+        << "<bogus><nested /></bogus>"
+        << "</virtualkeyboardlayout>";
+
+    QStringList errors;
+    QVERIFY(!QVirtualKeyboardLayout::validate(writeLayout("strict", lines), &errors));
+
+    const QStringList expected = QStringList()
+        << position(lines, 2) + "The layout version 'one' is not a number."
+        << position(lines, 3) + "Unknown attribute 'colour' of <vkey>."
+        << position(lines, 7) + "Unknown key 'Qt::Key_Nope'."
+        << position(lines, 8) + "The <shift> element has no key."
+        << position(lines, 9) + "The <shift> element is defined twice."
+        << position(lines, 11) + "The virtual key 'key_a' is already defined in line 3."
+        << position(lines, 14) + "The virtual key 'key_c' has no <default> element."
+        << QString("17:7: Unknown element <bogus>.");
+    QCOMPARE(errors, expected);
+}
+
+// Keys which the keyboard does not have are reported if their names are known
+void TestLayout::unknownKeyNames()
+{
+    const QStringList lines = QStringList()
+        << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        << "<virtualkeyboardlayout version=\"1\" name=\"Names\">"
+        << "<vkey name=\"key_a\"><default key=\"Qt::Key_A\" /></vkey>"
+        << "<vkey name=\"key_x\">"
+        << "<default key=\"Qt::Key_X\" />"
+        << "</vkey>"
+        << "</virtualkeyboardlayout>";
+    const QString fileName = writeLayout("names", lines);
+
+    QStringList errors;
+    QVERIFY(QVirtualKeyboardLayout::validate(fileName, &errors));
+    QVERIFY(errors.isEmpty());
+
+    QVERIFY(!QVirtualKeyboardLayout::validate(fileName, &errors, QSet<QString>() << "key_a" << "key_b"));
+    QCOMPARE(errors, QStringList() << position(lines, 4) + "There is no virtual key named 'key_x'.");
+
+    // Compiled layouts carry no positions
+    QVirtualKeyboardLayout layout;
+    QVERIFY(layout.load(fileName));
+    const QString compiledName = QVirtualKeyboardLayout::compiledFileName(fileName);
+    QFile compiled(compiledName);
+    QVERIFY(compiled.open(QFile::WriteOnly | QFile::Truncate));
+    compiled.write(layout.toCompiled());
+    compiled.close();
+
+    errors.clear();
+    QVERIFY(QVirtualKeyboardLayout::validate(compiledName, &errors, QSet<QString>() << "key_a" << "key_x"));
+    QVERIFY(errors.isEmpty());
+    QVERIFY(!QVirtualKeyboardLayout::validate(compiledName, &errors, QSet<QString>() << "key_a" << "key_b"));
+    QCOMPARE(errors, QStringList() << "0:0: There is no virtual key named 'key_x'.");
+}
+
+// Malformed files report the error of the XML reader with its position
+void TestLayout::malformedXml()
+{
+    const QStringList lines = QStringList()
+        << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        << "<virtualkeyboardlayout version=\"1\" name=\"Malformed\">"
+        << "<vkey name=\"key_a\"><default key=\"Qt::Key_A\"></vkey>"
+        << "</virtualkeyboardlayout>";
+
+    QStringList errors;
+    QVERIFY(!QVirtualKeyboardLayout::validate(writeLayout("malformed", lines), &errors));
+    QCOMPARE(errors.count(), 1);
+    QVERIFY2(QRegExp("3:\\d+: .+").exactMatch(errors.at(0)), qPrintable(errors.at(0)));
+}
+
+void TestLayout::missingFile()
+{
+    QStringList errors;
+    QVERIFY(!QVirtualKeyboardLayout::validate(dir.filePath("missing.qvkm"), &errors));
+    QCOMPARE(errors.count(), 1);
+    QVERIFY(errors.at(0).startsWith("0:0: "));
+}
+
+// validate() keeps the compose file as written, only load() resolves it, also
+// for a layout compiled from the validated one
+void TestLayout::composeFile()
+{
+    const QStringList lines = QStringList()
+        << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        << "<virtualkeyboardlayout version=\"1\" name=\"Compose\" compose=\"dead.compose\">"
+        << "<vkey name=\"key_a\"><default key=\"Qt::Key_A\" /></vkey>"
+        << "</virtualkeyboardlayout>";
+    const QString fileName = writeLayout("compose", lines);
+    const QString resolved = dir.filePath("dead.compose");
+
+    QVirtualKeyboardLayout validated;
+    QVERIFY(QVirtualKeyboardLayout::validate(fileName, 0, QSet<QString>(), &validated));
+    QCOMPARE(validated.composeFile, QString("dead.compose"));
+
+    QVirtualKeyboardLayout loaded;
+    QVERIFY(loaded.load(fileName));
+    QCOMPARE(loaded.composeFile, resolved);
+
+    const QString compiledName = QVirtualKeyboardLayout::compiledFileName(fileName);
+    QFile compiled(compiledName);
+    QVERIFY(compiled.open(QFile::WriteOnly | QFile::Truncate));
+    compiled.write(validated.toCompiled());
+    compiled.close();
+
+    QVirtualKeyboardLayout loadedCompiled;
+    QVERIFY(loadedCompiled.load(compiledName));
+    QCOMPARE(loadedCompiled.composeFile, resolved);
+}
+
+QTEST_APPLESS_MAIN(TestLayout)
+
+#include "tst_layout.moc"
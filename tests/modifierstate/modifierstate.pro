@@ -0,0 +1,20 @@
+build_qtopia {
+    qtopia_project(stub)
+} else {
+    message(Build modifier state test for Qt or Qt/Embedded)
+    TEMPLATE     = app
+    TARGET       = tst_modifierstate
+    CONFIG      += console release
+    CONFIG      -= app_bundle
+    QT          += testlib
+
+    # The test uses the private modifier state machine
+    INCLUDEPATH += ../../src/library
+    LIBS        += -L../../src/library -lqtvirtualkeyboard
+
+    SOURCES     += tst_modifierstate.cpp
+
+    # "make check" runs the test
+    check.commands = ./$$TARGET
+    QMAKE_EXTRA_TARGETS += check
+}
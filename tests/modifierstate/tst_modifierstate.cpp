@@ -0,0 +1,491 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QDataStream>
+
+#include "qvirtualkeymodifierstate_p.h"
+
+Q_DECLARE_METATYPE(QVirtualKeyboard::ModifierMode)
+
+enum { Shift = QVirtualKeyModifierState::ShiftIndex, Alt = QVirtualKeyModifierState::AltIndex };
+
+/*
+    Expected behavior of a single modifier key, written down as a state table
+    independent of how QVirtualKeyModifierState stores its flags. Every row is a
+    state the key can be in, the columns give whether the modifier is active and
+    locked in that state, and the state after a press of the (released) key, a
+    release of the (pressed) key and a press of another key. -1 marks events
+    which cannot happen in that state.
+*/
+struct ModifierRow
+{
+    bool active;
+    bool locked;
+    int press;
+    int release;
+    int otherKey;
+};
+
+// Momentary: active while held
+static const ModifierRow momentaryTable[] = {
+    /* 0 up   */ { false, false, 1, -1, 0 },
+    /* 1 down */ { true, false, -1, 0, 1 }
+};
+
+// Latching: a tap latches for one key, a second tap locks, a third tap unlocks,
+// a key typed while the modifier is held makes the release not latch
+static const ModifierRow latchingTable[] = {
+    /* 0 off              */ { false, false, 1, -1, 0 },
+    /* 1 down             */ { true, false, -1, 3, 2 },
+    /* 2 down, typed      */ { true, false, -1, 0, 2 },
+    /* 3 latched          */ { true, true, 4, -1, 0 },
+    /* 4 latched, down    */ { true, true, -1, 5, 2 },
+    /* 5 locked           */ { true, true, 6, -1, 5 },
+    /* 6 locked, down     */ { true, true, -1, 0, 7 },
+    /* 7 locked, typed    */ { true, true, -1, 5, 7 }
+};
+
+// Locking: every press toggles the lock, releases change nothing
+static const ModifierRow lockingTable[] = {
+    /* 0 off            */ { false, false, 1, -1, 0 },
+    /* 1 on, down       */ { true, true, -1, 2, 1 },
+    /* 2 on             */ { true, true, 3, -1, 2 },
+    /* 3 off, down      */ { false, false, -1, 0, 3 }
+};
+
+class TestModifierState : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initialState();
+    void momentary();
+    void momentaryTwoKeys();
+    void unmatchedRelease();
+    void latching();
+    void latchingDoubleTapLocks();
+    void latchingChordedRelease();
+    void locking();
+    void hold();
+    void keyPressedClearsLatches();
+    void activeMaskLayerBits();
+    void overflow();
+    void removeModifier();
+    void setModeDropsLatch();
+    void saveAndLoad();
+    void loadInvalid();
+    void exhaustiveSequences_data();
+    void exhaustiveSequences();
+};
+
+void TestModifierState::initialState()
+{
+    QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+    QCOMPARE(state.count(), 2);
+    QCOMPARE(state.key(Shift), Qt::Key_Shift);
+    QCOMPARE(state.key(Alt), Qt::Key_AltGr);
+    QCOMPARE(state.mode(Shift), QVirtualKeyboard::MomentaryModifier);
+    QCOMPARE(state.indexOf(Qt::Key_AltGr), int(Alt));
+    QCOMPARE(state.indexOf(Qt::Key_Control), -1);
+    QCOMPARE(state.activeMask(), 0u);
+}
+
+void TestModifierState::momentary()
+{
+    QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+    state.press(Shift);
+    QVERIFY(state.isActive(Shift));
+    QVERIFY(!state.isLocked(Shift));
+    state.keyPressed();
+    QVERIFY(state.isActive(Shift));
+    state.release(Shift);
+    QVERIFY(!state.isActive(Shift));
+}
+
+// Two keys of the same modifier, released in any order
+void TestModifierState::momentaryTwoKeys()
+{
+    QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+    state.press(Shift);
+    state.press(Shift);
+    state.release(Shift);
+    QVERIFY(state.isActive(Shift));
+    state.release(Shift);
+    QVERIFY(!state.isActive(Shift));
+}
+
+// Releases without press must not make the press count negative
+void TestModifierState::unmatchedRelease()
+{
+    QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+    state.release(Shift);
+    state.release(Shift);
+    QVERIFY(!state.isActive(Shift));
+    state.press(Shift);
+    QVERIFY(state.isActive(Shift));
+    state.release(Shift);
+    QVERIFY(!state.isActive(Shift));
+}
+
+void TestModifierState::latching()
+{
+    QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+    state.setMode(Shift, QVirtualKeyboard::LatchingModifier);
+
+    state.press(Shift);
+    QVERIFY(state.isActive(Shift));
+    state.release(Shift);
+    QVERIFY(state.isActive(Shift));
+    QVERIFY(state.isLocked(Shift));
+
+    // The latch applies to the next key only
+    state.keyPressed();
+    QVERIFY(!state.isActive(Shift));
+}
+
+void TestModifierState::latchingDoubleTapLocks()
+{
+    QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+    state.setMode(Shift, QVirtualKeyboard::LatchingModifier);
+
+    state.press(Shift);
+    state.release(Shift);
+    state.press(Shift);
+    state.release(Shift);
+    QVERIFY(state.isActive(Shift));
+
+    // Locked modifiers survive key presses
+    for (int i = 0; i < 3; ++i)
+        state.keyPressed();
+    QVERIFY(state.isActive(Shift));
+    QVERIFY(state.isLocked(Shift));
+
+    // A third tap unlocks
+    state.press(Shift);
+    QVERIFY(state.isActive(Shift));
+    state.release(Shift);
+    QVERIFY(!state.isActive(Shift));
+    QVERIFY(!state.isLocked(Shift));
+}
+
+// Holding a latching modifier while typing does not latch it on release
+void TestModifierState::latchingChordedRelease()
+{
+    QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+    state.setMode(Shift, QVirtualKeyboard::LatchingModifier);
+
+    state.press(Shift);
+    state.keyPressed();
+    QVERIFY(state.isActive(Shift));
+    state.release(Shift);
+    QVERIFY(!state.isActive(Shift));
+    QVERIFY(!state.isLocked(Shift));
+
+    // The next tap latches again
+    state.press(Shift);
+    state.release(Shift);
+    QVERIFY(state.isActive(Shift));
+}
+
+void TestModifierState::locking()
+{
+    QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+    state.setMode(Shift, QVirtualKeyboard::LockingModifier);
+
+    state.press(Shift);
+    QVERIFY(state.isActive(Shift));
+    state.release(Shift);
+    QVERIFY(state.isActive(Shift));
+    QVERIFY(state.isLocked(Shift));
+    state.keyPressed();
+    QVERIFY(state.isActive(Shift));
+
+    state.press(Shift);
+    QVERIFY(!state.isActive(Shift));
+    state.release(Shift);
+    QVERIFY(!state.isActive(Shift));
+}
+
+// hold() activates a modifier independent of its mode and presses
+void TestModifierState::hold()
+{
+    QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+    state.setMode(Shift, QVirtualKeyboard::LatchingModifier);
+
+    state.hold(Shift, true);
+    QVERIFY(state.isActive(Shift));
+    QVERIFY(!state.isLocked(Shift));
+    state.keyPressed();
+    QVERIFY(state.isActive(Shift));
+
+    // Presses and releases meanwhile do not end the hold
+    state.press(Shift);
+    state.keyPressed();
+    state.release(Shift);
+    QVERIFY(state.isActive(Shift));
+
+    state.hold(Shift, true);
+    state.hold(Shift, false);
+    QVERIFY(state.isActive(Shift));
+    state.hold(Shift, false);
+    QVERIFY(!state.isActive(Shift));
+    state.hold(Shift, false);
+    state.press(Shift);
+    state.keyPressed();
+    state.release(Shift);
+    QVERIFY(!state.isActive(Shift));
+}
+
+void TestModifierState::keyPressedClearsLatches()
+{
+    QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+    state.setMode(Shift, QVirtualKeyboard::LatchingModifier);
+    state.setMode(Alt, QVirtualKeyboard::LatchingModifier);
+    const int control = state.add(Qt::Key_Control, QVirtualKeyboard::LatchingModifier);
+
+    state.press(Shift);
+    state.release(Shift);
+    state.press(Alt);
+    state.release(Alt);
+    state.press(control);
+    state.release(control);
+    QCOMPARE(state.activeMask(), 0x7u);
+
+    state.keyPressed();
+    QCOMPARE(state.activeMask(), 0u);
+}
+
+// Bit n of the mask is the modifier at index n, 'shift' and 'alt' select the layer
+void TestModifierState::activeMaskLayerBits()
+{
+    QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+    const int control = state.add(Qt::Key_Control, QVirtualKeyboard::MomentaryModifier);
+    const int fn = state.add(Qt::Key_Meta, QVirtualKeyboard::LockingModifier);
+    QCOMPARE(control, 2);
+    QCOMPARE(fn, 3);
+
+    state.press(Shift);
+    QCOMPARE(state.activeMask(), 0x1u);
+    state.press(Alt);
+    QCOMPARE(state.activeMask(), 0x3u);
+    state.release(Shift);
+    QCOMPARE(state.activeMask(), 0x2u);
+    state.press(control);
+    QCOMPARE(state.activeMask(), 0x6u);
+    state.press(fn);
+    state.release(fn);
+    QCOMPARE(state.activeMask(), 0xeu);
+    state.release(Alt);
+    state.release(control);
+    QCOMPARE(state.activeMask(), 0x8u);
+    state.reset();
+    QCOMPARE(state.activeMask(), 0u);
+}
+
+// At most MaximumModifiers fit, the state stays usable when adding more fails
+void TestModifierState::overflow()
+{
+    QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+    for (int i = 2; i < QVirtualKeyModifierState::MaximumModifiers; ++i)
+        QCOMPARE(state.add(Qt::Key(Qt::Key_F1 + i), QVirtualKeyboard::MomentaryModifier), i);
+    QCOMPARE(state.count(), int(QVirtualKeyModifierState::MaximumModifiers));
+
+    QCOMPARE(state.add(Qt::Key_Control, QVirtualKeyboard::MomentaryModifier), -1);
+    QCOMPARE(state.count(), int(QVirtualKeyModifierState::MaximumModifiers));
+    QCOMPARE(state.indexOf(Qt::Key_Control), -1);
+
+    const int last = QVirtualKeyModifierState::MaximumModifiers - 1;
+    state.press(last);
+    QCOMPARE(state.activeMask(), 1u << last);
+
+    // The press count saturates instead of wrapping around
+    for (int i = 0; i < 300; ++i)
+        state.press(Shift);
+    state.release(Shift);
+    QVERIFY(state.isActive(Shift));
+}
+
+void TestModifierState::removeModifier()
+{
+    QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+    const int control = state.add(Qt::Key_Control, QVirtualKeyboard::MomentaryModifier);
+    const int meta = state.add(Qt::Key_Meta, QVirtualKeyboard::MomentaryModifier);
+    state.press(meta);
+
+    state.remove(Shift);
+    state.remove(Alt);
+    QCOMPARE(state.count(), 4);
+
+    state.remove(control);
+    QCOMPARE(state.count(), 3);
+    QCOMPARE(state.indexOf(Qt::Key_Meta), 2);
+    QCOMPARE(state.activeMask(), 0x4u);
+}
+
+void TestModifierState::setModeDropsLatch()
+{
+    QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+    state.setMode(Shift, QVirtualKeyboard::LockingModifier);
+    state.press(Shift);
+    state.release(Shift);
+    QVERIFY(state.isActive(Shift));
+    state.setMode(Shift, QVirtualKeyboard::MomentaryModifier);
+    QVERIFY(!state.isActive(Shift));
+}
+
+void TestModifierState::saveAndLoad()
+{
+    QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+    state.setMode(Alt, QVirtualKeyboard::LatchingModifier);
+    const int control = state.add(Qt::Key_Control, QVirtualKeyboard::LockingModifier);
+    state.press(Shift);
+    state.press(Alt);
+    state.release(Alt);
+    state.press(control);
+    state.hold(Shift, true);
+
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        state.save(out);
+    }
+
+    QVirtualKeyModifierState loaded(Qt::Key_CapsLock, Qt::Key_Alt);
+    QDataStream in(data);
+    QVERIFY(loaded.load(in));
+    QCOMPARE(loaded.count(), state.count());
+    for (int i = 0; i < state.count(); ++i) {
+        QCOMPARE(loaded.key(i), state.key(i));
+        QCOMPARE(loaded.mode(i), state.mode(i));
+        QCOMPARE(loaded.isLocked(i), state.isLocked(i));
+    }
+    QCOMPARE(loaded.activeMask(), state.activeMask());
+
+    // Press and hold counts are restored as well
+    loaded.release(Shift);
+    QVERIFY(loaded.isActive(Shift));
+    loaded.hold(Shift, false);
+    QVERIFY(!loaded.isActive(Shift));
+    loaded.keyPressed();
+    QVERIFY(!loaded.isActive(Alt));
+    QVERIFY(loaded.isActive(control));
+}
+
+// Invalid data leaves the state unchanged
+void TestModifierState::loadInvalid()
+{
+    QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+    state.press(Shift);
+
+    QByteArray tooMany;
+    {
+        QDataStream out(&tooMany, QIODevice::WriteOnly);
+        out << quint8(QVirtualKeyModifierState::MaximumModifiers + 1);
+    }
+    QDataStream tooManyIn(tooMany);
+    QVERIFY(!state.load(tooManyIn));
+
+    QByteArray truncated;
+    {
+        QDataStream out(&truncated, QIODevice::WriteOnly);
+        state.save(out);
+    }
+    truncated.chop(3);
+    QDataStream truncatedIn(truncated);
+    QVERIFY(!state.load(truncatedIn));
+
+    QCOMPARE(state.count(), 2);
+    QCOMPARE(state.key(Shift), Qt::Key_Shift);
+    QCOMPARE(state.activeMask(), 0x1u);
+}
+
+void TestModifierState::exhaustiveSequences_data()
+{
+    QTest::addColumn<QVirtualKeyboard::ModifierMode>("mode");
+
+    QTest::newRow("momentary") << QVirtualKeyboard::MomentaryModifier;
+    QTest::newRow("latching") << QVirtualKeyboard::LatchingModifier;
+    QTest::newRow("locking") << QVirtualKeyboard::LockingModifier;
+}
+
+// Every possible sequence of up to 10 presses and releases of the modifier and
+// presses of other keys, compared with the state table after every step
+void TestModifierState::exhaustiveSequences()
+{
+    QFETCH(QVirtualKeyboard::ModifierMode, mode);
+
+    const ModifierRow *table = momentaryTable;
+    if (mode == QVirtualKeyboard::LatchingModifier)
+        table = latchingTable;
+    else if (mode == QVirtualKeyboard::LockingModifier)
+        table = lockingTable;
+
+    enum { Steps = 10, Events = 3 };
+    static const char eventNames[] = "PRK";
+
+    // Depth first over the event sequences, actions[i] is the event of step i
+    int actions[Steps];
+    int depth = 0;
+    actions[0] = -1;
+    int sequences = 0;
+    while (depth >= 0) {
+        if (++actions[depth] == Events) {
+            --depth;
+            continue;
+        }
+
+        // Replay the sequence up to this step on a new state and the table
+        QVirtualKeyModifierState state(Qt::Key_Shift, Qt::Key_AltGr);
+        state.setMode(Shift, mode);
+        int row = 0;
+        QString steps;
+        bool possible = true;
+        for (int step = 0; step <= depth && possible; ++step) {
+            const ModifierRow &current = table[row];
+            switch (actions[step]) {
+                case 0:
+                    row = current.press;
+                    state.press(Shift);
+                    break;
+                case 1:
+                    row = current.release;
+                    state.release(Shift);
+                    break;
+                default:
+                    row = current.otherKey;
+                    state.keyPressed();
+                    break;
+            }
+            steps += QLatin1Char(eventNames[actions[step]]);
+            possible = row >= 0;
+        }
+        if (!possible)
+            continue;
+
+        ++sequences;
+        if (state.isActive(Shift) != table[row].active || state.isLocked(Shift) != table[row].locked)
+            QFAIL(qPrintable(QString("Sequence %1: active %2, locked %3, expected %4, %5")
+                             .arg(steps).arg(state.isActive(Shift)).arg(state.isLocked(Shift))
+                             .arg(table[row].active).arg(table[row].locked)));
+        QCOMPARE(state.activeMask(), table[row].active ? 0x1u : 0u);
+
+        if (depth + 1 < Steps)
+            actions[++depth] = -1;
+    }
+    QVERIFY(sequences > Steps);
+}
+
+QTEST_APPLESS_MAIN(TestModifierState)
+
+#include "tst_modifierstate.moc"
@@ -0,0 +1,20 @@
+build_qtopia {
+    qtopia_project(stub)
+} else {
+    message(Build soak test for Qt or Qt/Embedded)
+    TEMPLATE     = app
+    TARGET       = tst_soak
+    CONFIG      += console release
+    CONFIG      -= app_bundle
+    QT          += testlib
+    greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+    INCLUDEPATH += ../../src/library
+    LIBS        += -L../../src/library -lqtvirtualkeyboard
+
+    SOURCES     += tst_soak.cpp
+
+    # "make check" runs the test
+    check.commands = ./$$TARGET
+    QMAKE_EXTRA_TARGETS += check
+}
@@ -0,0 +1,164 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QApplication>
+#include <QFile>
+#include <QKeyEvent>
+#include <QMouseEvent>
+
+#include "qvirtualkeyboard.h"
+#include "qvirtualkey.h"
+
+#include <unistd.h>
+
+#if QT_VERSION >= 0x050000
+#  define SOAK_SKIP(message) QSKIP(message)
+#else
+#  define SOAK_SKIP(message) QSKIP(message, SkipAll)
+#endif
+
+static const int soakPresses = 1000000;
+
+// Resident memory of the process in bytes, -1 if it is unknown
+static qint64 residentMemory()
+{
+    QFile file("/proc/self/statm");
+    if (!file.open(QFile::ReadOnly))
+        return -1;
+    const QList<QByteArray> fields = file.readAll().simplified().split(' ');
+    bool ok = false;
+    const qint64 pages = fields.value(1).toLongLong(&ok);
+    return ok ? pages * sysconf(_SC_PAGESIZE) : -1;
+}
+
+class TestSoak : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestSoak();
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void memoryStaysFlat_data();
+    void memoryStaysFlat();
+
+    void countKeyEvent(QKeyEvent *event);
+
+private:
+    void pressKeys(int presses);
+
+    QVirtualKeyboard keyboard;
+    QWidget *container;
+    QList<QVirtualKey *> keys;
+    int keyEvents;
+};
+
+TestSoak::TestSoak()
+    : container(0)
+    , keyEvents(0)
+{
+}
+
+void TestSoak::countKeyEvent(QKeyEvent *)
+{
+    ++keyEvents;
+}
+
+// Letters, a held shift and a dead key, so every branch of the event generation runs
+void TestSoak::initTestCase()
+{
+    container = new QWidget;
+    for (int i = 0; i < 26; ++i) {
+        QVirtualKey *vk = new QVirtualKey(container, Qt::Key(Qt::Key_A + i), QString(QChar('a' + i)));
+        vk->setObjectName(QString("soak_%1").arg(QChar('a' + i)));
+        vk->resize(20, 20);
+        keys.append(vk);
+    }
+    QVirtualKey *shift = new QVirtualKey(container, Qt::Key_Shift, "Shift");
+    shift->resize(20, 20);
+    keys.append(shift);
+    QVirtualKey *dead = new QVirtualKey(container, Qt::Key_Dead_Acute, QString(QChar(0x00b4)));
+    dead->resize(20, 20);
+    keys.append(dead);
+
+    QVERIFY(keyboard.addKeyContainer(container));
+    connect(&keyboard, SIGNAL(keyEvent(QKeyEvent *)), this, SLOT(countKeyEvent(QKeyEvent *)));
+}
+
+void TestSoak::cleanupTestCase()
+{
+    delete container;
+}
+
+// Presses and releases the keys in turn, the presses and releases reach
+// virtualKeyPressed() and virtualKeyReleased() through the event filter
+void TestSoak::pressKeys(int presses)
+{
+    QMouseEvent press(QEvent::MouseButtonPress, QPoint(5, 5), Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    QMouseEvent release(QEvent::MouseButtonRelease, QPoint(5, 5), Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+    for (int i = 0; i < presses; ++i) {
+        QVirtualKey *vk = keys.at(i % keys.count());
+        QCoreApplication::sendEvent(vk, &press);
+        QCoreApplication::sendEvent(vk, &release);
+    }
+}
+
+void TestSoak::memoryStaysFlat_data()
+{
+    QTest::addColumn<int>("dispatchMode");
+
+    QTest::newRow("event filter") << int(QVirtualKeyboard::EventFilterDispatch);
+    QTest::newRow("direct") << int(QVirtualKeyboard::DirectDispatch);
+}
+
+// A million presses must not grow the resident memory, a leaked key event per
+// press and release would add far more than the allowed slack
+void TestSoak::memoryStaysFlat()
+{
+    QFETCH(int, dispatchMode);
+
+    if (residentMemory() < 0)
+        SOAK_SKIP("The resident memory of the process is unknown on this platform");
+
+    keyboard.setDispatchMode(QVirtualKeyboard::DispatchMode(dispatchMode));
+
+    // Warm up caches, key tables and the allocator before the baseline
+    pressKeys(10000);
+    const qint64 before = residentMemory();
+
+    keyEvents = 0;
+    pressKeys(soakPresses);
+    const qint64 after = residentMemory();
+
+    QCOMPARE(keyEvents, 2 * soakPresses);
+    QVERIFY2(after - before < 4 * 1024 * 1024,
+             qPrintable(QString("Resident memory grew by %1 bytes").arg(after - before)));
+}
+
+int main(int argc, char *argv[])
+{
+#if QT_VERSION >= 0x050000
+    // Run without a display unless a platform is requested explicitly
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+#endif
+    QApplication app(argc, argv);
+    TestSoak test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_soak.moc"
@@ -0,0 +1,13 @@
+build_qtopia {
+    message(Build tests for Qtopia)
+    qtopia_project(subdirs)
+} else {
+    message(Build tests for Qt or Qt/Embedded)
+    TEMPLATE = subdirs
+}
+
+SUBDIRS  = keyboard
+SUBDIRS += layout
+SUBDIRS += modifierstate
+SUBDIRS += soak
+SUBDIRS += touch
@@ -0,0 +1,276 @@
+/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QApplication>
+#include <QDir>
+#include <QKeyEvent>
+#include <QMap>
+#include <QSignalSpy>
+#include <QTouchEvent>
+
+#include "qvirtualkeyboard.h"
+#include "qvirtualkey.h"
+#include "qvirtualkeyrecorder.h"
+
+/*
+    Touch traces are written as steps separated by spaces, each step changes one
+    finger: "0+a" touches key a with finger 0, "0>b" moves it onto key b and
+    "0-" lifts it. The keys are a, b, c and the momentary shift key s.
+*/
+class TestTouch : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void keySequence_data();
+    void keySequence();
+    void buttonSignals();
+    void checkableKey();
+
+    void recordKeyEvent(QKeyEvent *event);
+
+private:
+    void touch(const QString &step);
+    QVirtualKey *addKey(const QString &name, Qt::Key key);
+    static QString describe(bool pressed, int key);
+
+    QDir dir;
+    QVirtualKeyboard *keyboard;
+    QVirtualKeyRecorder *recorder;
+    QWidget *container;
+    QMap<QString, QVirtualKey *> keys; ///< Keys by their letter in the traces
+    QMap<int, QPointF> touching; ///< Positions of the fingers on the container
+    QStringList keyEvents; ///< Key events generated by the touches
+};
+
+void TestTouch::initTestCase()
+{
+    const QString path = QString("tst_touch_%1").arg(QCoreApplication::applicationPid());
+    QVERIFY(QDir::temp().mkpath(path));
+    dir = QDir(QDir::temp().filePath(path));
+}
+
+void TestTouch::cleanupTestCase()
+{
+    foreach (const QString &fileName, dir.entryList(QDir::Files))
+        dir.remove(fileName);
+    QDir::temp().rmdir(dir.dirName());
+}
+
+// Every test gets a new keyboard with a row of four keys and a recorder
+void TestTouch::init()
+{
+    keyboard = new QVirtualKeyboard;
+    recorder = new QVirtualKeyRecorder;
+    container = new QWidget;
+    container->resize(200, 40);
+    keys.clear();
+    touching.clear();
+    keyEvents.clear();
+    keys.insert("a", addKey("key_a", Qt::Key_A));
+    keys.insert("b", addKey("key_b", Qt::Key_B));
+    keys.insert("c", addKey("key_c", Qt::Key_C));
+    keys.insert("s", addKey("key_shift", Qt::Key_Shift));
+    QVERIFY(keyboard->addKeyContainer(container));
+    recorder->setKeyboard(keyboard);
+    connect(keyboard, SIGNAL(keyEvent(QKeyEvent *)), this, SLOT(recordKeyEvent(QKeyEvent *)));
+}
+
+void TestTouch::cleanup()
+{
+    delete recorder;
+    delete keyboard;
+    delete container;
+}
+
+void TestTouch::recordKeyEvent(QKeyEvent *event)
+{
+    keyEvents.append(describe(event->type() == QEvent::KeyPress, event->key()));
+}
+
+// Adds a 40x40 key called \a name generating \a key next to the previous keys
+QVirtualKey *TestTouch::addKey(const QString &name, Qt::Key key)
+{
+    QVirtualKey *vk = new QVirtualKey(container, key);
+    vk->setObjectName(name);
+    vk->setGeometry(50 * keys.count(), 0, 40, 40);
+    return vk;
+}
+
+QString TestTouch::describe(bool pressed, int key)
+{
+    return QString("%1 %2").arg(pressed ? "press" : "release", QVirtualKeyboard::keyToString(Qt::Key(key)));
+}
+
+// Sends the touch event of one trace \a step to the container, listing all
+// touching fingers with only the finger of the step changing its state
+void TestTouch::touch(const QString &step)
+{
+    const int id = step.left(1).toInt();
+    const QChar action = step.at(1);
+    if (action != QLatin1Char('-'))
+        touching.insert(id, keys.value(step.mid(2))->geometry().center());
+
+    QList<QTouchEvent::TouchPoint> points;
+    Qt::TouchPointStates states = 0;
+    for (QMap<int, QPointF>::const_iterator it = touching.constBegin(); it != touching.constEnd(); ++it) {
+        QTouchEvent::TouchPoint point(it.key());
+        Qt::TouchPointState state = Qt::TouchPointStationary;
+        if (it.key() == id) {
+            if (action == QLatin1Char('+'))
+                state = Qt::TouchPointPressed;
+            else if (action == QLatin1Char('>'))
+                state = Qt::TouchPointMoved;
+            else
+                state = Qt::TouchPointReleased;
+        }
+        point.setState(state);
+        point.setPos(it.value());
+        points.append(point);
+        states |= state;
+    }
+
+    QEvent::Type type = QEvent::TouchUpdate;
+    if (action == QLatin1Char('+') && touching.count() == 1)
+        type = QEvent::TouchBegin;
+    else if (action == QLatin1Char('-') && touching.count() == 1)
+        type = QEvent::TouchEnd;
+    if (action == QLatin1Char('-'))
+        touching.remove(id);
+
+#if QT_VERSION >= 0x050000
+    QTouchEvent event(type, 0, Qt::NoModifier, states, points);
+#else
+    QTouchEvent event(type, QTouchEvent::TouchScreen, Qt::NoModifier, states, points);
+#endif
+    QApplication::sendEvent(container, &event);
+}
+
+void TestTouch::keySequence_data()
+{
+    QTest::addColumn<QString>("trace");
+    QTest::addColumn<QStringList>("expected");
+
+    QTest::newRow("one finger") << "0+a 0-"
+        << (QStringList() << "press Key_A" << "release Key_A");
+    QTest::newRow("rollover") << "0+a 1+b 0- 1-"
+        << (QStringList() << "press Key_A" << "press Key_B" << "release Key_A" << "release Key_B");
+    QTest::newRow("nested") << "0+a 1+b 1- 0-"
+        << (QStringList() << "press Key_A" << "press Key_B" << "release Key_B" << "release Key_A");
+    QTest::newRow("three fingers") << "0+a 1+b 2+c 1- 0- 2-"
+        << (QStringList() << "press Key_A" << "press Key_B" << "press Key_C"
+                          << "release Key_B" << "release Key_A" << "release Key_C");
+    QTest::newRow("moved off the key") << "0+a 0>b 0-"
+        << (QStringList() << "press Key_A" << "release Key_A");
+    QTest::newRow("held shift") << "0+s 1+a 1- 1+b 1- 0-"
+        << (QStringList() << "press Key_Shift" << "press Key_A" << "release Key_A"
+                          << "press Key_B" << "release Key_B" << "release Key_Shift");
+    QTest::newRow("finger ids reused") << "0+a 1+b 0- 0+c 1- 0-"
+        << (QStringList() << "press Key_A" << "press Key_B" << "release Key_A"
+                          << "press Key_C" << "release Key_B" << "release Key_C");
+}
+
+// Multi-finger traces generate the key events in the order of the touches, and
+// replaying their recording generates the same key events again
+void TestTouch::keySequence()
+{
+    QFETCH(QString, trace);
+    QFETCH(QStringList, expected);
+
+    const QString logFile = dir.filePath("trace.qvkr");
+    QVERIFY(recorder->startRecording(logFile));
+    foreach (const QString &step, trace.split(QLatin1Char(' ')))
+        touch(step);
+    recorder->stopRecording();
+
+    QCOMPARE(keyEvents, expected);
+    QVERIFY(!keyboard->isTouching());
+    QCOMPARE(keyboard->keyboardModifiers(), Qt::KeyboardModifiers(Qt::NoModifier));
+    QCOMPARE(recorder->recordedKeys(), expected.count());
+
+    keyEvents.clear();
+    QString errorString;
+    QVERIFY2(recorder->replay(logFile, QVirtualKeyRecorder::MaximumSpeedReplay, &errorString), qPrintable(errorString));
+    QCOMPARE(keyEvents, expected);
+
+    QStringList replayed;
+    foreach (const QString &line, recorder->replayedEvents())
+        replayed.append(line.section(QLatin1Char(' '), 0, 1));
+    QCOMPARE(replayed, expected);
+}
+
+// A key emits pressed() when the first finger touches it and released() and
+// clicked() when the last finger is lifted
+void TestTouch::buttonSignals()
+{
+    QVirtualKey *keyA = keys.value("a");
+    QSignalSpy pressed(keyA, SIGNAL(pressed()));
+    QSignalSpy released(keyA, SIGNAL(released()));
+    QSignalSpy clicked(keyA, SIGNAL(clicked()));
+
+    touch("0+a");
+    QCOMPARE(pressed.count(), 1);
+    QCOMPARE(released.count(), 0);
+    QVERIFY(keyA->isDown());
+
+    touch("1+a");
+    QCOMPARE(pressed.count(), 1);
+
+    touch("0-");
+    QCOMPARE(released.count(), 0);
+    QCOMPARE(clicked.count(), 0);
+    QVERIFY(keyA->isDown());
+
+    touch("1-");
+    QCOMPARE(pressed.count(), 1);
+    QCOMPARE(released.count(), 1);
+    QCOMPARE(clicked.count(), 1);
+    QVERIFY(!keyA->isDown());
+}
+
+// Checkable keys toggle once per touch, when the finger is lifted
+void TestTouch::checkableKey()
+{
+    QVirtualKey *shiftKey = keys.value("s");
+    shiftKey->setCheckable(true);
+    QSignalSpy toggled(shiftKey, SIGNAL(toggled(bool)));
+
+    touch("0+s");
+    QVERIFY(!shiftKey->isChecked());
+    touch("0-");
+    QVERIFY(shiftKey->isChecked());
+    touch("0+s");
+    touch("0-");
+    QVERIFY(!shiftKey->isChecked());
+    QCOMPARE(toggled.count(), 2);
+}
+
+int main(int argc, char *argv[])
+{
+#if QT_VERSION >= 0x050000
+    // Run without a display unless a platform is requested explicitly
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+#endif
+    QApplication app(argc, argv);
+    TestTouch test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_touch.moc"
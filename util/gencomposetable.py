@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+#
+# Generates src/library/qvirtualkeycomposetable_p.h, the built-in dead key
+# composition table used by QVirtualKeyComposer.
+#
+# Every character of the Basic Multilingual Plane is combined with the combining
+# mark of each dead key Qt knows about. If the canonical composition yields a
+# single character, the (dead key, base, result) triple becomes a table entry.
+#
+# Usage: python3 util/gencomposetable.py > src/library/qvirtualkeycomposetable_p.h
+
+import sys
+import unicodedata
+
+# In the order of Qt::Key_Dead_Grave (0x01001250) to Qt::Key_Dead_Horn (0x01001262)
+DEAD_KEYS = [
+    ('Grave', 0x0300), ('Acute', 0x0301), ('Circumflex', 0x0302), ('Tilde', 0x0303),
+    ('Macron', 0x0304), ('Breve', 0x0306), ('Abovedot', 0x0307), ('Diaeresis', 0x0308),
+    ('Abovering', 0x030A), ('Doubleacute', 0x030B), ('Caron', 0x030C), ('Cedilla', 0x0327),
+    ('Ogonek', 0x0328), ('Iota', 0x0345), ('Voiced_Sound', 0x3099),
+    ('Semivoiced_Sound', 0x309A), ('Belowdot', 0x0323), ('Hook', 0x0309), ('Horn', 0x031B),
+]
+
+HEADER = """/****************************************************************************
+  **
+  ** Copyright (C) 1992-$THISYEAR$ $TROLLTECH$. All rights reserved.
+  **
+  ** This file is part of the $MODULE$ of the Qt Toolkit.
+  **
+  ** $TROLLTECH_DUAL_LICENSE$
+  **
+  ** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+  ** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+  **
+  ****************************************************************************/
+
+// This file is generated by util/gencomposetable.py from Unicode %s data, do not edit.
+
+#ifndef QVIRTUALKEYCOMPOSETABLE_P_H
+#define QVIRTUALKEYCOMPOSETABLE_P_H
+
+#include <QtGlobal>
+
+struct QVirtualKeyComposeEntry
+{
+    quint16 deadKey; ///< Offset of the dead key from Qt::Key_Dead_Grave
+    quint16 base;
+    quint16 result;
+};
+
+// Sorted by dead key and base character
+static const QVirtualKeyComposeEntry qvirtualkeyComposeTable[] = {
+"""
+
+FOOTER = """};
+
+static const int qvirtualkeyComposeTableSize = sizeof(qvirtualkeyComposeTable) / sizeof(QVirtualKeyComposeEntry);
+
+// Spacing characters of the dead keys, in the same order
+static const quint16 qvirtualkeySpacingTable[] = {
+%s
+};
+
+#endif
+"""
+
+# Spacing (undead) representation of each dead key. Unicode has no spacing forms
+# of the dot below, the hook above and the horn, the nearest spacing characters
+# are used instead: full stop, modifier letter glottal stop and modifier letter
+# apostrophe.
+SPACING = [0x0060, 0x00B4, 0x005E, 0x007E, 0x00AF, 0x02D8, 0x02D9, 0x00A8, 0x02DA, 0x02DD,
+           0x02C7, 0x00B8, 0x02DB, 0x037A, 0x309B, 0x309C, 0x002E, 0x02C0, 0x02BC]
+
+# The spacing representation must not be a combining mark
+assert not any(unicodedata.combining(chr(c)) for c in SPACING)
+
+
+def main():
+    out = sys.stdout
+    out.write(HEADER % unicodedata.unidata_version)
+    for index, (name, mark) in enumerate(DEAD_KEYS):
+        out.write('    // Qt::Key_Dead_%s\n' % name)
+        for base in range(0x20, 0x10000):
+            if 0xD800 <= base < 0xE000:
+                continue
+            composed = unicodedata.normalize('NFC', chr(base) + chr(mark))
+            if len(composed) == 1 and ord(composed) < 0x10000:
+                out.write('    { %2d, 0x%04x, 0x%04x },\n' % (index, base, ord(composed)))
+    spacing = ',\n'.join('    0x%04x' % c for c in SPACING)
+    out.write(FOOTER % spacing)
+
+
+if __name__ == '__main__':
+    main()
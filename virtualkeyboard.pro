@@ -6,4 +6,8 @@ build_qtopia {
     TEMPLATE = subdirs
 }
 
-SUBDIRS = src
+CONFIG += ordered
+
+SUBDIRS  = src
+SUBDIRS += benchmarks
+SUBDIRS += tests